@@ -0,0 +1,85 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_BENCH_H__
+#define __HD108_BENCH_H__
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+
+/**
+ * @brief Keeps the results of a benchmark loop alive.
+ */
+extern volatile uint32_t bench_sink;
+
+
+/**
+ * @brief Monotonic time.
+ *
+ * @return
+ *         - The time in nanoseconds.
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief Print one result line.
+ *
+ * @param name Name of the benchmark.
+ * @param ns Elapsed time in nanoseconds.
+ * @param items Number of items processed in that time.
+ * @param unit Name of an item, e.g. "value" or "LED".
+ */
+static inline void bench_report(const char *name, uint64_t ns, uint64_t items, const char *unit) {
+    double per_item = (double)ns / (double)items;
+    printf("%-32s %10.2f ns/%-6s %10.2f M%s/s\n", name, per_item, unit, 1000.0 / per_item, unit);
+}
+
+
+/**
+ * @brief Run a statement repeatedly and report the time per item.
+ */
+#define BENCH_RUN(name, repeat, items, unit, statement)                         \
+    do {                                                                        \
+        uint64_t bench_start = bench_now_ns();                                  \
+        for (uint32_t bench_i = 0; bench_i < (repeat); bench_i++) {             \
+            statement;                                                          \
+        }                                                                       \
+        bench_report((name), bench_now_ns() - bench_start,                      \
+                     (uint64_t)(repeat) * (items), (unit));                     \
+    } while (0)
+
+#endif /* __HD108_BENCH_H__ */
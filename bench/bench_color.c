@@ -0,0 +1,190 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_color.h"
+#include "bench.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define BENCH_COUNT                 (    1024UL)    ///< color values per array, one plane of the longest strip
+#define BENCH_REPEAT                (   20000UL)    ///< passes over the arrays
+#define BENCH_NOISE_COUNT           (  100000UL)    ///< noise values per pass
+
+
+volatile uint32_t bench_sink;
+
+
+/******************************************************************************
+ * Naive C, the ad-hoc math of the effects
+ *****************************************************************************/
+static __attribute__((noinline)) void naive_qadd(hd108_color_t *dst, const hd108_color_t *src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t sum = dst[i] + src[i];
+        dst[i] = (sum > 65535) ? 65535 : sum;
+    }
+}
+
+static __attribute__((noinline)) void naive_scale(hd108_color_t *dst, const hd108_color_t *src, size_t count, uint16_t scale) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (hd108_color_t)((uint32_t)src[i] * scale / 65535);
+    }
+}
+
+static __attribute__((noinline)) void naive_lerp(hd108_color_t *dst, const hd108_color_t *a, const hd108_color_t *b, size_t count, uint16_t frac) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (hd108_color_t)(a[i] + ((int32_t)b[i] - a[i]) * frac / 65536);
+    }
+}
+
+static __attribute__((noinline)) int16_t naive_sin(uint16_t theta) {
+    return (int16_t)(32767.0f * sinf((float)theta * (float)(2.0 * M_PI / 65536.0)));
+}
+
+static const int naive_grad2[8][2] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+static uint16_t naive_hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dUL;
+    x ^= x >> 15;
+    x *= 0x846ca68bUL;
+    x ^= x >> 16;
+    return (uint16_t)x;
+}
+
+static float naive_corner(uint16_t hash, float x, float y) {
+    float t = 0.5f - x * x - y * y;
+    if (t <= 0.0f) {
+        return 0.0f;
+    }
+    t *= t;
+    return t * t * (naive_grad2[hash & 7U][0] * x + naive_grad2[hash & 7U][1] * y);
+}
+
+static __attribute__((noinline)) float naive_simplex(float x, float y) {
+    const float f2 = 0.36602540378f;
+    const float g2 = 0.21132486540f;
+    float s = (x + y) * f2;
+    float i = floorf(x + s);
+    float j = floorf(y + s);
+    float t = (i + j) * g2;
+    float x0 = x - (i - t);
+    float y0 = y - (j - t);
+    uint32_t i1 = (x0 > y0) ? 1 : 0;
+    uint32_t j1 = 1 - i1;
+    uint32_t ii = (uint32_t)i;
+    uint32_t jj = (uint32_t)j;
+
+    float n = naive_corner(naive_hash(ii ^ (jj * 0x9e3779b1UL)), x0, y0);
+    n += naive_corner(naive_hash((ii + i1) ^ ((jj + j1) * 0x9e3779b1UL)), x0 - i1 + g2, y0 - j1 + g2);
+    n += naive_corner(naive_hash((ii + 1) ^ ((jj + 1) * 0x9e3779b1UL)), x0 - 1.0f + 2.0f * g2, y0 - 1.0f + 2.0f * g2);
+    return 70.0f * n;
+}
+
+
+/******************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+int main(void) {
+    static hd108_color_t a[BENCH_COUNT] __attribute__((aligned(16)));
+    static hd108_color_t b[BENCH_COUNT] __attribute__((aligned(16)));
+    static hd108_color_t dst[BENCH_COUNT] __attribute__((aligned(16)));
+    static hd108_color_t ref[BENCH_COUNT] __attribute__((aligned(16)));
+    static uint16_t theta[BENCH_COUNT];
+    static int16_t sine[BENCH_COUNT];
+    int max_error;
+
+    srand(1);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        a[i] = (hd108_color_t)rand();
+        b[i] = (hd108_color_t)rand();
+        theta[i] = (uint16_t)rand();
+    }
+
+    printf("color kernels, %lu values per array\n", (unsigned long)BENCH_COUNT);
+
+    BENCH_RUN("qadd16 naive", BENCH_REPEAT, BENCH_COUNT, "value", naive_qadd(dst, b, BENCH_COUNT));
+    BENCH_RUN("qadd16_array", BENCH_REPEAT, BENCH_COUNT, "value", hd108_color_qadd16_array(dst, b, BENCH_COUNT));
+    memcpy(dst, a, sizeof(dst));
+    memcpy(ref, a, sizeof(ref));
+    naive_qadd(ref, b, BENCH_COUNT);
+    hd108_color_qadd16_array(dst, b, BENCH_COUNT);
+    printf("  qadd16_array matches naive: %s\n", memcmp(dst, ref, sizeof(dst)) ? "no" : "yes");
+
+    BENCH_RUN("scale16 naive", BENCH_REPEAT, BENCH_COUNT, "value", naive_scale(dst, a, BENCH_COUNT, (uint16_t)(40000 + bench_i)));
+    BENCH_RUN("scale16_array", BENCH_REPEAT, BENCH_COUNT, "value", hd108_color_scale16_array(dst, a, BENCH_COUNT, (uint16_t)(40000 + bench_i)));
+    naive_scale(ref, a, BENCH_COUNT, 40000);
+    hd108_color_scale16_array(dst, a, BENCH_COUNT, 40000);
+    max_error = 0;
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        max_error = (abs(dst[i] - ref[i]) > max_error) ? abs(dst[i] - ref[i]) : max_error;
+    }
+    printf("  scale16_array max difference to naive: %d LSB\n", max_error);
+
+    BENCH_RUN("lerp16 naive", BENCH_REPEAT, BENCH_COUNT, "value", naive_lerp(dst, a, b, BENCH_COUNT, (uint16_t)bench_i));
+    BENCH_RUN("lerp16_array", BENCH_REPEAT, BENCH_COUNT, "value", hd108_color_lerp16_array(dst, a, b, BENCH_COUNT, (uint16_t)bench_i));
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        ref[i] = hd108_color_lerp16(a[i], b[i], 40000);
+    }
+    hd108_color_lerp16_array(dst, a, b, BENCH_COUNT, 40000);
+    printf("  lerp16_array matches lerp16: %s\n", memcmp(dst, ref, sizeof(dst)) ? "no" : "yes");
+
+    BENCH_RUN("sin naive (sinf)", BENCH_REPEAT, BENCH_COUNT, "value",
+              for (size_t i = 0; i < BENCH_COUNT; i++) { sine[i] = naive_sin(theta[i]); } bench_sink += (uint16_t)sine[bench_i % BENCH_COUNT]);
+    BENCH_RUN("sin16_array", BENCH_REPEAT, BENCH_COUNT, "value", hd108_sin16_array(sine, theta, BENCH_COUNT); bench_sink += (uint16_t)sine[bench_i % BENCH_COUNT]);
+    max_error = 0;
+    for (uint32_t t = 0; t < 65536; t++) {
+        int error = abs(hd108_sin16((uint16_t)t) - (int)lround(32767.0 * sin(t * 2.0 * M_PI / 65536.0)));
+        max_error = (error > max_error) ? error : max_error;
+    }
+    printf("  sin16 max error to sin(): %d LSB\n", max_error);
+
+    BENCH_RUN("simplex 2D naive (float)", 1, BENCH_NOISE_COUNT, "value",
+              for (uint32_t i = 0; i < BENCH_NOISE_COUNT; i++) { bench_sink += (uint32_t)(naive_simplex(i * 0.013f, 7.5f) * 1000.0f); });
+    BENCH_RUN("simplex16_2d", 1, BENCH_NOISE_COUNT, "value",
+              for (uint32_t i = 0; i < BENCH_NOISE_COUNT; i++) { bench_sink += hd108_simplex16_2d(i * 852U, 7U << 15); });
+    BENCH_RUN("simplex16_3d", 1, BENCH_NOISE_COUNT, "value",
+              for (uint32_t i = 0; i < BENCH_NOISE_COUNT; i++) { bench_sink += hd108_simplex16_3d(i * 852U, 7U << 15, 3U << 16); });
+    BENCH_RUN("noise16_2d (value)", 1, BENCH_NOISE_COUNT, "value",
+              for (uint32_t i = 0; i < BENCH_NOISE_COUNT; i++) { bench_sink += hd108_noise16_2d(i * 852U, 7U << 15); });
+    max_error = 0;
+    for (uint32_t i = 0; i < BENCH_NOISE_COUNT; i++) {
+        int error = abs((int)hd108_simplex16_2d(i * 852U, 7U << 15) - 32768 - (int)lroundf(naive_simplex(i * 852U / 65536.0f, 3.5f) * 32767.0f));
+        max_error = (error > max_error) ? error : max_error;
+    }
+    printf("  simplex16_2d max difference to float: %d LSB\n", max_error);
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_lld.h"
+#include "bench.h"
+#include "port.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define BENCH_COUNT                 (    1000UL)    ///< LEDs, the last bounce chunk is partial
+#define BENCH_REPEAT                (    5000UL)    ///< transferred frames
+#define BENCH_CURRENT               HD108_LLD_CURRENT(31, 31, 31)
+#define BENCH_BUS_SIZE              (HD108_LLD_FRAME_SIZE(BENCH_COUNT) + 64UL)  ///< captured bytes, the frame and the 0 bytes
+
+
+volatile uint32_t bench_sink;
+
+
+/******************************************************************************
+ * Frame content
+ *****************************************************************************/
+static uint8_t bench_rgb888[3 * BENCH_COUNT];
+static void *bench_compact;
+
+
+static void bench_update_compact(void) {
+    (void)hd108_lld_write_rgb888(bench_compact, 0, BENCH_COUNT, bench_rgb888, BENCH_CURRENT);
+}
+
+
+/**
+ * @brief Capture the bytes of one update on the bus.
+ *
+ * @param ctx The address of the context.
+ * @param dst Destination, BENCH_BUS_SIZE bytes.
+ *
+ * @return
+ *         - The number of bytes captured.
+ */
+static size_t bench_capture(void *ctx, uint8_t *dst) {
+    hd108_port_set_spi_capture(dst, BENCH_BUS_SIZE);
+    (void)hd108_lld_update(ctx);
+    size_t length = hd108_port_get_spi_capture();
+    hd108_port_set_spi_capture(NULL, 0);
+    return length;
+}
+
+
+/******************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+int main(void) {
+    static uint8_t frame[BENCH_BUS_SIZE];
+    static uint8_t ref[BENCH_BUS_SIZE];
+    void *pixel;
+
+    // the reference is the pixel layout written with the same bulk writer
+    const hd108_configuration_t pixel_configuration = {
+        .spi_host = SPI2_HOST,
+        .spi_speed_hz = HD108_LLD_MAX_SPI_SPEED,
+        .count = BENCH_COUNT,
+        .frequency_hz = HD108_LLD_UPDATE_30HZ,
+        .live_write = true,
+        .external_update = true,
+    };
+    const hd108_configuration_t compact_configuration = {
+        .spi_host = SPI3_HOST,
+        .spi_speed_hz = HD108_LLD_MAX_SPI_SPEED,
+        .count = BENCH_COUNT,
+        .frequency_hz = HD108_LLD_UPDATE_30HZ,
+        .update_function = bench_update_compact,
+        .layout = HD108_LLD_LAYOUT_COMPACT,
+        .compact_current = BENCH_CURRENT,
+        .external_update = true,
+    };
+    if ((HD108_LLD_OK != hd108_lld_init(&pixel_configuration, &pixel)) ||
+        (HD108_LLD_OK != hd108_lld_init(&compact_configuration, &bench_compact))) {
+        printf("hd108_lld_init failed\n");
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < 3 * BENCH_COUNT; i++) {
+        bench_rgb888[i] = (uint8_t)rand();
+    }
+    (void)hd108_lld_write_rgb888(pixel, 0, BENCH_COUNT, bench_rgb888, BENCH_CURRENT);
+
+    printf("compact layout, %lu LEDs per frame\n", (unsigned long)BENCH_COUNT);
+
+    BENCH_RUN("pixel update", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_update(pixel));
+    BENCH_RUN("compact update", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_update(bench_compact));
+
+    // the chunks of the bounce buffers shall add up to the frame of the pixel layout
+    size_t ref_length = bench_capture(pixel, ref);
+    size_t length = bench_capture(bench_compact, frame);
+    bool match = (length == ref_length) && (length < BENCH_BUS_SIZE) && (0 == memcmp(frame, ref, length));
+    printf("  compact frame matches pixel frame: %s (%lu bytes)\n", match ? "yes" : "no", (unsigned long)length);
+
+    (void)hd108_lld_deinit(bench_compact);
+    (void)hd108_lld_deinit(pixel);
+    return match ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_lld.h"
+#include "HD108_sampler.h"
+#include "bench.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define BENCH_COUNT                 (    1024UL)    ///< LEDs, a 32 x 32 grid over the image
+#define BENCH_WIDTH                 (     320UL)    ///< image width
+#define BENCH_HEIGHT                (     240UL)    ///< image height
+#define BENCH_FPS                   (      60UL)    ///< video frame rate
+#define BENCH_REPEAT                (    2000UL)    ///< rendered frames
+#define BENCH_BATCH                 (      32UL)    ///< LEDs per bulk write of the staging path
+#define BENCH_CURRENT               HD108_LLD_CURRENT(31, 31, 31)
+
+
+volatile uint32_t bench_sink;
+
+
+/******************************************************************************
+ * Staging path: batches of samples written with the RGB48 bulk write
+ *****************************************************************************/
+static uint32_t bench_u[BENCH_COUNT];
+static uint32_t bench_v[BENCH_COUNT];
+
+
+static uint16_t naive_blend(uint32_t c00, uint32_t c01, uint32_t c10, uint32_t c11, uint32_t wx, uint32_t wy) {
+    uint32_t top = (c00 * (256 - wx) + c01 * wx) >> 8;
+    uint32_t bottom = (c10 * (256 - wx) + c11 * wx) >> 8;
+    return (uint16_t)((top * (256 - wy) + bottom * wy) >> 8);
+}
+
+
+static __attribute__((noinline)) void naive_rgb888(void *ctx, const uint8_t *image) {
+    uint16_t pixels[3 * BENCH_BATCH];
+
+    for (uint16_t start = 0; start < BENCH_COUNT; start += BENCH_BATCH) {
+        for (uint16_t i = 0; i < BENCH_BATCH; i++) {
+            uint32_t u = bench_u[start + i], v = bench_v[start + i];
+            const uint8_t *top = &image[3 * ((v >> 16) * BENCH_WIDTH + (u >> 16))];
+            const uint8_t *bottom = top + 3 * BENCH_WIDTH;
+            for (uint8_t c = 0; c < 3; c++) {
+                pixels[3 * i + c] = naive_blend(top[c] * 0x0101U, top[c + 3] * 0x0101U, bottom[c] * 0x0101U, bottom[c + 3] * 0x0101U,
+                                                (u >> 8) & 0xffU, (v >> 8) & 0xffU);
+            }
+        }
+        (void)hd108_lld_write_rgb48(ctx, start, BENCH_BATCH, pixels, BENCH_CURRENT);
+    }
+}
+
+
+/******************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+static void bench_budget(const char *name, uint64_t ns) {
+    double frame_ns = (double)ns / BENCH_REPEAT;
+    printf("  %s: %.1f us per frame, %.2f %% of the %lu Hz frame time\n", name, frame_ns / 1000.0,
+           frame_ns * BENCH_FPS / 1e7, (unsigned long)BENCH_FPS);
+}
+
+
+int main(void) {
+    static uint8_t rgb888[3 * BENCH_WIDTH * BENCH_HEIGHT];
+    static uint16_t rgb565[BENCH_WIDTH * BENCH_HEIGHT];
+    static uint8_t frame[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    static uint8_t ref[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    void *ctx;
+    void *sampler_rgb888;
+    void *sampler_rgb565;
+    uint64_t start;
+
+    const hd108_configuration_t configuration = {
+        .spi_host = SPI2_HOST,
+        .spi_speed_hz = HD108_LLD_MAX_SPI_SPEED,
+        .count = BENCH_COUNT,
+        .frequency_hz = HD108_LLD_UPDATE_60HZ,
+        .live_write = true,
+        .external_update = true,
+    };
+    if (HD108_LLD_OK != hd108_lld_init(&configuration, &ctx)) {
+        printf("hd108_lld_init failed\n");
+        return 1;
+    }
+
+    // a grid of LEDs at fractional positions over the whole image
+    srand(1);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        bench_u[i] = (uint32_t)(((i % 32) * (BENCH_WIDTH - 2) << 16) / 31) + (uint32_t)(rand() & 0xffff);
+        bench_v[i] = (uint32_t)(((i / 32) * (BENCH_HEIGHT - 2) << 16) / 31) + (uint32_t)(rand() & 0xffff);
+    }
+    for (size_t i = 0; i < sizeof(rgb888); i++) {
+        rgb888[i] = (uint8_t)rand();
+    }
+    for (size_t i = 0; i < BENCH_WIDTH * BENCH_HEIGHT; i++) {
+        rgb565[i] = (uint16_t)rand();
+    }
+
+    hd108_sampler_configuration_t sampler_configuration = {
+        .ctx = ctx,
+        .count = BENCH_COUNT,
+        .image_width = BENCH_WIDTH,
+        .image_height = BENCH_HEIGHT,
+        .format = HD108_SAMPLER_RGB888,
+        .u = bench_u,
+        .v = bench_v,
+    };
+    if (HD108_LLD_OK != hd108_sampler_init(&sampler_configuration, &sampler_rgb888)) {
+        printf("hd108_sampler_init failed\n");
+        return 1;
+    }
+    sampler_configuration.format = HD108_SAMPLER_RGB565;
+    if (HD108_LLD_OK != hd108_sampler_init(&sampler_configuration, &sampler_rgb565)) {
+        printf("hd108_sampler_init failed\n");
+        return 1;
+    }
+
+    printf("image sampler, %lu LEDs from %lux%lu at %lu Hz\n", (unsigned long)BENCH_COUNT,
+           (unsigned long)BENCH_WIDTH, (unsigned long)BENCH_HEIGHT, (unsigned long)BENCH_FPS);
+
+    start = bench_now_ns();
+    BENCH_RUN("rgb888 staging + write_rgb48", BENCH_REPEAT, BENCH_COUNT, "LED", naive_rgb888(ctx, rgb888));
+    bench_budget("staging", bench_now_ns() - start);
+    start = bench_now_ns();
+    BENCH_RUN("sampler_render rgb888", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_sampler_render(sampler_rgb888, rgb888, BENCH_CURRENT));
+    bench_budget("direct", bench_now_ns() - start);
+    naive_rgb888(ctx, rgb888);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, ref);
+    (void)hd108_sampler_render(sampler_rgb888, rgb888, BENCH_CURRENT);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, frame);
+    printf("  sampler_render matches staging: %s\n", memcmp(frame, ref, sizeof(frame)) ? "no" : "yes");
+
+    start = bench_now_ns();
+    BENCH_RUN("sampler_render rgb565", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_sampler_render(sampler_rgb565, rgb565, BENCH_CURRENT));
+    bench_budget("direct", bench_now_ns() - start);
+
+    hd108_sampler_deinit(sampler_rgb565);
+    hd108_sampler_deinit(sampler_rgb888);
+    (void)hd108_lld_deinit(ctx);
+    return 0;
+}
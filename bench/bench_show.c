@@ -0,0 +1,213 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#include "HD108_lld.h"
+#include "HD108_show.h"
+#include "bench.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define BENCH_COUNT                 (    1024UL)    ///< LEDs in one frame
+#define BENCH_FRAMES                (    2000UL)    ///< frames of the unpaced shows
+#define BENCH_PACED_FRAMES          (     500UL)    ///< frames of the paced show
+#define BENCH_PACED_FPS             (     500UL)    ///< frame rate of the paced show
+#define BENCH_UNPACED_FPS           ( 1000000UL)    ///< 1 us frame time, the update runs flat out
+#define BENCH_BLOCK_SIZE            (    4096UL)    ///< FAT cluster size
+#define BENCH_BLOCK_COUNT           (       4U)     ///< read-ahead blocks
+#define BENCH_CURRENT               HD108_LLD_CURRENT(31, 31, 31)
+#define BENCH_PACK                  "../tools/hd108_show_pack.py"
+
+
+volatile uint32_t bench_sink;
+
+
+/******************************************************************************
+ * Show files
+ *****************************************************************************/
+/**
+ * @brief One frame of the show: bands of one color, which run-length encode
+ *        well, sliding over a noisy background, which does not.
+ */
+static void bench_frame(uint32_t f, uint8_t *rgb) {
+    for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+        uint32_t band = (i + 4 * f) / 48;
+        uint32_t noise = (i * 2654435761UL + f * 40503UL) >> 8;
+        if (0 == band % 4) {
+            rgb[3 * i + 0] = (uint8_t)noise;
+            rgb[3 * i + 1] = (uint8_t)(noise >> 8);
+            rgb[3 * i + 2] = (uint8_t)(noise >> 16);
+        } else {
+            rgb[3 * i + 0] = (uint8_t)(band * 37);
+            rgb[3 * i + 1] = (uint8_t)(band * 91);
+            rgb[3 * i + 2] = (uint8_t)(band * 13);
+        }
+    }
+}
+
+
+/**
+ * @brief Write the frames and pack them with tools/hd108_show_pack.py.
+ */
+static int bench_pack(const char *frames, const char *show, uint32_t count, unsigned long fps, bool rle) {
+    static uint8_t rgb[3 * BENCH_COUNT];
+    char command[512];
+
+    FILE *file = fopen(frames, "wb");
+    if (!file) {
+        return -1;
+    }
+    for (uint32_t f = 0; f < count; f++) {
+        bench_frame(f, rgb);
+        (void)fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    fclose(file);
+
+    snprintf(command, sizeof(command), "python3 %s --count %lu --fps %lu %s %s %s", BENCH_PACK,
+             (unsigned long)BENCH_COUNT, fps, rle ? "--rle" : "", frames, show);
+    return system(command);
+}
+
+
+/******************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+/**
+ * @brief Play a show until its last frame and report the throughput.
+ *
+ * @note A paced show is checked frame by frame against the bulk writer.
+ */
+static int bench_play(void *ctx, const char *name, const char *show_path, uint32_t count, uint8_t block_count, bool check) {
+    static uint8_t rgb[3 * BENCH_COUNT];
+    static uint8_t frame[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    static uint8_t ref[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    hd108_show_stats_t stats = {0};
+    uint32_t mismatches = 0;
+    void *show;
+
+    const hd108_show_configuration_t configuration = {
+        .ctx = ctx,
+        .path = show_path,
+        .current = BENCH_CURRENT,
+        .block_size = BENCH_BLOCK_SIZE,
+        .block_count = block_count,
+        .priority = 5,
+    };
+    if (HD108_LLD_OK != hd108_show_open(&configuration, &show)) {
+        printf("hd108_show_open failed\n");
+        return -1;
+    }
+
+    uint64_t start = bench_now_ns();
+    uint32_t frames = 0;
+    while (frames < count) {
+        if (HD108_LLD_OK != hd108_show_update(show)) {
+            printf("hd108_show_update failed\n");
+            break;
+        }
+        hd108_show_get_stats(show, &stats);
+        if (check && (stats.frames != frames)) {
+            (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, frame);
+            bench_frame(stats.frames - 1, rgb);
+            (void)hd108_lld_write_rgb888(ctx, 0, BENCH_COUNT, rgb, BENCH_CURRENT);
+            (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, ref);
+            mismatches += (0 != memcmp(frame, ref, sizeof(frame)));
+        }
+        frames = stats.frames;
+    }
+    double seconds = (double)(bench_now_ns() - start) / 1e9;
+
+    if (!check) {
+        (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, frame);
+        bench_frame(count - 1, rgb);
+        (void)hd108_lld_write_rgb888(ctx, 0, BENCH_COUNT, rgb, BENCH_CURRENT);
+        (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, ref);
+        mismatches = (0 != memcmp(frame, ref, sizeof(frame)));
+    }
+    hd108_show_close(show);
+
+    printf("%-32s %10.0f frames/s %8.0f blocks/s %8.1f MB/s\n", name, stats.frames / seconds,
+           (double)stats.bytes_read / BENCH_BLOCK_SIZE / seconds, (double)stats.bytes_read / 1e6 / seconds);
+    printf("  %lu frames, %lu underruns, lowest read-ahead %lu bytes, read %.1f MB/s, frames match: %s\n",
+           (unsigned long)stats.frames, (unsigned long)stats.underruns, (unsigned long)stats.min_buffered,
+           stats.read_time_us ? (double)stats.bytes_read / (double)stats.read_time_us : 0.0, mismatches ? "no" : "yes");
+
+    return (stats.frames == count) ? 0 : -1;
+}
+
+
+int main(void) {
+    char frames[64], raw[64], rle[64], paced[64];
+    void *ctx;
+    int result = 0;
+
+    const hd108_configuration_t configuration = {
+        .spi_host = SPI2_HOST,
+        .spi_speed_hz = HD108_LLD_MAX_SPI_SPEED,
+        .count = BENCH_COUNT,
+        .frequency_hz = HD108_LLD_UPDATE_60HZ,
+        .live_write = true,
+        .external_update = true,
+    };
+    if (HD108_LLD_OK != hd108_lld_init(&configuration, &ctx)) {
+        printf("hd108_lld_init failed\n");
+        return 1;
+    }
+
+    snprintf(frames, sizeof(frames), "/tmp/bench_show_%d.rgb", (int)getpid());
+    snprintf(raw, sizeof(raw), "/tmp/bench_show_%d_raw.bin", (int)getpid());
+    snprintf(rle, sizeof(rle), "/tmp/bench_show_%d_rle.bin", (int)getpid());
+    snprintf(paced, sizeof(paced), "/tmp/bench_show_%d_paced.bin", (int)getpid());
+    if ((0 != bench_pack(frames, raw, BENCH_FRAMES, BENCH_UNPACED_FPS, false)) ||
+        (0 != bench_pack(frames, rle, BENCH_FRAMES, BENCH_UNPACED_FPS, true)) ||
+        (0 != bench_pack(frames, paced, BENCH_PACED_FRAMES, BENCH_PACED_FPS, true))) {
+        printf("%s failed\n", BENCH_PACK);
+        result = 1;
+    } else {
+        printf("show playback, %lu LEDs, %lu byte blocks\n", (unsigned long)BENCH_COUNT, (unsigned long)BENCH_BLOCK_SIZE);
+        result |= bench_play(ctx, "raw, unpaced, 4 blocks", raw, BENCH_FRAMES, BENCH_BLOCK_COUNT, false);
+        result |= bench_play(ctx, "rle, unpaced, 4 blocks", rle, BENCH_FRAMES, BENCH_BLOCK_COUNT, false);
+        result |= bench_play(ctx, "rle, 500 Hz, 2 blocks", paced, BENCH_PACED_FRAMES, HD108_SHOW_MIN_BLOCKS, true);
+    }
+
+    remove(frames);
+    remove(raw);
+    remove(rle);
+    remove(paced);
+    (void)hd108_lld_deinit(ctx);
+    return result ? 1 : 0;
+}
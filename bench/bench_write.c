@@ -0,0 +1,170 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_lld.h"
+#include "bench.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define BENCH_COUNT                 (    1024UL)    ///< LEDs, the longest strip
+#define BENCH_REPEAT                (    5000UL)    ///< writes of the whole strip
+#define BENCH_CURRENT               HD108_LLD_CURRENT(31, 31, 31)
+
+
+volatile uint32_t bench_sink;
+
+
+/******************************************************************************
+ * Per-pixel writes, the conversion loops the bulk writers replace
+ *****************************************************************************/
+static __attribute__((noinline)) void naive_rgb565(void *ctx, const uint16_t *src) {
+    for (uint16_t i = 0; i < BENCH_COUNT; i++) {
+        uint16_t r = (uint16_t)((src[i] >> 11) & 0x1f), g = (uint16_t)((src[i] >> 5) & 0x3f), b = (uint16_t)(src[i] & 0x1f);
+        hd108_pixel_t pixel = { .cl_red = 31, .cl_green = 31, .cl_blue = 31,
+                                .red = (uint16_t)(r * 65535 / 31), .green = (uint16_t)(g * 65535 / 63), .blue = (uint16_t)(b * 65535 / 31) };
+        (void)hd108_lld_set_pixel(ctx, i, &pixel);
+    }
+}
+
+
+static __attribute__((noinline)) void naive_rgb888(void *ctx, const uint8_t *src) {
+    for (uint16_t i = 0; i < BENCH_COUNT; i++) {
+        hd108_pixel_t pixel = { .cl_red = 31, .cl_green = 31, .cl_blue = 31,
+                                .red = (uint16_t)(src[3 * i] * 257), .green = (uint16_t)(src[3 * i + 1] * 257), .blue = (uint16_t)(src[3 * i + 2] * 257) };
+        (void)hd108_lld_set_pixel(ctx, i, &pixel);
+    }
+}
+
+
+static __attribute__((noinline)) void naive_rgba8888(void *ctx, const uint8_t *src) {
+    for (uint16_t i = 0; i < BENCH_COUNT; i++) {
+        uint32_t a = src[4 * i + 3];
+        hd108_pixel_t pixel = { .cl_red = 31, .cl_green = 31, .cl_blue = 31,
+                                .red = (uint16_t)(src[4 * i] * 257 * a / 255), .green = (uint16_t)(src[4 * i + 1] * 257 * a / 255),
+                                .blue = (uint16_t)(src[4 * i + 2] * 257 * a / 255) };
+        (void)hd108_lld_set_pixel(ctx, i, &pixel);
+    }
+}
+
+
+static __attribute__((noinline)) void naive_rgb48(void *ctx, const uint16_t *src) {
+    for (uint16_t i = 0; i < BENCH_COUNT; i++) {
+        hd108_pixel_t pixel = { .cl_red = 31, .cl_green = 31, .cl_blue = 31,
+                                .red = src[3 * i], .green = src[3 * i + 1], .blue = src[3 * i + 2] };
+        (void)hd108_lld_set_pixel(ctx, i, &pixel);
+    }
+}
+
+
+static __attribute__((noinline)) uint16_t naive_clamp(float value) {
+    return (value <= 0.0f) ? 0 : ((value >= 1.0f) ? 65535 : (uint16_t)(value * 65535.0f + 0.5f));
+}
+
+
+static __attribute__((noinline)) void naive_float(void *ctx, const float *src) {
+    for (uint16_t i = 0; i < BENCH_COUNT; i++) {
+        hd108_pixel_t pixel = { .cl_red = 31, .cl_green = 31, .cl_blue = 31,
+                                .red = naive_clamp(src[3 * i]), .green = naive_clamp(src[3 * i + 1]), .blue = naive_clamp(src[3 * i + 2]) };
+        (void)hd108_lld_set_pixel(ctx, i, &pixel);
+    }
+}
+
+
+/******************************************************************************
+ * Benchmarks
+ *****************************************************************************/
+int main(void) {
+    static uint16_t rgb565[BENCH_COUNT];
+    static uint8_t rgb888[3 * BENCH_COUNT];
+    static uint8_t rgba8888[4 * BENCH_COUNT];
+    static uint16_t rgb48[3 * BENCH_COUNT];
+    static float rgbf[3 * BENCH_COUNT];
+    static uint8_t frame[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    static uint8_t ref[HD108_LLD_FRAME_SIZE(BENCH_COUNT)];
+    void *ctx;
+
+    const hd108_configuration_t configuration = {
+        .spi_host = SPI2_HOST,
+        .spi_speed_hz = HD108_LLD_MAX_SPI_SPEED,
+        .count = BENCH_COUNT,
+        .frequency_hz = HD108_LLD_UPDATE_30HZ,
+        .live_write = true,
+        .external_update = true,
+    };
+    if (HD108_LLD_OK != hd108_lld_init(&configuration, &ctx)) {
+        printf("hd108_lld_init failed\n");
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        rgb565[i] = (uint16_t)rand();
+    }
+    for (size_t i = 0; i < 3 * BENCH_COUNT; i++) {
+        rgb888[i] = (uint8_t)rand();
+        rgb48[i] = (uint16_t)rand();
+        rgbf[i] = (float)rand() / (float)RAND_MAX * 1.2f - 0.1f;
+    }
+    for (size_t i = 0; i < 4 * BENCH_COUNT; i++) {
+        rgba8888[i] = (uint8_t)rand();
+    }
+
+    printf("bulk writers, %lu LEDs per write\n", (unsigned long)BENCH_COUNT);
+
+    BENCH_RUN("rgb565 set_pixel", BENCH_REPEAT, BENCH_COUNT, "LED", naive_rgb565(ctx, rgb565));
+    BENCH_RUN("write_rgb565", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_write_rgb565(ctx, 0, BENCH_COUNT, rgb565, BENCH_CURRENT));
+    BENCH_RUN("rgb888 set_pixel", BENCH_REPEAT, BENCH_COUNT, "LED", naive_rgb888(ctx, rgb888));
+    BENCH_RUN("write_rgb888", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_write_rgb888(ctx, 0, BENCH_COUNT, rgb888, BENCH_CURRENT));
+    naive_rgb888(ctx, rgb888);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, ref);
+    (void)hd108_lld_write_rgb888(ctx, 0, BENCH_COUNT, rgb888, BENCH_CURRENT);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, frame);
+    printf("  write_rgb888 matches set_pixel: %s\n", memcmp(frame, ref, sizeof(frame)) ? "no" : "yes");
+    BENCH_RUN("rgba8888 set_pixel", BENCH_REPEAT, BENCH_COUNT, "LED", naive_rgba8888(ctx, rgba8888));
+    BENCH_RUN("write_rgba8888", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_write_rgba8888(ctx, 0, BENCH_COUNT, rgba8888, BENCH_CURRENT));
+    BENCH_RUN("rgb48 set_pixel", BENCH_REPEAT, BENCH_COUNT, "LED", naive_rgb48(ctx, rgb48));
+    BENCH_RUN("write_rgb48", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_write_rgb48(ctx, 0, BENCH_COUNT, rgb48, BENCH_CURRENT));
+    naive_rgb48(ctx, rgb48);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, ref);
+    (void)hd108_lld_write_rgb48(ctx, 0, BENCH_COUNT, rgb48, BENCH_CURRENT);
+    (void)hd108_lld_capture_frame(ctx, 0, BENCH_COUNT, frame);
+    printf("  write_rgb48 matches set_pixel: %s\n", memcmp(frame, ref, sizeof(frame)) ? "no" : "yes");
+    BENCH_RUN("float set_pixel", BENCH_REPEAT, BENCH_COUNT, "LED", naive_float(ctx, rgbf));
+    BENCH_RUN("write_float", BENCH_REPEAT, BENCH_COUNT, "LED", (void)hd108_lld_write_float(ctx, 0, BENCH_COUNT, rgbf, BENCH_CURRENT));
+
+    (void)hd108_lld_deinit(ctx);
+    return 0;
+}
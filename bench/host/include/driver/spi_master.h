@@ -0,0 +1,108 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+/*
+ * Host port of the ESP-IDF API used by the benchmarks, see bench/host/port.c.
+ */
+
+#ifndef __HD108_BENCH_SPI_MASTER_H__
+#define __HD108_BENCH_SPI_MASTER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    SPI1_HOST,
+    SPI2_HOST,
+    SPI3_HOST,
+} spi_host_device_t;
+
+#define SPICOMMON_BUSFLAG_MASTER    (1 << 0)
+#define SPI_DMA_CH_AUTO             (3)
+
+typedef struct hd108_port_spi_device *spi_device_handle_t;
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *transaction);
+
+struct spi_transaction_t {
+    uint32_t        flags;
+    uint16_t        cmd;
+    uint64_t        addr;
+    size_t          length;
+    size_t          rxlength;
+    void           *user;
+    union {
+        const void *tx_buffer;
+        uint8_t     tx_data[4];
+    };
+    union {
+        void       *rx_buffer;
+        uint8_t     rx_data[4];
+    };
+};
+
+typedef struct {
+    int             mosi_io_num;
+    int             miso_io_num;
+    int             sclk_io_num;
+    int             quadwp_io_num;
+    int             quadhd_io_num;
+    int             max_transfer_sz;
+    uint32_t        flags;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t         command_bits;
+    uint8_t         address_bits;
+    uint8_t         dummy_bits;
+    uint8_t         mode;
+    int             clock_speed_hz;
+    int             spics_io_num;
+    uint32_t        flags;
+    int             queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *transaction, TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **transaction,
+                                      TickType_t ticks_to_wait);
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait);
+void      spi_device_release_bus(spi_device_handle_t handle);
+
+#endif /* __HD108_BENCH_SPI_MASTER_H__ */
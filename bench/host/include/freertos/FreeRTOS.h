@@ -0,0 +1,69 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+/*
+ * Host port of the ESP-IDF API used by the benchmarks, see bench/host/port.c.
+ */
+
+#ifndef __HD108_BENCH_FREERTOS_H__
+#define __HD108_BENCH_FREERTOS_H__
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef uint32_t    TickType_t;
+typedef int         BaseType_t;
+typedef unsigned    UBaseType_t;
+
+#define portMAX_DELAY               (0xffffffffUL)
+#define portTICK_PERIOD_MS          (1)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+#define pdFALSE                     (0)
+#define pdTRUE                      (1)
+#define pdFAIL                      (0)
+#define pdPASS                      (1)
+#define tskNO_AFFINITY              (0x7fffffff)
+
+typedef struct {
+    uint32_t owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+
+/* All critical sections share one recursive lock. */
+void portENTER_CRITICAL(portMUX_TYPE *mux);
+void portEXIT_CRITICAL(portMUX_TYPE *mux);
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR(woken)       ((void)(woken))
+
+/* A single core. */
+#define xPortGetCoreID()                ((BaseType_t)0)
+
+#endif /* __HD108_BENCH_FREERTOS_H__ */
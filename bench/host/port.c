@@ -0,0 +1,663 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+/*
+ * Host port of the ESP-IDF API used by the driver, for the benchmarks.
+ *
+ * Tasks are POSIX threads, queues and semaphores are guarded by one mutex
+ * each, all critical sections share one recursive lock. The esp_timer
+ * callbacks run on one dispatch thread like the esp_timer task. The SPI
+ * master completes every transaction immediately and only counts them.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "port.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define PORT_SPI_QUEUE              (       8)  ///< Transactions in flight per device
+
+
+/******************************************************************************
+ * Private data types
+ *****************************************************************************/
+struct hd108_port_queue {
+    pthread_mutex_t     lock;
+    pthread_cond_t      changed;
+    uint8_t            *items;
+    UBaseType_t         length;
+    UBaseType_t         item_size;
+    UBaseType_t         head;
+    UBaseType_t         waiting;
+};
+
+struct hd108_port_task {
+    TaskFunction_t      function;
+    void               *arg;
+    pthread_mutex_t     lock;
+    pthread_cond_t      notified;
+    uint32_t            notifications;
+};
+
+struct esp_timer {
+    esp_timer_cb_t      callback;
+    void               *arg;
+    int64_t             expiry;         ///< Time of the next call, 0 if stopped
+    uint64_t            period;         ///< Period, 0 for a one-shot timer
+    struct esp_timer   *next;
+};
+
+struct hd108_port_spi_device {
+    transaction_cb_t    pre_cb;
+    transaction_cb_t    post_cb;
+    spi_transaction_t  *done[PORT_SPI_QUEUE];
+    uint32_t            head;
+    uint32_t            count;
+    int                 max_transfer_sz;
+};
+
+
+/******************************************************************************
+ * Private data
+ *****************************************************************************/
+static pthread_mutex_t          port_critical;
+static pthread_once_t           port_critical_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t          port_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t           port_timer_changed = PTHREAD_COND_INITIALIZER;
+static pthread_once_t           port_timer_once = PTHREAD_ONCE_INIT;
+static struct esp_timer        *port_timers;
+static __thread TaskHandle_t    port_current_task;
+static int                      port_max_transfer_sz[SPI3_HOST + 1];
+static bool                     port_bus_in_use[SPI3_HOST + 1];
+static hd108_port_spi_stats_t   port_spi_stats;
+static uint8_t                 *port_capture;
+static size_t                   port_capture_size;
+static size_t                   port_capture_length;
+
+
+/******************************************************************************
+ * Private functions
+ *****************************************************************************/
+static struct timespec port_deadline(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+
+/**
+ * @brief Wait on a condition. Returns false if the ticks elapsed.
+ */
+static bool port_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline) {
+    if (0 == ticks) {
+        return false;
+    }
+    if (portMAX_DELAY == ticks) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return 0 == pthread_cond_timedwait(cond, lock, deadline);
+}
+
+
+static void port_critical_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&port_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+
+static void *port_task_entry(void *arg) {
+    TaskHandle_t task = arg;
+    port_current_task = task;
+    task->function(task->arg);
+    return NULL;
+}
+
+
+static void *port_timer_task(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&port_timer_lock);
+    for (;;) {
+        struct esp_timer *due = NULL;
+        int64_t next = 0;
+        for (struct esp_timer *timer = port_timers; NULL != timer; timer = timer->next) {
+            if ((0 != timer->expiry) && ((0 == next) || (timer->expiry < next))) {
+                next = timer->expiry;
+                due = timer;
+            }
+        }
+        if (NULL == due) {
+            pthread_cond_wait(&port_timer_changed, &port_timer_lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (now < next) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            int64_t ns = (int64_t)ts.tv_nsec + (next - now) * 1000;
+            ts.tv_sec += ns / 1000000000L;
+            ts.tv_nsec = ns % 1000000000L;
+            pthread_cond_timedwait(&port_timer_changed, &port_timer_lock, &ts);
+            continue;
+        }
+        due->expiry = (0 != due->period) ? (due->expiry + (int64_t)due->period) : 0;
+        esp_timer_cb_t callback = due->callback;
+        void *callback_arg = due->arg;
+        pthread_mutex_unlock(&port_timer_lock);
+        callback(callback_arg);
+        pthread_mutex_lock(&port_timer_lock);
+    }
+    return NULL;
+}
+
+
+static void port_timer_start_task(void) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, port_timer_task, NULL);
+    pthread_detach(thread);
+}
+
+
+static esp_err_t port_timer_arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period) {
+    pthread_mutex_lock(&port_timer_lock);
+    if (0 != timer->expiry) {
+        pthread_mutex_unlock(&port_timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expiry = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->period = period;
+    pthread_cond_signal(&port_timer_changed);
+    pthread_mutex_unlock(&port_timer_lock);
+    return ESP_OK;
+}
+
+
+/******************************************************************************
+ * Heap
+ *****************************************************************************/
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    (void)caps;
+    return calloc(n, size);
+}
+
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    (void)caps;
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+
+void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+
+/******************************************************************************
+ * Critical sections, queues and semaphores
+ *****************************************************************************/
+void portENTER_CRITICAL(portMUX_TYPE *mux) {
+    (void)mux;
+    pthread_once(&port_critical_once, port_critical_init);
+    pthread_mutex_lock(&port_critical);
+}
+
+
+void portEXIT_CRITICAL(portMUX_TYPE *mux) {
+    (void)mux;
+    pthread_mutex_unlock(&port_critical);
+}
+
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(struct hd108_port_queue));
+    if (NULL == queue) {
+        return NULL;
+    }
+    queue->items = malloc((0 != length * item_size) ? (length * item_size) : 1);
+    if (NULL == queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait) {
+    struct timespec deadline = port_deadline(ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->waiting == queue->length) {
+        if (!port_wait(&queue->changed, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (0 != queue->item_size) {
+        memcpy(&queue->items[((queue->head + queue->waiting) % queue->length) * queue->item_size], item, queue->item_size);
+    }
+    queue->waiting++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait) {
+    struct timespec deadline = port_deadline(ticks_to_wait);
+    pthread_mutex_lock(&queue->lock);
+    while (0 == queue->waiting) {
+        if (!port_wait(&queue->changed, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (0 != queue->item_size) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->waiting--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->waiting = 0;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->items);
+    free(queue);
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t semaphore = xQueueCreate(1, 0);
+    if (NULL != semaphore) {
+        semaphore->waiting = 1;
+    }
+    return semaphore;
+}
+
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    return xQueueReceive(semaphore, NULL, ticks_to_wait);
+}
+
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken) {
+    if (NULL != woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    vQueueDelete(semaphore);
+}
+
+
+/******************************************************************************
+ * Tasks
+ *****************************************************************************/
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out_handle) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    TaskHandle_t task = calloc(1, sizeof(struct hd108_port_task));
+    if (NULL == task) {
+        return pdFAIL;
+    }
+    task->function = function;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->notified, NULL);
+    if (NULL != out_handle) {
+        *out_handle = task;
+    }
+    pthread_t thread;
+    if (0 != pthread_create(&thread, NULL, port_task_entry, task)) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *out_handle, BaseType_t core_id) {
+    (void)core_id;
+    return xTaskCreate(function, name, stack_depth, arg, priority, out_handle);
+}
+
+
+/* Only a task deleting itself is supported. */
+void vTaskDelete(TaskHandle_t task) {
+    if ((NULL == task) || (task == port_current_task)) {
+        task = port_current_task;
+        pthread_mutex_destroy(&task->lock);
+        pthread_cond_destroy(&task->notified);
+        free(task);
+        pthread_exit(NULL);
+    }
+}
+
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return port_current_task;
+}
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notifications++;
+    pthread_cond_broadcast(&task->notified);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    if (NULL != woken) {
+        *woken = pdFALSE;
+    }
+    (void)xTaskNotifyGive(task);
+}
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    TaskHandle_t task = port_current_task;
+    struct timespec deadline = port_deadline(ticks_to_wait);
+    pthread_mutex_lock(&task->lock);
+    while (0 == task->notifications) {
+        if (!port_wait(&task->notified, &task->lock, ticks_to_wait, &deadline)) {
+            break;
+        }
+    }
+    uint32_t value = task->notifications;
+    if (0 != value) {
+        task->notifications = clear_on_exit ? 0 : (value - 1);
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+
+/******************************************************************************
+ * esp_timer
+ *****************************************************************************/
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle) {
+    pthread_once(&port_timer_once, port_timer_start_task);
+    esp_timer_handle_t timer = calloc(1, sizeof(struct esp_timer));
+    if (NULL == timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    pthread_mutex_lock(&port_timer_lock);
+    timer->next = port_timers;
+    port_timers = timer;
+    pthread_mutex_unlock(&port_timer_lock);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    return port_timer_arm(timer, timeout_us, 0);
+}
+
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return port_timer_arm(timer, period, period);
+}
+
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    pthread_mutex_lock(&port_timer_lock);
+    esp_err_t err = (0 != timer->expiry) ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->expiry = 0;
+    pthread_mutex_unlock(&port_timer_lock);
+    return err;
+}
+
+
+/* Like the esp_timer, a callback in progress is not waited for. */
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    pthread_mutex_lock(&port_timer_lock);
+    if (0 != timer->expiry) {
+        pthread_mutex_unlock(&port_timer_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (struct esp_timer **link = &port_timers; NULL != *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&port_timer_lock);
+    free(timer);
+    return ESP_OK;
+}
+
+
+/******************************************************************************
+ * SPI master
+ *****************************************************************************/
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus_config, int dma_chan) {
+    (void)dma_chan;
+    if (port_bus_in_use[host]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    port_bus_in_use[host] = true;
+    port_max_transfer_sz[host] = bus_config->max_transfer_sz;
+    return ESP_OK;
+}
+
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+    port_bus_in_use[host] = false;
+    port_max_transfer_sz[host] = 0;
+    return ESP_OK;
+}
+
+
+esp_err_t spi_bus_get_max_transaction_len(spi_host_device_t host, size_t *max_bytes) {
+    *max_bytes = (size_t)port_max_transfer_sz[host];
+    return ESP_OK;
+}
+
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev_config,
+                             spi_device_handle_t *handle) {
+    spi_device_handle_t device = calloc(1, sizeof(struct hd108_port_spi_device));
+    if (NULL == device) {
+        return ESP_ERR_NO_MEM;
+    }
+    device->pre_cb = dev_config->pre_cb;
+    device->post_cb = dev_config->post_cb;
+    device->max_transfer_sz = port_max_transfer_sz[host];
+    *handle = device;
+    return ESP_OK;
+}
+
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    free(handle);
+    return ESP_OK;
+}
+
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *transaction, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if ((handle->count == PORT_SPI_QUEUE) ||
+        ((0 != handle->max_transfer_sz) && ((transaction->length + 7) / 8 > (size_t)handle->max_transfer_sz))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (NULL != handle->pre_cb) {
+        handle->pre_cb(transaction);
+    }
+    if (NULL != handle->post_cb) {
+        handle->post_cb(transaction);
+    }
+    handle->done[(handle->head + handle->count) % PORT_SPI_QUEUE] = transaction;
+    handle->count++;
+    portENTER_CRITICAL(NULL);
+    port_spi_stats.transactions++;
+    port_spi_stats.bits += transaction->length;
+    // the bytes are copied when queued, as the DMA would read them
+    if (NULL != port_capture) {
+        size_t bytes = (transaction->length + 7) / 8;
+        if (bytes > port_capture_size - port_capture_length) {
+            bytes = port_capture_size - port_capture_length;
+        }
+        memcpy(&port_capture[port_capture_length], transaction->tx_buffer, bytes);
+        port_capture_length += bytes;
+    }
+    portEXIT_CRITICAL(NULL);
+    return ESP_OK;
+}
+
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **transaction,
+                                      TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if (0 == handle->count) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *transaction = handle->done[handle->head];
+    handle->head = (handle->head + 1) % PORT_SPI_QUEUE;
+    handle->count--;
+    return ESP_OK;
+}
+
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait) {
+    (void)handle;
+    (void)wait;
+    return ESP_OK;
+}
+
+
+void spi_device_release_bus(spi_device_handle_t handle) {
+    (void)handle;
+}
+
+
+/******************************************************************************
+ * Port statistics
+ *****************************************************************************/
+void hd108_port_get_spi_stats(hd108_port_spi_stats_t *stats) {
+    portENTER_CRITICAL(NULL);
+    *stats = port_spi_stats;
+    portEXIT_CRITICAL(NULL);
+}
+
+
+void hd108_port_set_spi_capture(uint8_t *buffer, size_t size) {
+    portENTER_CRITICAL(NULL);
+    port_capture = buffer;
+    port_capture_size = size;
+    port_capture_length = 0;
+    portEXIT_CRITICAL(NULL);
+}
+
+
+size_t hd108_port_get_spi_capture(void) {
+    portENTER_CRITICAL(NULL);
+    size_t length = port_capture_length;
+    portEXIT_CRITICAL(NULL);
+    return length;
+}
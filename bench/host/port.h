@@ -0,0 +1,74 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_BENCH_PORT_H__
+#define __HD108_BENCH_PORT_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief SPI traffic of the host port.
+ */
+typedef struct {
+    uint32_t    transactions;   ///< Transactions queued
+    uint64_t    bits;           ///< Sum of the transaction lengths
+} hd108_port_spi_stats_t;
+
+
+/**
+ * @brief Get the SPI traffic of all devices since the start of the program.
+ *
+ * @param stats Statistics to fill.
+ */
+void hd108_port_get_spi_stats(hd108_port_spi_stats_t *stats);
+
+
+/**
+ * @brief Capture the bytes sent on the SPI bus.
+ *
+ * @note The TX buffers of all devices are appended to the buffer as they are
+ *       queued, the bytes that do not fit are dropped.
+ *
+ * @param buffer Buffer of the bytes, NULL to stop capturing.
+ * @param size Size of the buffer.
+ */
+void hd108_port_set_spi_capture(uint8_t *buffer, size_t size);
+
+
+/**
+ * @brief Get the number of bytes captured since hd108_port_set_spi_capture.
+ *
+ * @return
+ *         - The number of bytes in the buffer.
+ */
+size_t hd108_port_get_spi_capture(void);
+
+#endif /* __HD108_BENCH_PORT_H__ */
@@ -0,0 +1,126 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_ANIM_H__
+#define __HD108_ANIM_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Animation player configuration descriptor.
+ */
+typedef struct {
+    void           *map;            ///< The address of the 2D mapping, see HD108_map2d.h
+    const char     *path;           ///< Path of the GIF or MJPEG file, e.g. on LittleFS
+    uint16_t        current;        ///< Current levels for every pixel, see HD108_LLD_CURRENT
+    bool            loop;           ///< Restart the animation at the end of the file
+    uint32_t        mjpeg_frame_us; ///< Frame time of MJPEG files in microseconds, MJPEG has no timing
+    uint8_t         priority;       ///< Priority of the decoder task
+} hd108_anim_configuration_t;
+
+
+/**
+ * @brief Animation player open.
+ *
+ * @note It opens the file, detects the format from the first bytes and
+ *       starts a decoder task, which decodes the first frame right away.
+ *       GIF files are decoded with a streaming LZW decoder, transparent
+ *       pixels are not sent, so they keep the previous frame in the TX buffer.
+ *       MJPEG files (concatenated JPEG frames) are decoded MCU by MCU with
+ *       tjpgd, if CONFIG_HD108_MJPEG is enabled. There is no frame buffer:
+ *       the task passes the decoded pixels row by row through a ring of 8
+ *       runs (8 x (3 x width + 16) bytes). In addition the player needs the
+ *       read buffer, the task stack (4 KB) and, for GIF, the LZW tables
+ *       (16 KB) and 4 bytes per pixel of a row of the logical screen, for
+ *       MJPEG the tjpgd work area (about 3.5 KB).
+ *
+ * @param anim_configuration Pointer to the configuration struct. After the initialization
+ *                           the struct is not used.
+ * @param anim_out The address of the player pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the file cannot be opened or its format is not supported
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation or the task creation is not possible
+ */
+extern hd108_status_t hd108_anim_open(
+    const hd108_anim_configuration_t *anim_configuration,
+    void **anim_out
+);
+
+
+/**
+ * @brief Animation player update.
+ *
+ * @note It shall be called from the update function. When the presentation
+ *       time is reached the rows decoded by the task are written through the
+ *       2D mapping, the task decodes the rest of the frame meanwhile. The
+ *       update never waits and never touches the file: if the task is late,
+ *       the rest of the frame follows with the next updates. The
+ *       presentation time advances by the frame delay, so the animation keeps
+ *       its speed at any update frequency.
+ *
+ * @param anim_in The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success, also if no frame was due or the animation has ended
+ *         - HD108_LLD_ERROR_INVALID     if the frame is corrupted, the rows before the corruption are shown
+ *         - HD108_LLD_ERROR_INDEX       if the mapping is out of the strip
+ */
+extern hd108_status_t hd108_anim_update(
+    void *anim_in
+);
+
+
+/**
+ * @brief Animation player close.
+ *
+ * @note It waits for the decoder task to abandon the frame in progress and
+ *       exit, then it closes the file and releases the player. It shall not
+ *       be called while hd108_anim_update is running.
+ *
+ * @param anim_in The address of the player.
+ */
+extern void hd108_anim_close(
+    void *anim_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_ANIM_H__ */
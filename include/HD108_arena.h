@@ -0,0 +1,162 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_ARENA_H__
+#define __HD108_ARENA_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_ARENA_MAX_CLASSES     (       8UL)    ///< maximum number of size classes
+#define HD108_ARENA_ALIGN           (      16UL)    ///< alignment of every slot in bytes
+
+
+/**
+ * @brief Size of the TX buffer of a strip of count LEDs, for sizing the classes.
+ */
+#define HD108_ARENA_TX_SIZE(count)  (16UL + HD108_LLD_FRAME_SIZE(count))
+
+
+/**
+ * @brief Size class of an arena.
+ */
+typedef struct {
+    uint32_t    size;                   ///< Size of a slot in bytes, it is rounded up to HD108_ARENA_ALIGN
+    uint16_t    slots;                  ///< Number of slots
+} hd108_arena_class_t;
+
+
+/**
+ * @brief Arena configuration descriptor.
+ */
+typedef struct {
+    const hd108_arena_class_t  *classes;        ///< Size classes in ascending order of size
+    uint8_t                     class_count;    ///< Number of size classes [1 .. HD108_ARENA_MAX_CLASSES]
+    uint32_t                    caps;           ///< Capabilities of the arena memory, 0 for MALLOC_CAP_DMA | MALLOC_CAP_32BIT
+} hd108_arena_configuration_t;
+
+
+/**
+ * @brief Statistics of a size class.
+ */
+typedef struct {
+    uint32_t    size;                   ///< Size of a slot in bytes
+    uint16_t    slots;                  ///< Number of slots
+    uint16_t    used;                   ///< Slots in use
+    uint16_t    high_water;             ///< Most slots in use at the same time
+    uint32_t    failed;                 ///< Requests of this class that found no free slot in this or a larger class
+} hd108_arena_stats_t;
+
+
+/**
+ * @brief Arena init.
+ *
+ * @note It reserves one block for every slot of every class. The slots never
+ *       move or merge, so the arena cannot fragment: a buffer freed by a
+ *       removed strip is available for the same size at once. A request is
+ *       served from the smallest class that fits and has a free slot. It is
+ *       handed to the contexts in the configuration (arena), so their buffers
+ *       are taken from the arena instead of the heap.
+ *
+ * @param arena_configuration Pointer to the configuration struct. After the initialization
+ *                            the struct is not used.
+ * @param arena_out The address of the arena pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the classes are empty, too many or not in ascending order
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_arena_init(
+    const hd108_arena_configuration_t *arena_configuration,
+    void **arena_out
+);
+
+
+/**
+ * @brief Allocate a slot.
+ *
+ * @note It can be called from any task.
+ *
+ * @param arena_in The address of the arena.
+ * @param size Requested size in bytes.
+ *
+ * @return
+ *         - The address of the slot, aligned to HD108_ARENA_ALIGN, NULL if there is no free slot
+ */
+extern void *hd108_arena_alloc(
+    void *arena_in,
+    size_t size
+);
+
+
+/**
+ * @brief Free a slot.
+ *
+ * @note It can be called from any task. NULL is ignored.
+ *
+ * @param arena_in The address of the arena.
+ * @param mem The address of the slot.
+ */
+extern void hd108_arena_free(
+    void *arena_in,
+    void *mem
+);
+
+
+/**
+ * @brief Get the statistics of a size class.
+ *
+ * @param arena_in The address of the arena.
+ * @param class_index Index of the class in the configuration.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the class does not exist
+ */
+extern hd108_status_t hd108_arena_get_stats(
+    void *arena_in,
+    uint8_t class_index,
+    hd108_arena_stats_t *stats_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_ARENA_H__ */
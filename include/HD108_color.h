@@ -0,0 +1,347 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_COLOR_H__
+#define __HD108_COLOR_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "HD108_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief New type for a fraction in the range [0 .. 1).
+ *          0 means 0.0, 65535 means 65535/65536.
+ */
+typedef uint16_t hd108_fract16_t;
+
+
+/**
+ * @brief Saturating addition of two color values.
+ *
+ * @param a First color value.
+ * @param b Second color value.
+ *
+ * @return
+ *         - a + b, limited to 65535.
+ */
+static inline hd108_color_t hd108_color_qadd16(hd108_color_t a, hd108_color_t b) {
+    uint32_t sum = (uint32_t)a + b;
+    return (sum > UINT16_MAX) ? UINT16_MAX : (hd108_color_t)sum;
+}
+
+
+/**
+ * @brief Saturating subtraction of two color values.
+ *
+ * @param a First color value.
+ * @param b Second color value.
+ *
+ * @return
+ *         - a - b, limited to 0.
+ */
+static inline hd108_color_t hd108_color_qsub16(hd108_color_t a, hd108_color_t b) {
+    return (a > b) ? (hd108_color_t)(a - b) : 0;
+}
+
+
+/**
+ * @brief Scale a color value by a 16-bit factor.
+ *
+ * @note A scale of 65535 returns the color value unchanged, 0 returns 0.
+ *
+ * @param a Color value.
+ * @param scale Scale factor, 65535 means 1.0.
+ *
+ * @return
+ *         - a * (scale + 1) / 65536.
+ */
+static inline hd108_color_t hd108_color_scale16(hd108_color_t a, uint16_t scale) {
+    return (hd108_color_t)(((uint32_t)a * ((uint32_t)scale + 1)) >> 16);
+}
+
+
+/**
+ * @brief Linear interpolation between two color values.
+ *
+ * @note The weights of a and b add up to 65536, so only unsigned 32-bit
+ *       arithmetic is used and it never overflows. There is no branch.
+ *
+ * @param a Color value at fraction 0.
+ * @param b Color value at fraction 1.
+ * @param frac Fraction of the way from a to b.
+ *
+ * @return
+ *         - The interpolated color value.
+ */
+static inline hd108_color_t hd108_color_lerp16(hd108_color_t a, hd108_color_t b, hd108_fract16_t frac) {
+    return (hd108_color_t)(((uint32_t)a * (65536UL - frac) + (uint32_t)b * frac) >> 16);
+}
+
+
+/**
+ * @brief Linear interpolation between two pixels.
+ *
+ * @note Current levels and color values are interpolated channel by channel.
+ *
+ * @param a Pixel at fraction 0.
+ * @param b Pixel at fraction 1.
+ * @param frac Fraction of the way from a to b.
+ * @param dst Destination pixel, can be the same as a or b.
+ */
+static inline void hd108_pixel_lerp16(const hd108_pixel_t *a, const hd108_pixel_t *b, hd108_fract16_t frac, hd108_pixel_t *dst) {
+    hd108_pixel_t out = {
+        .cl_blue  = hd108_color_lerp16(a->cl_blue,  b->cl_blue,  frac),
+        .cl_green = hd108_color_lerp16(a->cl_green, b->cl_green, frac),
+        .cl_red   = hd108_color_lerp16(a->cl_red,   b->cl_red,   frac),
+        .red      = hd108_color_lerp16(a->red,      b->red,      frac),
+        .green    = hd108_color_lerp16(a->green,    b->green,    frac),
+        .blue     = hd108_color_lerp16(a->blue,     b->blue,     frac)
+    };
+    *dst = out;
+}
+
+
+/**
+ * @brief Saturating addition of two color arrays.
+ *
+ * @note On the ESP32-S3 the PIE vector instructions add 8 values per step if
+ *       both arrays have the same offset from a 16-byte boundary, e.g. planes.
+ *       Otherwise it is a plain loop, which the compiler can vectorize.
+ *
+ * @param dst Destination and first operand.
+ * @param src Second operand, can be the same as dst, but shall not overlap it otherwise.
+ * @param count Number of color values.
+ */
+extern void hd108_color_qadd16_array(
+    hd108_color_t *dst,
+    const hd108_color_t *src,
+    size_t count
+);
+
+
+/**
+ * @brief Scale a color array by a 16-bit factor.
+ *
+ * @note On the ESP32-S3 the PIE vector instructions scale 8 values per step if
+ *       both arrays have the same offset from a 16-byte boundary.
+ *
+ * @param dst Destination, can be the same as src.
+ * @param src Color values.
+ * @param count Number of color values.
+ * @param scale Scale factor, 65535 means 1.0.
+ */
+extern void hd108_color_scale16_array(
+    hd108_color_t *dst,
+    const hd108_color_t *src,
+    size_t count,
+    uint16_t scale
+);
+
+
+/**
+ * @brief Linear interpolation between two color arrays.
+ *
+ * @note The 32-bit weighted sum has no 16-bit vector form, the scalar loop
+ *       is used on every target.
+ *
+ * @param dst Destination, can be the same as a or b, but shall not overlap them otherwise.
+ * @param a Color values at fraction 0.
+ * @param b Color values at fraction 1.
+ * @param count Number of color values.
+ * @param frac Fraction of the way from a to b.
+ */
+extern void hd108_color_lerp16_array(
+    hd108_color_t *dst,
+    const hd108_color_t *a,
+    const hd108_color_t *b,
+    size_t count,
+    hd108_fract16_t frac
+);
+
+
+/**
+ * @brief Sine from look-up table.
+ *
+ * @note A quarter wave table of 257 entries is interpolated linearly,
+ *       the error is at most 2 LSB.
+ *
+ * @param theta Angle, 65536 is a full circle.
+ *
+ * @return
+ *         - sin(theta) in the range [-32767 .. 32767].
+ */
+extern int16_t hd108_sin16(
+    uint16_t theta
+);
+
+
+/**
+ * @brief Cosine from look-up table.
+ *
+ * @param theta Angle, 65536 is a full circle.
+ *
+ * @return
+ *         - cos(theta) in the range [-32767 .. 32767].
+ */
+extern int16_t hd108_cos16(
+    uint16_t theta
+);
+
+
+/**
+ * @brief Sine of an array of angles.
+ *
+ * @param dst Destination.
+ * @param theta Angles, 65536 is a full circle.
+ * @param count Number of angles.
+ */
+extern void hd108_sin16_array(
+    int16_t *dst,
+    const uint16_t *theta,
+    size_t count
+);
+
+
+/**
+ * @brief 1D value noise.
+ *
+ * @note Coordinates are Q16.16 fixed-point numbers, the lattice distance is 1.0.
+ *       Random lattice values are blended with a smoothstep fade.
+ *
+ * @param x Coordinate.
+ *
+ * @return
+ *         - Noise value in the range [0 .. 65535].
+ */
+extern uint16_t hd108_noise16_1d(
+    uint32_t x
+);
+
+
+/**
+ * @brief 2D value noise.
+ *
+ * @param x First coordinate, Q16.16.
+ * @param y Second coordinate, Q16.16.
+ *
+ * @return
+ *         - Noise value in the range [0 .. 65535].
+ */
+extern uint16_t hd108_noise16_2d(
+    uint32_t x,
+    uint32_t y
+);
+
+
+/**
+ * @brief 3D value noise.
+ *
+ * @param x First coordinate, Q16.16.
+ * @param y Second coordinate, Q16.16.
+ * @param z Third coordinate, Q16.16.
+ *
+ * @return
+ *         - Noise value in the range [0 .. 65535].
+ */
+extern uint16_t hd108_noise16_3d(
+    uint32_t x,
+    uint32_t y,
+    uint32_t z
+);
+
+
+/**
+ * @brief 2D value noise along a row.
+ *
+ * @note dst[i] = hd108_noise16_2d(x + i * dx, y) up to rounding. The lattice values are
+ *       hashed only when the row crosses a lattice line.
+ *
+ * @param dst Destination.
+ * @param count Number of noise values.
+ * @param x First coordinate of the first value, Q16.16.
+ * @param dx Increment of the first coordinate, Q16.16.
+ * @param y Second coordinate, Q16.16.
+ */
+extern void hd108_noise16_2d_row(
+    uint16_t *dst,
+    size_t count,
+    uint32_t x,
+    uint32_t dx,
+    uint32_t y
+);
+
+/**
+ * @brief 2D simplex noise.
+ *
+ * @note Coordinates are Q16.16 fixed-point numbers, the lattice distance is 1.0.
+ *       Gradient noise over a triangular grid: it has no axis-aligned artifacts
+ *       and sums 3 corners instead of the 4 of value noise.
+ *
+ * @param x First coordinate, Q16.16.
+ * @param y Second coordinate, Q16.16.
+ *
+ * @return
+ *         - Noise value in the range [0 .. 65535], 32768 on average.
+ */
+extern uint16_t hd108_simplex16_2d(
+    uint32_t x,
+    uint32_t y
+);
+
+
+/**
+ * @brief 3D simplex noise.
+ *
+ * @note It sums 4 corners of a tetrahedron, the third coordinate is usually
+ *       the time of an animated 2D field.
+ *
+ * @param x First coordinate, Q16.16.
+ * @param y Second coordinate, Q16.16.
+ * @param z Third coordinate, Q16.16.
+ *
+ * @return
+ *         - Noise value in the range [0 .. 65535], 32768 on average.
+ */
+extern uint16_t hd108_simplex16_3d(
+    uint32_t x,
+    uint32_t y,
+    uint32_t z
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_COLOR_H__ */
@@ -0,0 +1,124 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_COPY_H__
+#define __HD108_COPY_H__
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Possible backends of the copy engine.
+ */
+typedef enum {
+    HD108_COPY_AUTO             = 0,    ///< Async memcpy (GDMA or CP DMA) if the target has it, CPU otherwise
+    HD108_COPY_CPU              = 1     ///< CPU copy, e.g. on the linux target or for comparison
+} hd108_copy_backend_t;
+
+
+/**
+ * @brief Copy engine init.
+ *
+ * @note It creates a copy engine, which moves memory blocks in the background.
+ *       With the DMA backend the CPU is free while a copy is in progress,
+ *       with the CPU backend every copy is done by the time it is started.
+ *
+ * @param backend Backend of the engine.
+ * @param copy_out The address of the engine pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the backend is invalid
+ *         - HD108_LLD_ERROR_NO_DMA      if no DMA channel is available
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_copy_init(
+    hd108_copy_backend_t backend,
+    void **copy_out
+);
+
+
+/**
+ * @brief Start a copy.
+ *
+ * @note The copy is queued behind the copies in progress. If the DMA cannot
+ *       move the block (alignment, memory type, full queue) it is copied by
+ *       the CPU instead. A source in PSRAM shall be written back from the
+ *       cache before, e.g. with esp_cache_msync. Neither block shall be
+ *       touched until hd108_copy_wait returns.
+ *
+ * @param copy_in The address of the engine.
+ * @param dst Destination.
+ * @param src Source.
+ * @param len Number of bytes.
+ *
+ * @return
+ *         - true if the copy runs in the background, false if it has been done by the CPU.
+ */
+extern bool hd108_copy_start(
+    void *copy_in,
+    void *dst,
+    const void *src,
+    size_t len
+);
+
+
+/**
+ * @brief Wait until every started copy is done.
+ *
+ * @param copy_in The address of the engine.
+ */
+extern void hd108_copy_wait(
+    void *copy_in
+);
+
+
+/**
+ * @brief Copy engine deinit.
+ *
+ * @note It waits for the copies in progress and releases the engine.
+ *
+ * @param copy_in The address of the engine.
+ */
+extern void hd108_copy_deinit(
+    void *copy_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_COPY_H__ */
@@ -0,0 +1,102 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_DEDIC_H__
+#define __HD108_DEDIC_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Dedicated GPIO transport init.
+ *
+ * @note It creates a dedicated GPIO bundle of the data pins and the clock pin,
+ *       and allocates the transposed buffer. The bundle belongs to the CPU core
+ *       that calls the init, the transfers shall run on the same core.
+ *       Not every target has dedicated GPIO, see SOC_DEDICATED_GPIO_SUPPORTED.
+ *
+ * @param pin_clk Clock pin, shared by the lanes.
+ * @param pin_data Data pins of the lanes.
+ * @param lane_count Number of lanes [1 .. HD108_LLD_MAX_LANES].
+ * @param lane_len Number of bytes sent on each lane, without the 0 bytes at the beginning.
+ * @param dedic_out The address of the transport pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the target has no dedicated GPIO or a parameter is invalid
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_dedic_init(
+    uint8_t pin_clk,
+    const uint8_t *pin_data,
+    uint8_t lane_count,
+    uint32_t lane_len,
+    void **dedic_out
+);
+
+
+/**
+ * @brief Dedicated GPIO transport transfer.
+ *
+ * @note It transposes the lanes into one byte per bit time, then clocks out
+ *       the 0 bytes and the transposed buffer. The CPU is busy until the end
+ *       of the transfer, interrupts only stretch the clock. Lane k starts at
+ *       data + k * lane_len, the last lane may be shorter, it is padded with 0.
+ *
+ * @param dedic_in The address of the transport.
+ * @param data Data of the lanes back to back.
+ * @param data_len Number of bytes of data.
+ */
+extern void hd108_dedic_transmit(
+    void *dedic_in,
+    const uint8_t *data,
+    uint32_t data_len
+);
+
+
+/**
+ * @brief Dedicated GPIO transport deinit.
+ *
+ * @param dedic_in The address of the transport.
+ */
+extern void hd108_dedic_deinit(
+    void *dedic_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_DEDIC_H__ */
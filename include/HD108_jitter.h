@@ -0,0 +1,162 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_JITTER_H__
+#define __HD108_JITTER_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_JITTER_MIN_DEPTH      (       3UL)    ///< minimum number of frame slots
+#define HD108_JITTER_MAX_DEPTH      (      16UL)    ///< maximum number of frame slots
+
+
+/**
+ * @brief Jitter buffer configuration descriptor.
+ */
+typedef struct {
+    uint16_t    count;              ///< Number of pixels in one frame [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT]
+    uint8_t     depth;              ///< Number of frame slots [HD108_JITTER_MIN_DEPTH .. HD108_JITTER_MAX_DEPTH]
+    uint32_t    min_delay_us;       ///< Lower limit of the adaptive playout delay in microseconds
+    uint32_t    max_delay_us;       ///< Upper limit of the adaptive playout delay in microseconds
+    void       *arena;              ///< Arena of the frame slots (HD108_arena.h), NULL for the heap
+} hd108_jitter_configuration_t;
+
+
+/**
+ * @brief Jitter buffer statistics.
+ */
+typedef struct {
+    uint32_t    delay_us;           ///< Current playout delay
+    uint32_t    jitter_us;          ///< Smoothed arrival jitter
+    uint32_t    interval_us;        ///< Smoothed frame interval of the input stream
+    uint32_t    frames;             ///< Number of frames pushed
+    uint32_t    underruns;          ///< Number of output slots where the newest frame had to be held
+    uint32_t    overruns;           ///< Number of frames dropped because all slots were in use
+} hd108_jitter_stats_t;
+
+
+/**
+ * @brief Jitter buffer init.
+ *
+ * @note It creates the jitter buffer on heap including the frame slots.
+ *       The jitter buffer is placed between network receivers and the driver,
+ *       frames are pushed by the receivers and rendered by the update function.
+ *
+ * @param jitter_configuration Pointer to the configuration struct. After the initialization
+ *                             the struct is not used.
+ * @param jitter_out The address of the jitter buffer pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if the frame length is out of range [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT]
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_jitter_init(
+    const hd108_jitter_configuration_t *jitter_configuration,
+    void **jitter_out
+);
+
+
+/**
+ * @brief Push a received frame into the jitter buffer.
+ *
+ * @note The frame is timestamped with the time of arrival. If all slots are
+ *       in use the oldest frame is dropped. It can be called from any task.
+ *
+ * @param jitter_in The address of the jitter buffer.
+ * @param frame Pointer to the frame, count pixels.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if frame is NULL
+ */
+extern hd108_status_t hd108_jitter_push(
+    void *jitter_in,
+    const hd108_pixel_t *frame
+);
+
+
+/**
+ * @brief Render the current output frame.
+ *
+ * @note It shall be called from the update function of the driver. It looks up
+ *       the two received frames around the playout time (now - delay) and writes
+ *       the interpolated frame into the TX buffer of the context.
+ *
+ * @param jitter_in The address of the jitter buffer.
+ * @param ctx_in The address of the driver context.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the frame is longer than the strip
+ */
+extern hd108_status_t hd108_jitter_render(
+    void *jitter_in,
+    void *ctx_in
+);
+
+
+/**
+ * @brief Get jitter buffer statistics.
+ *
+ * @param jitter_in The address of the jitter buffer.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ */
+extern void hd108_jitter_get_stats(
+    void *jitter_in,
+    hd108_jitter_stats_t *stats_out
+);
+
+/**
+ * @brief Jitter buffer deinit.
+ *
+ * @note It waits for a push or render in progress, then frees the jitter
+ *       buffer. The frame slots are returned to the arena or the heap. The
+ *       receivers and the update function shall not use the jitter buffer any
+ *       more, e.g. the strip is removed with hd108_lld_deinit first.
+ *
+ * @param jitter_in The address of the jitter buffer.
+ */
+extern void hd108_jitter_deinit(
+    void *jitter_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_JITTER_H__ */
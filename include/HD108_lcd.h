@@ -0,0 +1,87 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_LCD_H__
+#define __HD108_LCD_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_lcd_types.h"
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief esp_lcd panel configuration descriptor.
+ */
+typedef struct {
+    void       *map;                ///< The address of the 2D mapping, see HD108_map2d.h
+    uint8_t     bits_per_pixel;     ///< Color depth of the bitmaps, 16 (RGB565) or 24 (RGB888)
+    bool        swap_bytes;         ///< RGB565 bitmaps are big endian (LVGL LV_COLOR_16_SWAP)
+    uint16_t    current;            ///< Current levels for every pixel, see HD108_LLD_CURRENT
+} hd108_lcd_configuration_t;
+
+
+/**
+ * @brief esp_lcd panel init.
+ *
+ * @note It creates an esp_lcd panel on top of a 2D mapping. The draw_bitmap
+ *       operation converts just the drawn rectangle into the TX buffer of the
+ *       context, so partial redraws touch only the affected LEDs and no
+ *       framebuffer copy is needed. Drawing is synchronous, the LVGL flush
+ *       can be reported as ready right after esp_lcd_panel_draw_bitmap
+ *       returns. As the panel is drawn from the LVGL task the context shall
+ *       be in live write mode.
+ *       Mirror, swap_xy and invert_color are supported, the rectangle is
+ *       then written pixel by pixel. Switching the display off clears the
+ *       matrix and ignores draws until it is switched on again.
+ *
+ * @param lcd_configuration Pointer to the configuration struct. After the initialization
+ *                          the struct is not used.
+ * @param panel_out The address of the panel handle.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_lcd_init(
+    const hd108_lcd_configuration_t *lcd_configuration,
+    esp_lcd_panel_handle_t *panel_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_LCD_H__ */
@@ -30,7 +30,9 @@
 
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "driver/spi_master.h"
+#include "HD108_types.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -38,70 +40,49 @@ extern "C"
 #endif
 
 
-#define HD108_LLD_MIN_COUNT         (       1UL)    ///< minimum number of LEDs
-#define HD108_LLD_MAX_COUNT         (    1024UL)    ///< maximum number of LEDs
 #define HD108_LLD_MAX_SPI_SPEED     (40000000UL)    ///< maximum SPI speed 40MHz
+#define HD108_LLD_MAX_LANES         (       7UL)    ///< maximum number of data lanes of the dedicated GPIO transport,
+                                                    ///< the clock takes the 8th channel of the bundle
 
 
 /**
- * @brief Possible return values of interface functions.
+ * @brief Possible interpolations of spatial upsampling.
  */
 typedef enum {
-    HD108_LLD_OK                = 0,    ///< OK
-    HD108_LLD_ERROR_UNKNOWN     = 1,    ///< Unknown error
-    HD108_LLD_ERROR_INVALID     = 2,    ///< Invalid argument is provided
-    HD108_LLD_ERROR_SPI_IN_USE  = 3,    ///< SPI allocation error
-    HD108_LLD_ERROR_NO_DMA      = 4,    ///< DMA allocation error
-    HD108_LLD_ERROR_NO_MEMORY   = 5,    ///< Memory allocation error
-    HD108_LLD_ERROR_NO_CS       = 6,    ///< SPI host doesn't have any free CS slots
-    HD108_LLD_ERROR_LENGTH      = 7,    ///< Length of the strip is out of range [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT]
-    HD108_LLD_ERROR_INDEX       = 8,    ///< Index is out of range.
-    HD108_LLD_ERROR_DATA_RATE   = 9     ///< SPI clock speed is too low for the desired update frequency.
-} hd108_status_t;
+    HD108_LLD_UPSAMPLE_LINEAR   = 0,    ///< Linear interpolation
+    HD108_LLD_UPSAMPLE_CUBIC    = 1     ///< Catmull-Rom (cubic) interpolation of the color values
+} hd108_upsample_t;
 
 
 /**
- * @brief Possible LED strip update values in Hz.
+ * @brief Possible transports.
  */
 typedef enum {
-    HD108_LLD_UPDATE_1HZ        =   1,  ///<   1Hz
-    HD108_LLD_UPDATE_2HZ        =   2,  ///<   2Hz
-    HD108_LLD_UPDATE_5HZ        =   5,  ///<   5Hz
-    HD108_LLD_UPDATE_10HZ       =  10,  ///<  10Hz
-    HD108_LLD_UPDATE_20HZ       =  20,  ///<  20Hz
-    HD108_LLD_UPDATE_24HZ       =  24,  ///<  24Hz
-    HD108_LLD_UPDATE_25HZ       =  25,  ///<  25Hz
-    HD108_LLD_UPDATE_30HZ       =  30,  ///<  30Hz
-    HD108_LLD_UPDATE_50HZ       =  50,  ///<  50Hz
-    HD108_LLD_UPDATE_60HZ       =  60,  ///<  60Hz
-    HD108_LLD_UPDATE_100HZ      = 100,  ///< 100Hz
-    HD108_LLD_UPDATE_120HZ      = 120   ///< 120Hz
-} hd108_update_frequency_hz_t;
+    HD108_LLD_TRANSPORT_SPI         = 0,    ///< SPI master with DMA
+    HD108_LLD_TRANSPORT_DEDIC_GPIO  = 1     ///< Dedicated GPIO driven by the CPU, one clock and up to HD108_LLD_MAX_LANES data lanes
+} hd108_transport_t;
 
 
 /**
- * @brief New type for red/green/blue color value.
+ * @brief Possible frame layouts.
  */
-typedef uint16_t hd108_color_t;
-
+typedef enum {
+    HD108_LLD_LAYOUT_PIXEL      = 0,    ///< Pixels are written into the TX buffer one by one
+    HD108_LLD_LAYOUT_PLANAR     = 1,    ///< Separate red, green, blue and current planes, interleaved after the update function
+    HD108_LLD_LAYOUT_COMPACT    = 2     ///< 3 bytes per LED and one current for the strip, expanded chunk by chunk during the transfer
+} hd108_layout_t;
 
-/**
- * @brief New type for driving current value.
- */
-typedef uint16_t hd108_current_t;
 
 /**
- * @brief Pixel descriptor for one LED.
+ * @brief Statistics of a shared SPI bus.
  */
 typedef struct {
-    hd108_current_t cl_blue  :5;    ///< current level for blue
-    hd108_current_t cl_green :5;    ///< current level for green
-    hd108_current_t cl_red   :5;    ///< current level for red
-    hd108_current_t          :1;    ///< restricted (start bit in SPI data)
-    hd108_color_t   red;            ///< color value for red
-    hd108_color_t   green;          ///< color value for green
-    hd108_color_t   blue;           ///< color value for blue
-} hd108_pixel_t;
+    uint32_t        frames;         ///< Number of frames sent
+    uint32_t        wait_last_us;   ///< Time the last frame waited for the bus
+    uint32_t        wait_max_us;    ///< Longest wait for the bus
+    uint64_t        wait_total_us;  ///< Sum of the waits for the bus
+    uint32_t        errors;         ///< Number of transactions refused by the SPI master, e.g. longer than max_transfer_sz
+} hd108_bus_stats_t;
 
 
 /**
@@ -120,10 +101,61 @@ typedef struct {
     uint32_t                    spi_speed_hz;       ///< Clock speed of the SPI bus
     uint8_t                     pin_mosi;           ///< MOSI PIN number
     uint8_t                     pin_clk;            ///< CLK PIN number
+    bool                        spi_bus_shared;     ///< The SPI bus is initialized by the application and shared with other
+                                                    ///< devices, e.g. a display. The driver only adds its device and holds the
+                                                    ///< bus for the duration of each frame, the others use the gaps between the
+                                                    ///< frames. The pins of the configuration are not used, the max_transfer_sz
+                                                    ///< of the bus shall fit the frame, it is checked by the init.
+                                                    ///< HD108 has no chip select: the LEDs clock in the traffic of the other
+                                                    ///< devices and latch it as colors, so the clock and data lines of the
+                                                    ///< strip shall be gated, see spi_bus_gate.
+    bool                        spi_bus_gate;       ///< Shared bus: pin_gate is driven as the CS line of the device, low during
+                                                    ///< the frames, to enable a buffer (e.g. 74HC125) between the bus and the strip
+    uint8_t                     pin_gate;           ///< Gate PIN number, see spi_bus_gate
     uint16_t                    count;              ///< Number of LEDs to be controlled [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT].
                                                     ///< The upper limit is coming from the data sheet.
     hd108_update_frequency_hz_t frequency_hz;       ///< Update frequency of the LEDs
     callback_update             update_function;    ///< Update function. It is called when LED update is possible.
+                                                    ///< Optional (can be NULL) in live write mode.
+    bool                        live_write;         ///< Live write mode. Pixels can be written from any task at any time,
+                                                    ///< even while a transfer is in flight. Each pixel is written
+                                                    ///< tear-free, see hd108_lld_set_pixel.
+    uint8_t                     keyframe_divider;   ///< Frame-rate upconversion. If it is greater than 1 the update function
+                                                    ///< is called only on every keyframe_divider-th update and renders a
+                                                    ///< keyframe, the driver blends the last two keyframes for every update.
+                                                    ///< Cannot be used together with live write mode.
+    uint16_t                    render_count;       ///< Spatial upsampling. If it is not 0 the update function renders only
+                                                    ///< render_count pixels [HD108_LLD_MIN_COUNT .. count], the driver
+                                                    ///< upsamples them to the whole strip while encoding.
+                                                    ///< Cannot be used together with live write mode.
+    hd108_upsample_t            upsample;           ///< Interpolation of spatial upsampling
+    hd108_layout_t              layout;             ///< Frame layout. The planar and compact layouts cannot be used together
+                                                    ///< with live write mode, frame-rate upconversion or spatial upsampling.
+    uint16_t                    compact_current;    ///< Compact layout: current levels of every LED, see HD108_LLD_CURRENT
+    const uint16_t             *compact_lut;        ///< Compact layout: expansion of 8-bit values to 16-bit, 256 entries, e.g. a
+                                                    ///< gamma curve. NULL for bit replication. It is copied by the init.
+    hd108_transport_t           transport;          ///< Transport. With dedicated GPIO the SPI host and speed are not used, the
+                                                    ///< bit rate is set by the CPU clock, at most HD108_LLD_MAX_SPI_SPEED.
+                                                    ///< The init shall run on the core of the updates, e.g. core 0 for the
+                                                    ///< esp_timer task, or the core of the hd108_sched_init or hd108_sync_init.
+    uint8_t                     lane_count;         ///< Dedicated GPIO: number of data lanes [1 .. HD108_LLD_MAX_LANES], 0 is 1.
+                                                    ///< The strip is split evenly, lane k drives the k-th part of the LEDs.
+    const uint8_t              *pin_lanes;          ///< Dedicated GPIO: data pins of the lanes, NULL for a single lane on pin_mosi
+    bool                        external_update;    ///< The driver does not start its own timer, hd108_lld_update shall be
+                                                    ///< called for every update, e.g. by the scheduler (HD108_sched.h).
+                                                    ///< frequency_hz is the nominal update frequency.
+    bool                        async_copy;         ///< Frames are loaded with async memcpy (GDMA) in the background,
+                                                    ///< see hd108_lld_load_frame. Falls back to CPU copy if the
+                                                    ///< target has no async memcpy.
+    bool                        dirty_tracking;     ///< A transfer sends the LEDs up to the last one written since the previous
+                                                    ///< transfer, and is skipped if no LED was written. The LEDs behind keep
+                                                    ///< their values. Pixel layout only, cannot be used together with
+                                                    ///< frame-rate upconversion or spatial upsampling.
+    void                       *arena;              ///< Arena of the buffers (HD108_arena.h), NULL for the heap. The TX buffer
+                                                    ///< needs DMA capable memory, the arena shall outlive the context.
+    bool                        refresh_on_change;  ///< Refresh on change. The LEDs are sent only after pixels are written, at most
+                                                    ///< once per update period, there is no timer wake-up while the content is
+                                                    ///< static. Live write mode only, without update function and external updates.
 } hd108_configuration_t;
 
 
@@ -143,11 +175,11 @@ typedef struct {
  * @return
  *         - HD108_LLD_OK                on success
  *         - HD108_LLD_ERROR_UNKNOWN     if unknown error occured
- *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid, or the max_transfer_sz of a shared bus is too short
  *         - HD108_LLD_ERROR_SPI_IN_USE  if the selected spi host is already in use
  *         - HD108_LLD_ERROR_NO_DMA      if all the DMAs are used
  *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
- *         - HD108_LLD_ERROR_NO_CS       if the SPI host doesn't have any free CS slots (should not happen)
+ *         - HD108_LLD_ERROR_NO_CS       if the SPI host doesn't have any free CS slots (only if the bus is shared)
  *         - HD108_LLD_ERROR_LENGTH      if the length of the strip is out of range [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT]
  *         - HD108_LLD_ERROR_DATA_RATE   if SPI clock speed is too low for the desired update frequency
  */
@@ -157,15 +189,129 @@ extern hd108_status_t hd108_lld_init(
 );
 
 
+/**
+ * @brief HD108 LED (strip) deinit.
+ *
+ * @note It waits until a running update has returned, stops the timer and
+ *       waits until a timer callback in flight has returned, then deletes
+ *       the timer, removes the SPI device and frees the SPI bus unless it is
+ *       shared. Finally the buffers are returned to the heap or the arena.
+ *       Writes shall not run concurrently with the deinit. With external
+ *       updates hd108_lld_update shall not be called any more: a context run
+ *       by the scheduler or the sync input shall be detached first with
+ *       hd108_sched_remove or hd108_sync_deinit. The context cannot be used
+ *       after the deinit.
+ *
+ * @param ctx_in The address of the context.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ */
+extern hd108_status_t hd108_lld_deinit(
+    void *ctx_in
+);
+
+
+/**
+ * @brief HD108 LED (strip) update.
+ *
+ * @note It does what the timer does for every update: it sends the TX buffer,
+ *       waits until the transfer is done, then calls the update function for
+ *       the next one. It returns when the update function has returned.
+ *       It shall be called from a single task.
+ *
+ * @param ctx_in The address of the context.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the context is updated by its own timer
+ */
+extern hd108_status_t hd108_lld_update(
+    void *ctx_in
+);
+
+
+/**
+ * @brief HD108 LED (strip) profiler.
+ *
+ * @note It attaches a profiler (HD108_prof.h) to the context. The driver times
+ *       its stages for every update: transfer, update function and encode, and
+ *       closes the frame of the profiler after the update, so the scopes of the
+ *       update function are reported together with the stages. NULL detaches it.
+ *       It shall be called before the first update or from the update function.
+ *
+ * @param ctx_in The address of the context.
+ * @param prof_in The address of the profiler, or NULL.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ */
+extern hd108_status_t hd108_lld_set_profiler(
+    void *ctx_in,
+    void *prof_in
+);
+
+
+/**
+ * @brief HD108 LED (strip) transfer start.
+ *
+ * @note It returns the time (esp_timer_get_time) when the transfer of the
+ *       last update started on the bus, taken in the pre-transaction callback
+ *       of the SPI master, or right before the transfer with dedicated GPIO.
+ *       It waits for an update in flight, so it shall not be called from the
+ *       update function.
+ *
+ * @param ctx_in The address of the context.
+ * @param start_out Pointer to the start time to be filled, 0 if the last update sent nothing.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ */
+extern hd108_status_t hd108_lld_get_transfer_start(
+    void *ctx_in,
+    int64_t *start_out
+);
+
+
+/**
+ * @brief HD108 shared SPI bus statistics.
+ *
+ * @note It reports how long the frames waited for the bus, e.g. behind the
+ *       transactions of a display on the same host, and the transactions
+ *       that the SPI master refused.
+ *
+ * @param ctx_in The address of the context.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the bus is not shared
+ */
+extern hd108_status_t hd108_lld_get_bus_stats(
+    void *ctx_in,
+    hd108_bus_stats_t *stats_out
+);
+
+
 /**
  * @brief HD108 LED (pixel) update.
  *
  * @note It updates the value of a pixel in the TX buffer.
+ *       If frame-rate upconversion is enabled it updates the pixel in the next keyframe.
+ *       If spatial upsampling is enabled the index addresses the rendered pixels
+ *       [0 .. render_count - 1] instead of the LEDs.
+ *       If the layout is planar it updates the planes.
+ *       If the layout is compact it stores the upper 8 bits of the colors, the current
+ *       levels of the pixel are ignored.
+ *       The pixel is written with two aligned 32-bit stores followed by a release fence.
+ *       A color channel is never torn. In live write mode a transfer that is in flight
+ *       may carry the new start bit, current levels and red value together with the
+ *       previous green and blue values, the next transfer carries the complete pixel.
  *
  * @param ctx_in The address of the context.
  * @param index The index of the LED within the strip.
  * @param pixel Pointer to the pixel data.
- *              The first bit in the data field is always set by the function.
+ *              The start bit is always set in the TX buffer, the source is not modified.
  * 
  * @return
  *         - HD108_LLD_OK                on success
@@ -174,7 +320,345 @@ extern hd108_status_t hd108_lld_init(
 extern hd108_status_t hd108_lld_set_pixel(
     void *ctx_in,
     uint16_t index,
-    hd108_pixel_t *pixel
+    const hd108_pixel_t *pixel
+);
+
+
+/**
+ * @brief HD108 LED (strip) bulk write of RGB565 pixels.
+ *
+ * @note It writes count pixels starting at index first. The range is checked
+ *       once, each pixel is converted and encoded in a single pass. The color
+ *       values are expanded to 16-bit by bit replication. It can be used
+ *       wherever hd108_lld_set_pixel can be used.
+ *
+ * @param ctx_in The address of the context.
+ * @param first The index of the first LED.
+ * @param count Number of pixels.
+ * @param src Pixels in RGB565 format, native endianness.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+extern hd108_status_t hd108_lld_write_rgb565(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const uint16_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) bulk write of RGB888 pixels.
+ *
+ * @note Same as hd108_lld_write_rgb565, but the source is 3 bytes per pixel,
+ *       in the order red, green, blue. In compact layout the pixels are
+ *       copied into the frame as they are.
+ */
+extern hd108_status_t hd108_lld_write_rgb888(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const uint8_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) bulk write of RGBA8888 pixels.
+ *
+ * @note Same as hd108_lld_write_rgb565, but the source is 4 bytes per pixel,
+ *       in the order red, green, blue, alpha. The colors are multiplied by alpha.
+ */
+extern hd108_status_t hd108_lld_write_rgba8888(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const uint8_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) bulk write of RGB48 pixels.
+ *
+ * @note Same as hd108_lld_write_rgb565, but the source is 3 x 16-bit per pixel,
+ *       in the order red, green, blue, native endianness.
+ */
+extern hd108_status_t hd108_lld_write_rgb48(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const uint16_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) bulk write of float pixels.
+ *
+ * @note Same as hd108_lld_write_rgb565, but the source is 3 floats per pixel,
+ *       in the order red, green, blue. Values are clamped to [0.0 .. 1.0].
+ */
+extern hd108_status_t hd108_lld_write_float(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const float *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) scatter write.
+ *
+ * @note It writes a list of pixels to arbitrary LEDs, e.g. the few hundred LEDs
+ *       of a sensor-driven frame. The whole batch is checked first, nothing is
+ *       written if one of the indices is out of range. Indices address the LEDs
+ *       like hd108_lld_set_pixel does; if an index is repeated the last pixel
+ *       wins. Each pixel is written tear-free like by hd108_lld_set_pixel, with
+ *       one release fence for the batch. With dirty tracking the next transfer
+ *       ends at the highest index. An empty batch writes nothing and does not
+ *       trigger a refresh on change.
+ *
+ * @param ctx_in The address of the context.
+ * @param indices Indices of the LEDs.
+ * @param pixels Pixels, pixels[i] is written to the LED indices[i].
+ * @param count Number of pixels.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if one of the indices is out of range
+ */
+extern hd108_status_t hd108_lld_scatter(
+    void *ctx_in,
+    const uint16_t *indices,
+    const hd108_pixel_t *pixels,
+    uint16_t count
+);
+
+
+/**
+ * @brief Sort a scatter list by index.
+ *
+ * @note It sorts the indices and the pixels together in place, so that
+ *       hd108_lld_scatter writes the TX buffer in ascending order. The sort
+ *       is not stable, a list with repeated indices shall not be sorted.
+ *
+ * @param indices Indices of the LEDs.
+ * @param pixels Pixels of the LEDs.
+ * @param count Number of pixels.
+ */
+extern void hd108_lld_scatter_sort(
+    uint16_t *indices,
+    hd108_pixel_t *pixels,
+    uint16_t count
+);
+
+
+/**
+ * @brief HD108 LED (strip) resolution update.
+ *
+ * @note It changes the number of pixels rendered by the update function, so the
+ *       resolution can be traded for frame rate at runtime. It shall be called
+ *       from the update function. The current frame is finished with the old
+ *       resolution, the new one is applied before the next update function call.
+ *       With frame-rate upconversion the first keyframe of the new resolution
+ *       is held instead of blended. Spatial upsampling shall be enabled by the
+ *       configuration.
+ *
+ * @param ctx_in The address of the context.
+ * @param render_count Number of rendered pixels [HD108_LLD_MIN_COUNT .. count].
+ * @param upsample Interpolation of spatial upsampling.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if spatial upsampling is not enabled or the interpolation is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if render_count is out of range
+ */
+extern hd108_status_t hd108_lld_set_resolution(
+    void *ctx_in,
+    uint16_t render_count,
+    hd108_upsample_t upsample
+);
+
+
+/**
+ * @brief HD108 LED (strip) planes.
+ *
+ * @note It provides the planes of the planar frame. The planes can be written
+ *       in the update function, for example with the kernels of HD108_color.h.
+ *       After the update function the driver interleaves the planes, swaps
+ *       the bytes and adds the start bits into the TX buffer in a single pass.
+ *       The planes are valid until the context exists.
+ *
+ * @param ctx_in The address of the context.
+ * @param planes_out Pointer to the planes struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the layout is not planar
+ */
+extern hd108_status_t hd108_lld_get_planes(
+    void *ctx_in,
+    hd108_planes_t *planes_out
+);
+
+
+
+/**
+ * @brief HD108 LED (strip) current of the compact layout.
+ *
+ * @note It sets the current levels of every LED, they are used from the next
+ *       transfer on. In compact layout the current levels of the written
+ *       pixels are ignored.
+ *
+ * @param ctx_in The address of the context.
+ * @param current Current levels, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the layout is not compact
+ */
+extern hd108_status_t hd108_lld_set_compact_current(
+    void *ctx_in,
+    uint16_t current
+);
+
+
+/**
+ * @brief HD108 LED (strip) frame capture.
+ *
+ * @note It copies LEDs of the TX buffer in wire format, e.g. into a frame cache
+ *       in PSRAM. The captured frame can be loaded later with hd108_lld_load_frame
+ *       without encoding it again.
+ *
+ * @param ctx_in The address of the context.
+ * @param first Index of the first LED.
+ * @param count Number of LEDs.
+ * @param dst Destination, HD108_LLD_FRAME_SIZE(count) bytes.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the layout is compact, there is no complete TX buffer
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+extern hd108_status_t hd108_lld_capture_frame(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    void *dst
+);
+
+
+/**
+ * @brief HD108 LED (strip) frame load.
+ *
+ * @note It copies a frame in wire format, captured with hd108_lld_capture_frame,
+ *       into the TX buffer. With async copy the copy is started in the background
+ *       and the CPU returns at once, the next transfer is queued only after the
+ *       copy is done. A source in PSRAM shall be aligned to 64 bytes and written
+ *       back from the cache to be moved by DMA, otherwise the CPU copies it.
+ *       The source shall not be changed until the next transfer has started.
+ *       It cannot be used with frame-rate upconversion, spatial upsampling,
+ *       planar or compact layout, because those build the TX buffer after the
+ *       update function.
+ *
+ * @param ctx_in The address of the context.
+ * @param first Index of the first LED.
+ * @param count Number of LEDs.
+ * @param src Source, HD108_LLD_FRAME_SIZE(count) bytes.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the TX buffer is built after the update function
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+extern hd108_status_t hd108_lld_load_frame(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    const void *src
+);
+
+
+
+/**
+ * @brief Current levels of a pixel in wire format, see hd108_lld_encode_pixel.
+ *          It carries the start bit and is byte swapped, so it is computed once per frame.
+ */
+#define HD108_LLD_WIRE_CURRENT(current) \
+    ((uint32_t)__builtin_bswap16((uint16_t)((current) | 0x8000U)))
+
+
+/**
+ * @brief Encode one pixel in wire format.
+ *
+ * @note The pixel is written with two aligned 32-bit stores like
+ *       hd108_lld_set_pixel does, the first one carries the start bit, the
+ *       current levels and red, the second one green and blue.
+ *
+ * @param wire_current Current levels, see HD108_LLD_WIRE_CURRENT.
+ * @param red Color value for red.
+ * @param green Color value for green.
+ * @param blue Color value for blue.
+ * @param dst Destination, 2 words of a frame in wire format.
+ */
+static inline void hd108_lld_encode_pixel(uint32_t wire_current, hd108_color_t red, hd108_color_t green, hd108_color_t blue, volatile uint32_t *dst) {
+    dst[0] = wire_current | ((uint32_t)__builtin_bswap16(red) << 16);
+    dst[1] = __builtin_bswap16(green) | ((uint32_t)__builtin_bswap16(blue) << 16);
+}
+
+
+/**
+ * @brief HD108 LED (strip) direct frame access.
+ *
+ * @note It returns the LEDs of the TX buffer in wire format, 2 words per LED,
+ *       so a renderer can encode its pixels in place with hd108_lld_encode_pixel
+ *       instead of staging them for a bulk write. hd108_lld_close_frame shall
+ *       be called after the pixels are written. It has the same restrictions
+ *       as hd108_lld_load_frame.
+ *
+ * @param ctx_in The address of the context.
+ * @param first Index of the first LED.
+ * @param count Number of LEDs.
+ * @param frame_out Out parameter for the first word of LED first.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the TX buffer is built after the update function
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+extern hd108_status_t hd108_lld_open_frame(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count,
+    uint32_t **frame_out
+);
+
+
+/**
+ * @brief HD108 LED (strip) end of direct frame access.
+ *
+ * @note It publishes the pixels written since hd108_lld_open_frame like the
+ *       bulk writes do: a release fence, then the LEDs are marked for dirty
+ *       tracking and refresh on change.
+ *
+ * @param ctx_in The address of the context.
+ * @param first Index of the first LED.
+ * @param count Number of LEDs.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+extern hd108_status_t hd108_lld_close_frame(
+    void *ctx_in,
+    uint16_t first,
+    uint16_t count
 );
 
 #ifdef __cplusplus
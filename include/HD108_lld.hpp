@@ -0,0 +1,256 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_LLD_HPP__
+#define __HD108_LLD_HPP__
+
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include "esp_timer.h"
+#include "HD108_lld.h"
+
+
+namespace hd108 {
+
+
+/**
+ * @brief Frame information, the result of co_await next_frame().
+ */
+struct frame_info {
+    uint32_t    frame;              ///< Number of the frame since the executor has started
+    int64_t     time_us;            ///< Time of the update function, see esp_timer_get_time
+};
+
+
+class executor;
+
+
+/**
+ * @brief Effect coroutine.
+ *          A function returning effect is a coroutine, it is started by
+ *          executor::spawn and renders a frame between two co_await
+ *          next_frame(). It does not need a task or a stack of its own,
+ *          its state is kept in the coroutine frame on the heap.
+ */
+class effect {
+public:
+    /**
+     * @brief Promise of the effect coroutine.
+     */
+    struct promise_type {
+        promise_type   *next = nullptr;     ///< Next effect waiting for the same frame
+
+        effect get_return_object() noexcept {
+            return effect(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    effect(effect &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    effect(const effect &) = delete;
+    effect &operator=(const effect &) = delete;
+    effect &operator=(effect &&) = delete;
+
+    /**
+     * @brief Destroys the coroutine if it has not been spawned.
+     */
+    ~effect() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+private:
+    friend class executor;
+
+    explicit effect(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;    ///< Coroutine, empty after spawn
+};
+
+
+/**
+ * @brief Executor of effect coroutines.
+ *          The effects waiting for the next frame are resumed one after the
+ *          other by run_frame, which is called from the update function of
+ *          the context, see hd108::update. The frame pacing stays with the
+ *          driver: its timer, the scheduler or the sync input.
+ */
+class executor {
+public:
+    executor() = default;
+    executor(const executor &) = delete;
+    executor &operator=(const executor &) = delete;
+
+    /**
+     * @brief Destroys the waiting effects.
+     */
+    ~executor() {
+        effect::promise_type *promise = waiting_.exchange(nullptr, std::memory_order_acquire);
+        while (nullptr != promise) {
+            effect::promise_type *next = promise->next;
+            std::coroutine_handle<effect::promise_type>::from_promise(*promise).destroy();
+            promise = next;
+        }
+    }
+
+    /**
+     * @brief Start an effect.
+     *
+     * @note The effect runs from the next frame on, in the context of the
+     *       update function. It may be called from any task.
+     *
+     * @param e The effect, it is moved into the executor.
+     */
+    void spawn(effect &&e) noexcept {
+        push(std::exchange(e.handle_, {}).promise());
+    }
+
+    /**
+     * @brief Run one frame.
+     *
+     * @note It resumes every effect that waits for the next frame, in the order
+     *       they started waiting. An effect that awaits next_frame again waits
+     *       for the following frame, a finished effect is freed.
+     */
+    void run_frame() noexcept {
+        effect::promise_type *promise = waiting_.exchange(nullptr, std::memory_order_acquire);
+        effect::promise_type *fifo = nullptr;
+
+        // the waiting list is a stack, reverse it
+        while (nullptr != promise) {
+            effect::promise_type *next = promise->next;
+            promise->next = fifo;
+            fifo = promise;
+            promise = next;
+        }
+
+        info_.frame = frame_++;
+        info_.time_us = esp_timer_get_time();
+
+        while (nullptr != fifo) {
+            promise = fifo;
+            fifo = promise->next;
+            std::coroutine_handle<effect::promise_type>::from_promise(*promise).resume();
+        }
+    }
+
+    /**
+     * @brief Awaitable of the next frame.
+     *
+     * @note co_await next_frame() suspends the effect until the TX buffer can
+     *       be written again and returns the frame information.
+     */
+    auto next_frame() noexcept {
+        struct awaiter {
+            executor &exec;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<effect::promise_type> handle) noexcept { exec.push(handle.promise()); }
+            frame_info await_resume() const noexcept { return exec.info_; }
+        };
+        return awaiter{*this};
+    }
+
+private:
+    /**
+     * @brief Add an effect to the waiting list, lock-free.
+     */
+    void push(effect::promise_type &promise) noexcept {
+        promise.next = waiting_.load(std::memory_order_relaxed);
+        while (!waiting_.compare_exchange_weak(promise.next, &promise, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::atomic<effect::promise_type *> waiting_{nullptr};  ///< Effects waiting for the next frame, newest first
+    frame_info  info_{};            ///< Information of the current frame
+    uint32_t    frame_ = 0;         ///< Number of the next frame
+};
+
+
+/**
+ * @brief Update function of an executor.
+ *          The update function of the C driver has no argument, this template
+ *          binds it to an executor of static storage duration, e.g.
+ *          .update_function = hd108::update<exec>.
+ */
+template <executor &exec>
+void update() {
+    exec.run_frame();
+}
+
+
+/**
+ * @brief LED strip of an effect.
+ *          Thin wrapper of a context initialized with the update function of
+ *          its executor.
+ */
+class strip {
+public:
+    strip(void *ctx, executor &exec) noexcept : ctx_(ctx), exec_(exec) {}
+
+    /**
+     * @brief Awaitable of the next frame, see executor::next_frame.
+     */
+    auto next_frame() noexcept { return exec_.next_frame(); }
+
+    /**
+     * @brief See hd108_lld_set_pixel.
+     */
+    hd108_status_t set_pixel(uint16_t index, const hd108_pixel_t &pixel) noexcept {
+        return hd108_lld_set_pixel(ctx_, index, &pixel);
+    }
+
+    /**
+     * @brief See hd108_lld_write_rgb48.
+     */
+    hd108_status_t write_rgb48(uint16_t first, uint16_t count, const uint16_t *src, uint16_t current) noexcept {
+        return hd108_lld_write_rgb48(ctx_, first, count, src, current);
+    }
+
+    /**
+     * @brief The address of the context, for the other functions of the driver.
+     */
+    void *ctx() const noexcept { return ctx_; }
+
+private:
+    void       *ctx_;               ///< The address of the context
+    executor   &exec_;              ///< Executor of the update function of the context
+};
+
+} // namespace hd108
+
+#endif /* __HD108_LLD_HPP__ */
@@ -0,0 +1,188 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_MAP2D_H__
+#define __HD108_MAP2D_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_MAP2D_NO_LED          (  0xffffU)     ///< index of a matrix position without LED
+#define HD108_MAP2D_MAX_SIZE        (    1024UL)    ///< maximum width and height of the matrix
+
+
+/**
+ * @brief Possible wirings of the matrix rows.
+ */
+typedef enum {
+    HD108_MAP2D_PROGRESSIVE     = 0,    ///< Every row runs from left to right
+    HD108_MAP2D_SERPENTINE      = 1,    ///< Even rows run from left to right, odd rows from right to left
+    HD108_MAP2D_TABLE           = 2     ///< Index of every position is given by a table
+} hd108_map2d_order_t;
+
+
+/**
+ * @brief 2D mapping configuration descriptor.
+ */
+typedef struct {
+    void                   *ctx;        ///< The address of the driver context
+    uint16_t                width;      ///< Width of the matrix [1 .. HD108_MAP2D_MAX_SIZE]
+    uint16_t                height;     ///< Height of the matrix [1 .. HD108_MAP2D_MAX_SIZE]
+    uint16_t                first;      ///< Index of the LED at position (0, 0) for progressive and serpentine wiring
+    hd108_map2d_order_t     order;      ///< Wiring of the matrix rows
+    const uint16_t         *table;      ///< Index of each position row by row, width x height entries, only for table
+                                        ///< wiring. HD108_MAP2D_NO_LED marks a position without LED. The table is
+                                        ///< not copied, it shall be valid until the mapping exists.
+} hd108_map2d_configuration_t;
+
+
+/**
+ * @brief 2D mapping init.
+ *
+ * @note It creates the mapping on heap, including a row buffer of width pixels.
+ *
+ * @param map2d_configuration Pointer to the configuration struct. After the initialization
+ *                            the struct is not used.
+ * @param map_out The address of the mapping pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if the width or the height is out of range
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_map2d_init(
+    const hd108_map2d_configuration_t *map2d_configuration,
+    void **map_out
+);
+
+
+/**
+ * @brief Index of the LED at a matrix position.
+ *
+ * @param map_in The address of the mapping.
+ * @param x Column.
+ * @param y Row.
+ *
+ * @return
+ *         - The index of the LED, HD108_MAP2D_NO_LED if there is no LED at the position.
+ */
+extern uint16_t hd108_map2d_index(
+    void *map_in,
+    uint16_t x,
+    uint16_t y
+);
+
+
+/**
+ * @brief Size of the matrix.
+ *
+ * @param map_in The address of the mapping.
+ * @param width_out Out parameter for the width.
+ * @param height_out Out parameter for the height.
+ */
+extern void hd108_map2d_get_size(
+    void *map_in,
+    uint16_t *width_out,
+    uint16_t *height_out
+);
+
+
+/**
+ * @brief Write an RGB565 rectangle.
+ *
+ * @note The rectangle is written row by row. For progressive and serpentine
+ *       wiring each row is a single bulk write (reversed rows are reversed in
+ *       the row buffer first), for table wiring every pixel is looked up.
+ *       Positions without LED are skipped.
+ *
+ * @param map_in The address of the mapping.
+ * @param x Left column of the rectangle.
+ * @param y Top row of the rectangle.
+ * @param width Width of the rectangle.
+ * @param height Height of the rectangle.
+ * @param src Pixels in RGB565 format, native endianness, row by row without padding.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the rectangle is out of the matrix or the strip
+ */
+extern hd108_status_t hd108_map2d_write_rgb565(
+    void *map_in,
+    uint16_t x,
+    uint16_t y,
+    uint16_t width,
+    uint16_t height,
+    const uint16_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief Write an RGB888 rectangle.
+ *
+ * @note Same as hd108_map2d_write_rgb565, but the source is 3 bytes per pixel,
+ *       in the order red, green, blue.
+ */
+extern hd108_status_t hd108_map2d_write_rgb888(
+    void *map_in,
+    uint16_t x,
+    uint16_t y,
+    uint16_t width,
+    uint16_t height,
+    const uint8_t *src,
+    uint16_t current
+);
+
+
+/**
+ * @brief 2D mapping deinit.
+ *
+ * @note It frees the mapping and its row buffer. The wiring table is owned
+ *       by the application. The users of the mapping (LCD panel, animation
+ *       player) shall be deleted first.
+ *
+ * @param map_in The address of the mapping.
+ */
+extern void hd108_map2d_deinit(
+    void *map_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_MAP2D_H__ */
@@ -0,0 +1,201 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_MAP3D_H__
+#define __HD108_MAP3D_H__
+
+
+#include <stddef.h>
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_MAP3D_MAGIC           (0x44334448UL)  ///< "HD3D", first 4 bytes of the coordinate blob
+#define HD108_MAP3D_VERSION         (       1U)     ///< version of the coordinate blob
+
+
+/**
+ * @brief Header of the coordinate blob, created by tools/hd108_map3d_pack.py.
+ *          The header is followed by the x, y and z planes, count int16_t each.
+ *          A coordinate q is at origin + q * scale / 32768 in world units.
+ */
+typedef struct {
+    uint32_t    magic;              ///< HD108_MAP3D_MAGIC
+    uint16_t    version;            ///< HD108_MAP3D_VERSION
+    uint16_t    count;              ///< Number of LEDs
+    float       origin[3];          ///< Center of the bounding box in world units
+    float       scale[3];           ///< Half extent of the bounding box in world units
+} hd108_map3d_header_t;
+
+
+/**
+ * @brief Possible spatial fields.
+ *          Field parameters are in normalized coordinates, Q15 in [-1.0 .. 1.0).
+ */
+typedef enum {
+    HD108_MAP3D_PLANE           = 0,    ///< Slab around a plane
+    HD108_MAP3D_SPHERE          = 1,    ///< Shell around a sphere
+    HD108_MAP3D_NOISE           = 2     ///< 3D value noise volume
+} hd108_map3d_field_type_t;
+
+
+/**
+ * @brief Spatial field descriptor.
+ */
+typedef struct {
+    hd108_map3d_field_type_t    type;       ///< Type of the field
+    int16_t                     x;          ///< Plane: normal (unit length, Q15). Sphere: center (Q15).
+    int16_t                     y;          ///< Noise: offset in lattice cells (Q8.8), e.g. for animation.
+    int16_t                     z;
+    int16_t                     distance;   ///< Plane: offset along the normal (Q15). Sphere: radius (Q15).
+    uint16_t                    width;      ///< Plane, sphere: falloff width (Q15), the field is 65535 on the
+                                            ///< surface and 0 at width distance. Noise: lattice cells
+                                            ///< across the whole bounding box (Q8.8).
+} hd108_map3d_field_t;
+
+
+/**
+ * @brief 3D mapping configuration descriptor.
+ */
+typedef struct {
+    void           *ctx;            ///< The address of the driver context
+    uint16_t        first;          ///< Index of the LED of the first coordinate
+    const void     *blob;           ///< Coordinate blob, it is used in place and shall be valid until the mapping exists
+    size_t          blob_len;       ///< Length of the coordinate blob in bytes
+} hd108_map3d_configuration_t;
+
+
+/**
+ * @brief 3D mapping init.
+ *
+ * @note It checks the coordinate blob and creates the mapping on heap. The
+ *       coordinates are not copied, so a blob in memory mapped flash costs
+ *       no RAM.
+ *
+ * @param map3d_configuration Pointer to the configuration struct. After the initialization
+ *                            the struct is not used.
+ * @param map_out The address of the mapping pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters or the blob is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if the number of LEDs is out of range
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_map3d_init(
+    const hd108_map3d_configuration_t *map3d_configuration,
+    void **map_out
+);
+
+
+/**
+ * @brief 3D mapping init from a flash partition.
+ *
+ * @note It memory maps the data partition and creates the mapping on top of it.
+ *       The partition holds the coordinate blob, e.g. flashed with parttool.py.
+ *
+ * @param ctx_in The address of the driver context.
+ * @param first Index of the LED of the first coordinate.
+ * @param partition_label Label of the data partition.
+ * @param map_out The address of the mapping pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the partition is not found or the blob is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if the number of LEDs is out of range
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation or mapping is not possible
+ */
+extern hd108_status_t hd108_map3d_init_partition(
+    void *ctx_in,
+    uint16_t first,
+    const char *partition_label,
+    void **map_out
+);
+
+
+/**
+ * @brief Evaluate a spatial field at every LED.
+ *
+ * @param map_in The address of the mapping.
+ * @param field Pointer to the field descriptor.
+ * @param values_out Field values [0 .. 65535], one per LED.
+ */
+extern void hd108_map3d_eval(
+    void *map_in,
+    const hd108_map3d_field_t *field,
+    uint16_t *values_out
+);
+
+
+/**
+ * @brief Render a spatial field into the TX buffer.
+ *
+ * @note The field is evaluated in small batches, each LED gets the color
+ *       scaled by the field value. The batches are written with the RGB48
+ *       bulk write, so it can be used wherever hd108_lld_set_pixel can be used.
+ *
+ * @param map_in The address of the mapping.
+ * @param field Pointer to the field descriptor.
+ * @param color Color at field value 65535, red, green and blue.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the LEDs are out of the strip
+ */
+extern hd108_status_t hd108_map3d_render(
+    void *map_in,
+    const hd108_map3d_field_t *field,
+    const hd108_color_t color[3],
+    uint16_t current
+);
+
+
+/**
+ * @brief 3D mapping deinit.
+ *
+ * @note It frees the mapping and unmaps the partition if the mapping was
+ *       created by hd108_map3d_init_partition. A blob given to hd108_map3d_init
+ *       is owned by the application.
+ *
+ * @param map_in The address of the mapping.
+ */
+extern void hd108_map3d_deinit(
+    void *map_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_MAP3D_H__ */
@@ -0,0 +1,225 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_PROF_H__
+#define __HD108_PROF_H__
+
+
+#include <stdint.h>
+#include "HD108_types.h"
+
+#if defined(ESP_PLATFORM)
+#include "esp_cpu.h"
+#else
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#ifndef HD108_PROF_ENABLE
+#define HD108_PROF_ENABLE           (1)             ///< 0 compiles the profiling scopes out
+#endif
+#define HD108_PROF_MAX_SCOPES       (      16UL)    ///< maximum number of scopes of a profiler, the stages included
+
+
+/**
+ * @brief Stages of the driver, the first scopes of every profiler.
+ */
+typedef enum {
+    HD108_PROF_STAGE_TRANSFER   = 0,    ///< waiting for a loaded frame and the transfer
+    HD108_PROF_STAGE_UPDATE     = 1,    ///< update function, the scopes of the user are inside
+    HD108_PROF_STAGE_ENCODE     = 2,    ///< commit of the planes, upsampling, upconversion
+    HD108_PROF_STAGE_COUNT      = 3     ///< number of stages, the first scope of the user
+} hd108_prof_stage_t;
+
+
+/**
+ * @brief Statistics of one scope.
+ */
+typedef struct {
+    const char *name;                   ///< Name of the scope
+    uint32_t    last_us;                ///< Time in the last frame
+    uint32_t    avg_us;                 ///< Average time per frame
+    uint32_t    max_us;                 ///< Longest time in a frame
+    uint32_t    share_ppm;              ///< Average share of the frame period, in ppm
+} hd108_prof_stats_t;
+
+
+/**
+ * @brief Profiler.
+ *          The scopes add their cycles to the current frame, the driver closes
+ *          the frame after each update. Scopes shall be used in the update
+ *          function, in the task of the driver.
+ */
+typedef struct {
+    const char *name[HD108_PROF_MAX_SCOPES];    ///< Names of the scopes
+    uint32_t    frame[HD108_PROF_MAX_SCOPES];   ///< Cycles of the current frame
+    uint32_t    last[HD108_PROF_MAX_SCOPES];    ///< Cycles of the last frame
+    uint32_t    max[HD108_PROF_MAX_SCOPES];     ///< Most cycles in a frame
+    uint64_t    total[HD108_PROF_MAX_SCOPES];   ///< Sum of the cycles of all frames
+    uint8_t     count;                          ///< Number of scopes
+    uint32_t    frames;                         ///< Number of closed frames
+    uint32_t    frame_start;                    ///< Counter at the start of the current frame
+    uint64_t    period_total;                   ///< Sum of the frame periods in cycles
+} hd108_prof_t;
+
+
+/**
+ * @brief Read the cycle counter.
+ *          On the target it is the CPU cycle counter, in a host build a
+ *          nanosecond clock.
+ */
+static inline uint32_t hd108_prof_now(void) {
+#if defined(ESP_PLATFORM)
+    return (uint32_t)esp_cpu_get_cycle_count();
+#else
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+
+/**
+ * @brief Add cycles to a scope in the current frame.
+ */
+static inline void hd108_prof_add(hd108_prof_t *prof, uint8_t scope, uint32_t cycles) {
+    prof->frame[scope] += cycles;
+}
+
+
+#if HD108_PROF_ENABLE
+/**
+ * @brief Begin a scope, the start is kept in a local variable of the given name.
+ */
+#define HD108_PROF_BEGIN(start)             uint32_t start = hd108_prof_now()
+
+/**
+ * @brief End a scope that has been begun with HD108_PROF_BEGIN.
+ */
+#define HD108_PROF_END(prof, scope, start)  hd108_prof_add((prof), (scope), hd108_prof_now() - (start))
+
+/**
+ * @brief Profile the following statement or block, e.g. HD108_PROF_SCOPE(prof, id) { ... }.
+ *          Leaving the block with break, return or goto skips the measurement.
+ */
+#define HD108_PROF_SCOPE(prof, scope) \
+    for (uint32_t hd108_prof_start = hd108_prof_now(), hd108_prof_once = 1; hd108_prof_once; \
+         hd108_prof_once = 0, hd108_prof_add((prof), (scope), hd108_prof_now() - hd108_prof_start))
+#else
+#define HD108_PROF_BEGIN(start)             do { } while (0)
+#define HD108_PROF_END(prof, scope, start)  do { (void)(prof); (void)(scope); } while (0)
+#define HD108_PROF_SCOPE(prof, scope)       if (1)
+#endif
+
+
+/**
+ * @brief Profiler init.
+ *
+ * @note It creates the profiler with the stages of the driver as the first scopes.
+ *       It is attached to a context with hd108_lld_set_profiler.
+ *
+ * @param prof_out The address of the profiler pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_prof_init(
+    hd108_prof_t **prof_out
+);
+
+
+/**
+ * @brief Add a named scope.
+ *
+ * @param prof The address of the profiler.
+ * @param name Name of the scope, it shall stay valid.
+ * @param scope_out Out parameter for the scope id, used by the macros.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if there are HD108_PROF_MAX_SCOPES scopes already
+ */
+extern hd108_status_t hd108_prof_scope(
+    hd108_prof_t *prof,
+    const char *name,
+    uint8_t *scope_out
+);
+
+
+/**
+ * @brief Close the current frame.
+ *
+ * @note The cycles of the frame are added to the statistics of every scope and
+ *       a new frame is started. The driver calls it after every update.
+ *
+ * @param prof The address of the profiler.
+ */
+extern void hd108_prof_frame(
+    hd108_prof_t *prof
+);
+
+
+/**
+ * @brief Get the statistics of a scope.
+ *
+ * @param prof The address of the profiler.
+ * @param scope Scope id, a stage or a scope of the user.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the scope does not exist
+ */
+extern hd108_status_t hd108_prof_get_stats(
+    const hd108_prof_t *prof,
+    uint8_t scope,
+    hd108_prof_stats_t *stats_out
+);
+
+
+/**
+ * @brief Print the report of every scope.
+ *
+ * @param prof The address of the profiler.
+ */
+extern void hd108_prof_print(
+    const hd108_prof_t *prof
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_PROF_H__ */
@@ -0,0 +1,131 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_SAMPLER_H__
+#define __HD108_SAMPLER_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Possible source image formats.
+ */
+typedef enum {
+    HD108_SAMPLER_RGB565        = 0,    ///< 16-bit RGB565, native endianness
+    HD108_SAMPLER_RGB888        = 1     ///< 3 x 8-bit, in the order red, green, blue
+} hd108_sampler_format_t;
+
+
+/**
+ * @brief Image sampler configuration descriptor.
+ */
+typedef struct {
+    void                       *ctx;            ///< The address of the driver context
+    uint16_t                    first;          ///< Index of the LED of the first sample
+    uint16_t                    count;          ///< Number of LEDs (samples)
+    uint16_t                    image_width;    ///< Width of the source image in pixels, at least 2
+    uint16_t                    image_height;   ///< Height of the source image in pixels, at least 2
+    hd108_sampler_format_t      format;         ///< Format of the source image, rows without padding
+    const uint32_t             *u;              ///< Horizontal sample position of each LED in image pixels, Q16.16
+    const uint32_t             *v;              ///< Vertical sample position of each LED in image pixels, Q16.16
+} hd108_sampler_configuration_t;
+
+
+/**
+ * @brief Image sampler init.
+ *
+ * @note It precomputes the sample table on heap: for each LED the offset of
+ *       the top-left source pixel and the bilinear weights (8 bytes per LED).
+ *       Positions out of the image are clamped to the border. The positions
+ *       are not used after the initialization.
+ *
+ * @param sampler_configuration Pointer to the configuration struct. After the initialization
+ *                              the struct is not used.
+ * @param sampler_out The address of the sampler pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if the number of LEDs is out of range
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_sampler_init(
+    const hd108_sampler_configuration_t *sampler_configuration,
+    void **sampler_out
+);
+
+
+/**
+ * @brief Sample an image into the TX buffer.
+ *
+ * @note Each LED gathers its four source pixels through the sample table,
+ *       they are expanded to 16-bit and blended bilinearly. The samples are
+ *       encoded straight into the TX buffer (hd108_lld_open_frame). If the
+ *       TX buffer is built after the update function, e.g. with frame-rate
+ *       upconversion, they are written in small batches with the RGB48 bulk
+ *       write instead. It can be used wherever hd108_lld_set_pixel can be used.
+ *
+ * @param sampler_in The address of the sampler.
+ * @param image Source image, image_width x image_height pixels.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the LEDs are out of the strip
+ */
+extern hd108_status_t hd108_sampler_render(
+    void *sampler_in,
+    const void *image,
+    uint16_t current
+);
+
+
+/**
+ * @brief Image sampler deinit.
+ *
+ * @note It frees the sampler and its sample table. It shall not be called
+ *       while hd108_sampler_render is running.
+ *
+ * @param sampler_in The address of the sampler.
+ */
+extern void hd108_sampler_deinit(
+    void *sampler_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_SAMPLER_H__ */
@@ -0,0 +1,178 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_SCHED_H__
+#define __HD108_SCHED_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_SCHED_MAX_CONTEXTS    (       8UL)    ///< maximum number of contexts of one scheduler
+#define HD108_SCHED_MAX_DIVIDER     (      16UL)    ///< maximum rate reduction of a degraded context
+
+
+/**
+ * @brief Scheduler configuration descriptor.
+ */
+typedef struct {
+    uint8_t     budget_percent;     ///< Share of the CPU the updates may use [1 .. 100]
+    uint8_t     task_priority;      ///< Priority of the scheduler task. The task is pinned to the core that calls the init,
+                                    ///< which shall be the core of the contexts with dedicated GPIO transport.
+} hd108_sched_configuration_t;
+
+
+/**
+ * @brief Scheduler statistics of one context.
+ */
+typedef struct {
+    uint32_t    period_us;          ///< Nominal period
+    uint8_t     priority;           ///< Priority of the context
+    uint8_t     divider;            ///< Current rate reduction, 1 if the context runs at its nominal rate
+    uint32_t    cost_us;            ///< Smoothed cost of one update (transfer and update function)
+    uint32_t    rate_mhz;           ///< Achieved update rate in the last second, in mHz
+    uint32_t    updates;            ///< Number of updates
+    uint32_t    missed;             ///< Number of updates dropped because their deadline had passed
+} hd108_sched_stats_t;
+
+
+/**
+ * @brief Scheduler init.
+ *
+ * @note It creates the scheduler task. The task runs the updates of its
+ *       contexts earliest deadline first: every update is released at the
+ *       start of its period and is due at the end of it. The cost of every
+ *       update is measured, if the sum of the utilizations exceeds the
+ *       budget, contexts are degraded from the lowest priority up by
+ *       dividing their rate. The contexts of the highest priority are never
+ *       degraded. Rates are restored when the load drops.
+ *
+ * @param sched_configuration Pointer to the configuration struct. After the initialization
+ *                            the struct is not used.
+ * @param sched_out The address of the scheduler pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the budget is out of range
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_sched_init(
+    const hd108_sched_configuration_t *sched_configuration,
+    void **sched_out
+);
+
+
+/**
+ * @brief Add a context to the scheduler.
+ *
+ * @note The context shall be initialized with external_update, its updates
+ *       are run by the scheduler task from now on. A context can be added
+ *       only once.
+ *
+ * @param sched_in The address of the scheduler.
+ * @param ctx_in The address of the context.
+ * @param frequency_hz Nominal update frequency.
+ * @param priority Priority of the context, higher is more important.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the frequency is 0, the context has already been added or the scheduler is full
+ */
+extern hd108_status_t hd108_sched_add(
+    void *sched_in,
+    void *ctx_in,
+    hd108_update_frequency_hz_t frequency_hz,
+    uint8_t priority
+);
+
+
+/**
+ * @brief Remove a context from the scheduler.
+ *
+ * @note It waits until an update in flight has finished, the context is not
+ *       updated any more when it returns. It shall be called before
+ *       hd108_lld_deinit of the context, and not from an update function
+ *       run by the scheduler.
+ *
+ * @param sched_in The address of the scheduler.
+ * @param ctx_in The address of the context.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the context has not been added
+ */
+extern hd108_status_t hd108_sched_remove(
+    void *sched_in,
+    void *ctx_in
+);
+
+
+/**
+ * @brief Get scheduler statistics of a context.
+ *
+ * @param sched_in The address of the scheduler.
+ * @param ctx_in The address of the context.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the context has not been added
+ */
+extern hd108_status_t hd108_sched_get_stats(
+    void *sched_in,
+    void *ctx_in,
+    hd108_sched_stats_t *stats_out
+);
+
+
+
+/**
+ * @brief Scheduler deinit.
+ *
+ * @note It waits until an update in flight has finished, stops the
+ *       scheduler task and releases the scheduler. The contexts are not
+ *       updated any more when it returns, they can be deinitialized after it.
+ *       It shall not be called from an update function run by the scheduler.
+ *
+ * @param sched_in The address of the scheduler.
+ */
+extern void hd108_sched_deinit(
+    void *sched_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_SCHED_H__ */
@@ -0,0 +1,178 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#ifndef __HD108_SHOW_H__
+#define __HD108_SHOW_H__
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_SHOW_MAGIC            (0x53314448UL)  ///< "HD1S", first 4 bytes of the show file
+#define HD108_SHOW_VERSION          (       1U)     ///< version of the show file
+#define HD108_SHOW_MIN_BLOCKS       (       2UL)    ///< minimum number of read-ahead blocks
+#define HD108_SHOW_MAX_BLOCKS       (      32UL)    ///< maximum number of read-ahead blocks
+
+
+/**
+ * @brief Possible frame formats of the show file.
+ */
+typedef enum {
+    HD108_SHOW_RAW              = 0,    ///< count RGB888 pixels per frame
+    HD108_SHOW_RLE              = 1     ///< uint32_t length, then run-length packets of RGB888 pixels
+} hd108_show_format_t;
+
+
+/**
+ * @brief Header of the show file, created by tools/hd108_show_pack.py.
+ *          The header is followed by the frames until the end of the file.
+ *          An RLE frame is a little-endian uint32_t length followed by
+ *          packets: a control byte c < 128 is followed by c + 1 literal
+ *          pixels, a control byte c >= 128 by one pixel repeated c - 125 times.
+ */
+typedef struct {
+    uint32_t    magic;              ///< HD108_SHOW_MAGIC
+    uint16_t    version;            ///< HD108_SHOW_VERSION
+    uint16_t    count;              ///< Number of pixels in one frame
+    uint8_t     format;             ///< Frame format, see hd108_show_format_t
+    uint8_t     reserved[3];        ///< Reserved, 0
+    uint32_t    frame_us;           ///< Frame time in microseconds
+} hd108_show_header_t;
+
+
+/**
+ * @brief Show player configuration descriptor.
+ */
+typedef struct {
+    void           *ctx;            ///< The address of the driver context
+    const char     *path;           ///< Path of the show file, e.g. on an SD card
+    uint16_t        first;          ///< Index of the LED of the first pixel
+    uint16_t        current;        ///< Current levels for every pixel, see HD108_LLD_CURRENT
+    bool            loop;           ///< Restart the show at the end of the file
+    uint32_t        block_size;     ///< Size of one read-ahead block in bytes, e.g. 4096 for FAT clusters.
+                                    ///< All blocks but one shall hold the longest frame.
+    uint8_t         block_count;    ///< Number of read-ahead blocks [HD108_SHOW_MIN_BLOCKS .. HD108_SHOW_MAX_BLOCKS]
+    uint8_t         priority;       ///< Priority of the read-ahead task
+} hd108_show_configuration_t;
+
+
+/**
+ * @brief Show player statistics.
+ */
+typedef struct {
+    uint32_t    frames;             ///< Number of frames written
+    uint32_t    underruns;          ///< Number of frame times when the next frame had not been read yet
+    uint64_t    bytes_read;         ///< Number of bytes read from the file
+    uint64_t    read_time_us;       ///< Time spent in reading the file
+    uint32_t    buffered;           ///< Number of bytes read ahead right now
+    uint32_t    min_buffered;       ///< Lowest number of bytes read ahead after the first frame
+} hd108_show_stats_t;
+
+
+/**
+ * @brief Show player open.
+ *
+ * @note It opens the show file, allocates the block pool and starts the
+ *       read-ahead task. The task keeps every free block filled with the
+ *       next bytes of the file, so the update function never waits for the
+ *       file system. It works with any file system behind stdio (FAT,
+ *       LittleFS, SPIFFS) and with regular files on the linux target.
+ *
+ * @param show_configuration Pointer to the configuration struct. After the initialization
+ *                           the struct is not used.
+ * @param show_out The address of the player pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the file cannot be opened, its header or one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_LENGTH      if a frame does not fit into the strip
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_show_open(
+    const hd108_show_configuration_t *show_configuration,
+    void **show_out
+);
+
+
+/**
+ * @brief Show player update.
+ *
+ * @note It shall be called from the update function. When the next frame is
+ *       due and it has been read completely, it is decoded from the blocks
+ *       straight into the TX buffer. If it has not been read yet, an underrun
+ *       is counted and the LEDs keep the previous frame, the frame is shown
+ *       as soon as it is available.
+ *
+ * @param show_in The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success, also if no frame was due or the show has ended
+ *         - HD108_LLD_ERROR_INVALID     if the file is corrupted
+ */
+extern hd108_status_t hd108_show_update(
+    void *show_in
+);
+
+
+/**
+ * @brief Get show player statistics.
+ *
+ * @note The sustained read throughput is bytes_read / read_time_us.
+ *
+ * @param show_in The address of the player.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ */
+extern void hd108_show_get_stats(
+    void *show_in,
+    hd108_show_stats_t *stats_out
+);
+
+
+/**
+ * @brief Show player close.
+ *
+ * @note It stops the read-ahead task, closes the file and releases the player.
+ *
+ * @param show_in The address of the player.
+ */
+extern void hd108_show_close(
+    void *show_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_SHOW_H__ */
@@ -0,0 +1,144 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_SYNC_H__
+#define __HD108_SYNC_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Active edges of the sync input.
+ */
+typedef enum {
+    HD108_SYNC_EDGE_RISING      = 0,    ///< rising edge
+    HD108_SYNC_EDGE_FALLING     = 1,    ///< falling edge
+    HD108_SYNC_EDGE_ANY         = 2     ///< both edges, e.g. a field signal
+} hd108_sync_edge_t;
+
+
+/**
+ * @brief Sync (genlock) configuration descriptor.
+ */
+typedef struct {
+    void               *ctx;            ///< The address of the context, initialized with external_update
+    uint8_t             pin_sync;       ///< Sync input PIN number
+    hd108_sync_edge_t   edge;           ///< Active edge
+    uint8_t             divider;        ///< Every divider-th edge starts a frame, 0 is 1
+    uint32_t            delay_us;       ///< Delay of the frame start after the edge, e.g. to center on the shutter
+    uint8_t             task_priority;  ///< Priority of the sync task, it shall be higher than the other users of the core.
+                                        ///< The task is pinned to the core that calls the init, which shall be the core
+                                        ///< of the context init if the transport is dedicated GPIO.
+} hd108_sync_configuration_t;
+
+
+/**
+ * @brief Sync statistics.
+ */
+typedef struct {
+    uint32_t    syncs;                  ///< Number of frames started by the sync
+    uint32_t    missed;                 ///< Number of syncs dropped because the previous frame was not done yet
+    uint32_t    period_us;              ///< Measured period between two transfer starts
+    int32_t     phase_error_us;         ///< Transfer start on the bus minus (edge + delay) of the last frame sent
+    uint32_t    phase_error_max_us;     ///< Largest absolute phase error
+} hd108_sync_stats_t;
+
+
+/**
+ * @brief Sync init.
+ *
+ * @note It configures the sync input and creates the sync task. Every active
+ *       edge (after the divider) wakes the task from the GPIO interrupt, the
+ *       task waits for the delay and runs hd108_lld_update: the frame that
+ *       was rendered after the previous sync is sent at once, then the update
+ *       function renders the next one. If the previous update is still
+ *       running when the edge comes the sync is missed. The delay is waited
+ *       for by sleeping down to the last tick and spinning the rest. The
+ *       phase error is measured at the start of the transfer on the bus
+ *       (hd108_lld_get_transfer_start), so it includes the wake-up of the
+ *       task, the wait for a shared bus and for a frame loaded in the
+ *       background.
+ *
+ * @param sync_configuration Pointer to the configuration struct. After the initialization
+ *                           the struct is not used.
+ * @param sync_out The address of the sync pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the context is NULL, the pin or the edge is invalid
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_sync_init(
+    const hd108_sync_configuration_t *sync_configuration,
+    void **sync_out
+);
+
+
+/**
+ * @brief Get sync statistics.
+ *
+ * @param sync_in The address of the sync.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ */
+extern hd108_status_t hd108_sync_get_stats(
+    void *sync_in,
+    hd108_sync_stats_t *stats_out
+);
+
+
+
+/**
+ * @brief Sync deinit.
+ *
+ * @note It removes the interrupt handler of the sync input, waits until an
+ *       update in flight has finished and stops the sync task. The context
+ *       is not updated any more when it returns, so it shall be called before
+ *       hd108_lld_deinit of the context. The ISR service stays installed.
+ *
+ * @param sync_in The address of the sync.
+ */
+extern void hd108_sync_deinit(
+    void *sync_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_SYNC_H__ */
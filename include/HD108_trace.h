@@ -0,0 +1,100 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_TRACE_H__
+#define __HD108_TRACE_H__
+
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Trace events of the frame stages.
+ *          The parameter of every event is the address of the context.
+ */
+typedef enum {
+    HD108_TRACE_TIMER           = 0,    ///< timer (or hd108_lld_update) fired
+    HD108_TRACE_QUEUE           = 1,    ///< transaction queued
+    HD108_TRACE_DMA_START       = 2,    ///< transaction started on the bus, from the SPI interrupt
+    HD108_TRACE_DMA_DONE        = 3,    ///< transaction done, from the SPI interrupt
+    HD108_TRACE_RENDER_START    = 4,    ///< update function called
+    HD108_TRACE_RENDER_END      = 5,    ///< update function returned
+    HD108_TRACE_ENCODE_START    = 6,    ///< encode of the TX buffer started
+    HD108_TRACE_ENCODE_END      = 7,    ///< encode of the TX buffer done
+    HD108_TRACE_SWAP            = 8,    ///< keyframe buffers swapped
+    HD108_TRACE_EVENT_COUNT     = 9     ///< number of events
+} hd108_trace_event_t;
+
+
+#if CONFIG_HD108_TRACE
+/**
+ * @brief Record a trace event.
+ */
+#define HD108_TRACE(event, ctx)     hd108_trace_event((event), (ctx))
+#else
+#define HD108_TRACE(event, ctx)     do { } while (0)
+#endif
+
+
+/**
+ * @brief Trace init.
+ *
+ * @note It registers the events in SystemView, so they are shown with their
+ *       names. It is called by hd108_lld_init, more calls do nothing. Without
+ *       CONFIG_HD108_TRACE it does nothing.
+ */
+extern void hd108_trace_init(
+    void
+);
+
+
+/**
+ * @brief Record a trace event, use HD108_TRACE instead.
+ *
+ * @note It is safe to call from an interrupt.
+ *
+ * @param event The event.
+ * @param ctx The address of the context.
+ */
+extern void hd108_trace_event(
+    hd108_trace_event_t event,
+    const void *ctx
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_TRACE_H__ */
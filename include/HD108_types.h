@@ -0,0 +1,136 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_TYPES_H__
+#define __HD108_TYPES_H__
+
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define HD108_LLD_MIN_COUNT         (       1UL)    ///< minimum number of LEDs
+#define HD108_LLD_MAX_COUNT         (    1024UL)    ///< maximum number of LEDs
+
+
+/**
+ * @brief Size of a frame of count LEDs in wire format, see hd108_lld_capture_frame.
+ */
+#define HD108_LLD_FRAME_SIZE(count) (8UL * (count))
+
+
+/**
+ * @brief Possible return values of interface functions.
+ */
+typedef enum {
+    HD108_LLD_OK                = 0,    ///< OK
+    HD108_LLD_ERROR_UNKNOWN     = 1,    ///< Unknown error
+    HD108_LLD_ERROR_INVALID     = 2,    ///< Invalid argument is provided
+    HD108_LLD_ERROR_SPI_IN_USE  = 3,    ///< SPI allocation error
+    HD108_LLD_ERROR_NO_DMA      = 4,    ///< DMA allocation error
+    HD108_LLD_ERROR_NO_MEMORY   = 5,    ///< Memory allocation error
+    HD108_LLD_ERROR_NO_CS       = 6,    ///< SPI host doesn't have any free CS slots
+    HD108_LLD_ERROR_LENGTH      = 7,    ///< Length of the strip is out of range [HD108_LLD_MIN_COUNT .. HD108_LLD_MAX_COUNT]
+    HD108_LLD_ERROR_INDEX       = 8,    ///< Index is out of range.
+    HD108_LLD_ERROR_DATA_RATE   = 9     ///< SPI clock speed is too low for the desired update frequency.
+} hd108_status_t;
+
+
+/**
+ * @brief Possible LED strip update values in Hz.
+ */
+typedef enum {
+    HD108_LLD_UPDATE_1HZ        =   1,  ///<   1Hz
+    HD108_LLD_UPDATE_2HZ        =   2,  ///<   2Hz
+    HD108_LLD_UPDATE_5HZ        =   5,  ///<   5Hz
+    HD108_LLD_UPDATE_10HZ       =  10,  ///<  10Hz
+    HD108_LLD_UPDATE_20HZ       =  20,  ///<  20Hz
+    HD108_LLD_UPDATE_24HZ       =  24,  ///<  24Hz
+    HD108_LLD_UPDATE_25HZ       =  25,  ///<  25Hz
+    HD108_LLD_UPDATE_30HZ       =  30,  ///<  30Hz
+    HD108_LLD_UPDATE_50HZ       =  50,  ///<  50Hz
+    HD108_LLD_UPDATE_60HZ       =  60,  ///<  60Hz
+    HD108_LLD_UPDATE_100HZ      = 100,  ///< 100Hz
+    HD108_LLD_UPDATE_120HZ      = 120   ///< 120Hz
+} hd108_update_frequency_hz_t;
+
+
+/**
+ * @brief New type for red/green/blue color value.
+ */
+typedef uint16_t hd108_color_t;
+
+
+/**
+ * @brief New type for driving current value.
+ */
+typedef uint16_t hd108_current_t;
+
+/**
+ * @brief Pixel descriptor for one LED.
+ */
+typedef struct {
+    hd108_current_t cl_blue  :5;    ///< current level for blue
+    hd108_current_t cl_green :5;    ///< current level for green
+    hd108_current_t cl_red   :5;    ///< current level for red
+    hd108_current_t          :1;    ///< restricted (start bit in SPI data)
+    hd108_color_t   red;            ///< color value for red
+    hd108_color_t   green;          ///< color value for green
+    hd108_color_t   blue;           ///< color value for blue
+} hd108_pixel_t;
+
+
+/**
+ * @brief Packs the current levels of a pixel into a current plane value.
+ */
+#define HD108_LLD_CURRENT(cl_red, cl_green, cl_blue) \
+    ((uint16_t)((((cl_red) & 0x1fU) << 10) | (((cl_green) & 0x1fU) << 5) | ((cl_blue) & 0x1fU)))
+
+
+/**
+ * @brief Planar (SoA) frame.
+ *          Each plane is a contiguous array of count values, aligned to 16 bytes.
+ */
+typedef struct {
+    hd108_color_t  *red;            ///< color values for red
+    hd108_color_t  *green;          ///< color values for green
+    hd108_color_t  *blue;           ///< color values for blue
+    uint16_t       *current;        ///< current levels, see HD108_LLD_CURRENT
+    uint16_t        count;          ///< number of values in each plane
+} hd108_planes_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_TYPES_H__ */
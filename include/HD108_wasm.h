@@ -0,0 +1,150 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#ifndef __HD108_WASM_H__
+#define __HD108_WASM_H__
+
+
+#include <stdint.h>
+#include "HD108_lld.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief WebAssembly effect configuration descriptor.
+ *
+ * @note The module shall export two functions, every value is i32:
+ *         - hd108_buffer(count) -> offset: called once by the init, returns the
+ *           offset of a buffer of count RGB48 pixels (3 x 16-bit, little endian,
+ *           2 byte aligned) in the linear memory.
+ *         - hd108_render(frame, time_ms, first, count): renders the pixels
+ *           [first .. first + count - 1] into the buffer.
+ *       There are no per pixel imports, the whole strip is rendered with one call.
+ */
+typedef struct {
+    void               *ctx;            ///< The address of the context that shows the effect
+    const uint8_t      *module;         ///< WebAssembly binary, it shall stay valid until the deinit
+    uint32_t            module_len;     ///< Length of the binary in bytes
+    uint16_t            count;          ///< Number of pixels rendered by the module, e.g. the count of the context
+                                        ///< (render_count if spatial upsampling is enabled)
+    uint16_t            current;        ///< Current levels of the rendered pixels, see HD108_LLD_CURRENT
+} hd108_wasm_configuration_t;
+
+
+/**
+ * @brief WebAssembly effect statistics.
+ *
+ * @note The interpreter time is the share of the frame budget the effect
+ *       costs, e.g. for 1024 LEDs at 100 Hz render_max_us plus write_us shall
+ *       stay well below the 10 ms period.
+ */
+typedef struct {
+    uint32_t    frames;                 ///< Number of frames rendered
+    uint32_t    render_us;              ///< Time of the last hd108_render call in the interpreter
+    uint32_t    render_max_us;          ///< Longest hd108_render call
+    uint32_t    write_us;               ///< Time of the last write of the buffer into the context
+} hd108_wasm_stats_t;
+
+
+/**
+ * @brief WebAssembly effect init.
+ *
+ * @note It loads the module into a new wasm3 runtime and gets the buffer of the
+ *       pixels from the module.
+ *
+ * @param wasm_configuration Pointer to the configuration struct. After the initialization
+ *                           the struct is not used.
+ * @param wasm_out The address of the effect pointer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the count is 0, the module cannot be loaded, an export is missing
+ *                                       or the buffer is out of the linear memory
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+extern hd108_status_t hd108_wasm_init(
+    const hd108_wasm_configuration_t *wasm_configuration,
+    void **wasm_out
+);
+
+
+/**
+ * @brief WebAssembly effect render.
+ *
+ * @note It calls hd108_render of the module for the whole strip, then writes the
+ *       buffer into the context with hd108_lld_write_rgb48 in one pass. It is
+ *       called from the update function of the context. Both steps are timed,
+ *       see hd108_wasm_get_stats.
+ *
+ * @param wasm_in The address of the effect.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the module trapped or the buffer left the linear memory
+ */
+extern hd108_status_t hd108_wasm_render(
+    void *wasm_in
+);
+
+
+/**
+ * @brief Get WebAssembly effect statistics.
+ *
+ * @param wasm_in The address of the effect.
+ * @param stats_out Pointer to the statistics struct to be filled.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ */
+extern hd108_status_t hd108_wasm_get_stats(
+    void *wasm_in,
+    hd108_wasm_stats_t *stats_out
+);
+
+
+/**
+ * @brief WebAssembly effect deinit.
+ *
+ * @note It frees the runtime and the effect.
+ *
+ * @param wasm_in The address of the effect.
+ */
+extern void hd108_wasm_deinit(
+    void *wasm_in
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HD108_WASM_H__ */
@@ -0,0 +1,1122 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "HD108_anim.h"
+#include "HD108_map2d.h"
+
+#if CONFIG_HD108_MJPEG
+#include "tjpgd.h"
+#endif
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_ANIM_READ_BUF         (     256UL)    ///< size of the file read buffer
+#define HD108_ANIM_LZW_CODES        (    4096UL)    ///< number of LZW codes, 12-bit
+#define HD108_ANIM_JPEG_POOL        (    3500UL)    ///< size of the tjpgd work area
+#define HD108_ANIM_GIF_MIN_DELAY    (   20000UL)    ///< GIF delays below this are replaced by the default
+#define HD108_ANIM_GIF_DEF_DELAY    (  100000UL)    ///< default GIF frame delay in microseconds
+#define HD108_ANIM_TASK_STACK       (    4096UL)    ///< stack size of the decoder task, file systems need plenty
+#define HD108_ANIM_RUN_COUNT        (       8UL)    ///< runs in the ring between the decoder task and the update
+#define HD108_ANIM_NO_RUN           (    0xffU)     ///< wakes the decoder task to stop, it is not a run
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Possible animation formats.
+ */
+typedef enum {
+    HD108_ANIM_GIF              = 0,    ///< Animated GIF
+    HD108_ANIM_MJPEG_STREAM     = 1     ///< Concatenated JPEG frames
+} hd108_anim_format_t;
+
+
+/**
+ * @brief GIF decoder state.
+ */
+typedef struct {
+    uint16_t    screen_width;       ///< Logical screen width
+    uint16_t    screen_height;      ///< Logical screen height
+    uint8_t     palette[3 * 256];   ///< Active color table
+    uint8_t     global[3 * 256];    ///< Global color table
+    uint16_t    global_size;        ///< Number of global colors, 0 if there is no global color table
+    long        first_frame;        ///< File offset of the first block after the global color table
+    int16_t     transparent;        ///< Transparent color index of the next frame, -1 if none
+    uint8_t     disposal;           ///< Disposal method of the next frame
+    uint32_t    delay_us;           ///< Delay of the next frame
+    uint8_t     prev_disposal;      ///< Disposal method of the previous frame
+    uint16_t    prev_rect[4];       ///< Rectangle of the previous frame: left, top, width, height
+    uint16_t   *prefix;             ///< LZW prefix of each code
+    uint8_t    *suffix;             ///< LZW last byte of each code
+    uint8_t    *stack;              ///< LZW string output stack
+    uint8_t     block_left;         ///< Bytes left in the current data sub-block
+    bool        block_end;          ///< Terminator sub-block has been read
+    uint32_t    bit_buf;            ///< LZW bit buffer
+    uint8_t     bit_cnt;            ///< Number of bits in the bit buffer
+} hd108_anim_gif_t;
+
+
+/**
+ * @brief Run of decoded pixels, a part of one row of the matrix.
+ *
+ * @note A run without pixels marks the end of a frame and carries its
+ *       status and delay.
+ */
+typedef struct {
+    uint16_t            x;              ///< Left column of the run
+    uint16_t            y;              ///< Row of the run
+    uint16_t            count;          ///< Number of pixels, 0 at the end of a frame
+    bool                ended;          ///< End of frame: the animation has ended, the frame is empty
+    hd108_status_t      status;         ///< End of frame: status of the decoding
+    uint32_t            delay_us;       ///< End of frame: delay of the frame
+} hd108_anim_run_t;
+
+
+/**
+ * @brief Player variable.
+ *
+ * @note The decoder task owns the file and the decoder state. Decoded
+ *       pixels travel to the update function as runs through two queues:
+ *       the task takes a free run, fills it and passes it on, the update
+ *       writes it through the 2D mapping and gives it back. There is no
+ *       frame buffer: the TX buffer keeps the previous frame, so transparent
+ *       pixels are simply not sent.
+ */
+typedef struct {
+    FILE               *file;           ///< Animation file
+    void               *map;            ///< The address of the 2D mapping
+    uint16_t            width;          ///< Width of the matrix
+    uint16_t            height;         ///< Height of the matrix
+    uint16_t            current;        ///< Current levels for every pixel
+    bool                loop;           ///< Restart at the end of the file
+    bool                ended;          ///< The decoder has reached the end of the animation
+    bool                finished;       ///< The update function has shown the last frame
+    hd108_anim_format_t format;         ///< Format of the file
+    uint32_t            frame_us;       ///< Frame time of MJPEG files
+    int64_t             due;            ///< Presentation time of the next frame
+    bool                showing;        ///< The runs of the due frame are being written
+    hd108_status_t      status;         ///< Status of the writes of the frame being shown
+    hd108_anim_run_t    runs[HD108_ANIM_RUN_COUNT]; ///< Runs of the ring
+    uint8_t            *run_rgb;        ///< RGB888 pixels of the runs, one row of the matrix each
+    QueueHandle_t       free_runs;      ///< Runs to be filled by the decoder task
+    QueueHandle_t       full_runs;      ///< Runs to be written by the update function
+    SemaphoreHandle_t   done;           ///< Given by the decoder task when it exits
+    volatile bool       stop;           ///< Request to stop the decoder task
+    uint8_t             buf[HD108_ANIM_READ_BUF];   ///< File read buffer
+    uint16_t            buf_pos;        ///< Next byte in the read buffer
+    uint16_t            buf_len;        ///< Number of bytes in the read buffer
+    uint8_t            *row_index;      ///< GIF color indexes of one row
+    uint8_t            *row_rgb;        ///< RGB888 pixels of one row
+    hd108_anim_gif_t   *gif;            ///< GIF decoder state
+    void               *jpeg_pool;      ///< tjpgd work area
+    uint8_t             jpeg_soi;       ///< Bytes of the SOI marker to pass to tjpgd before the file
+    long                jpeg_chunk;     ///< File offset of the last chunk read by tjpgd
+} hd108_anim_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static int              hd108_anim_getc             (hd108_anim_t *anim);
+static bool             hd108_anim_read             (hd108_anim_t *anim, uint8_t *dst, uint16_t len);
+static void             hd108_anim_seek             (hd108_anim_t *anim, long offset);
+static long             hd108_anim_tell             (hd108_anim_t *anim);
+static bool             hd108_anim_take_run         (hd108_anim_t *anim, uint8_t *run);
+static hd108_status_t   hd108_anim_write_run        (hd108_anim_t *anim, int32_t x, int32_t y, int32_t count, const uint8_t *rgb);
+static bool             hd108_anim_end_frame        (hd108_anim_t *anim, hd108_status_t status, uint32_t delay_us);
+static bool             hd108_anim_clear            (hd108_anim_t *anim);
+static hd108_status_t   hd108_anim_gif_header       (hd108_anim_t *anim);
+static bool             hd108_anim_gif_skip_blocks  (hd108_anim_t *anim);
+static int              hd108_anim_gif_data_byte    (hd108_anim_t *anim);
+static int              hd108_anim_gif_code         (hd108_anim_t *anim, uint8_t code_size);
+static uint16_t         hd108_anim_gif_interlace    (uint16_t n, uint16_t height);
+static hd108_status_t   hd108_anim_gif_row          (hd108_anim_t *anim, const uint16_t *rect, uint16_t row);
+static hd108_status_t   hd108_anim_gif_image        (hd108_anim_t *anim);
+static hd108_status_t   hd108_anim_gif_frame        (hd108_anim_t *anim, uint32_t *delay_us);
+static hd108_status_t   hd108_anim_mjpeg_frame      (hd108_anim_t *anim);
+static void             hd108_anim_task             (void *anim_in);
+static void             hd108_anim_free             (hd108_anim_t *anim);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Read one byte through the read buffer.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - The byte, or EOF at the end of the file.
+ */
+static int hd108_anim_getc(hd108_anim_t *anim) {
+    if (anim->buf_pos == anim->buf_len) {
+        anim->buf_len = fread(anim->buf, 1, sizeof(anim->buf), anim->file);
+        anim->buf_pos = 0;
+        if (0 == anim->buf_len) {
+            return EOF;
+        }
+    }
+    return anim->buf[anim->buf_pos++];
+}
+
+
+/**
+ * @brief Read bytes through the read buffer.
+ *
+ * @param anim The address of the player.
+ * @param dst Destination, NULL to skip the bytes.
+ * @param len Number of bytes.
+ *
+ * @return
+ *         - true if every byte has been read, false at the end of the file.
+ */
+static bool hd108_anim_read(hd108_anim_t *anim, uint8_t *dst, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        int c = hd108_anim_getc(anim);
+        if (EOF == c) {
+            return false;
+        }
+        if (NULL != dst) {
+            dst[i] = (uint8_t)c;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Seek in the file and drop the read buffer.
+ *
+ * @param anim The address of the player.
+ * @param offset Offset from the start of the file.
+ */
+static void hd108_anim_seek(hd108_anim_t *anim, long offset) {
+    (void)fseek(anim->file, offset, SEEK_SET);
+    anim->buf_pos = 0;
+    anim->buf_len = 0;
+}
+
+
+/**
+ * @brief Position of the next byte in the file.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - Offset from the start of the file.
+ */
+static long hd108_anim_tell(hd108_anim_t *anim) {
+    return ftell(anim->file) - (anim->buf_len - anim->buf_pos);
+}
+
+
+/**
+ * @brief Take a free run from the ring.
+ *
+ * @note It waits while the ring is full, i.e. the update function has not
+ *       written the runs yet.
+ *
+ * @param anim The address of the player.
+ * @param run Out parameter for the index of the run.
+ *
+ * @return
+ *         - true on success, false if the player is being closed.
+ */
+static bool hd108_anim_take_run(hd108_anim_t *anim, uint8_t *run) {
+    if (pdTRUE != xQueueReceive(anim->free_runs, run, portMAX_DELAY)) {
+        return false;
+    }
+    return (HD108_ANIM_NO_RUN != *run) && !anim->stop;
+}
+
+
+/**
+ * @brief Pass a run of RGB888 pixels of one row to the update, clipped to the matrix.
+ *
+ * @param anim The address of the player.
+ * @param x Left column of the run, can be out of the matrix.
+ * @param y Row of the run, can be out of the matrix.
+ * @param count Number of pixels.
+ * @param rgb Pixels.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the player is being closed, the frame is abandoned
+ */
+static hd108_status_t hd108_anim_write_run(hd108_anim_t *anim, int32_t x, int32_t y, int32_t count, const uint8_t *rgb) {
+    uint8_t run;
+
+    if ((y < 0) || (y >= anim->height)) {
+        return HD108_LLD_OK;
+    }
+    if (x < 0) {
+        rgb += 3 * -x;
+        count += x;
+        x = 0;
+    }
+    if (x + count > anim->width) {
+        count = anim->width - x;
+    }
+    if (count <= 0) {
+        return HD108_LLD_OK;
+    }
+
+    if (!hd108_anim_take_run(anim, &run)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    anim->runs[run].x = (uint16_t)x;
+    anim->runs[run].y = (uint16_t)y;
+    anim->runs[run].count = (uint16_t)count;
+    memcpy(&anim->run_rgb[3 * (size_t)run * anim->width], rgb, 3 * count);
+    (void)xQueueSend(anim->full_runs, &run, portMAX_DELAY);
+
+    return HD108_LLD_OK;
+}
+
+
+/**
+ * @brief Pass the end of a frame to the update.
+ *
+ * @param anim The address of the player.
+ * @param status Status of the decoding of the frame.
+ * @param delay_us Delay of the frame.
+ *
+ * @return
+ *         - true on success, false if the player is being closed.
+ */
+static bool hd108_anim_end_frame(hd108_anim_t *anim, hd108_status_t status, uint32_t delay_us) {
+    uint8_t run;
+
+    if (!hd108_anim_take_run(anim, &run)) {
+        return false;
+    }
+    anim->runs[run].count = 0;
+    anim->runs[run].ended = anim->ended;
+    anim->runs[run].status = status;
+    anim->runs[run].delay_us = delay_us;
+    (void)xQueueSend(anim->full_runs, &run, portMAX_DELAY);
+
+    return true;
+}
+
+
+/**
+ * @brief Pass black runs for every row of the matrix to the update.
+ *
+ * @note The animation starts on a black matrix, whatever the LEDs showed
+ *       before, as frames can cover only a part of it.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - true on success, false if the player is being closed.
+ */
+static bool hd108_anim_clear(hd108_anim_t *anim) {
+    uint8_t run;
+
+    for (uint16_t y = 0; y < anim->height; y++) {
+        if (!hd108_anim_take_run(anim, &run)) {
+            return false;
+        }
+        anim->runs[run].x = 0;
+        anim->runs[run].y = y;
+        anim->runs[run].count = anim->width;
+        memset(&anim->run_rgb[3 * (size_t)run * anim->width], 0, 3UL * anim->width);
+        (void)xQueueSend(anim->full_runs, &run, portMAX_DELAY);
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Parse the GIF logical screen descriptor and the global color table.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the header is invalid
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ */
+static hd108_status_t hd108_anim_gif_header(hd108_anim_t *anim) {
+    uint8_t screen[7];
+    hd108_anim_gif_t *gif = anim->gif;
+
+    // logical screen descriptor, the signature has been read already
+    if (!hd108_anim_read(anim, screen, sizeof(screen))) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    gif->screen_width = screen[0] | (screen[1] << 8);
+    gif->screen_height = screen[2] | (screen[3] << 8);
+    if ((0 == gif->screen_width) || (HD108_MAP2D_MAX_SIZE < gif->screen_width) ||
+        (0 == gif->screen_height) || (HD108_MAP2D_MAX_SIZE < gif->screen_height)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    if (screen[4] & 0x80U) {
+        gif->global_size = 2U << (screen[4] & 0x07U);
+        if (!hd108_anim_read(anim, gif->global, 3 * gif->global_size)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    }
+    gif->first_frame = hd108_anim_tell(anim);
+
+    // one row of the widest possible frame
+    anim->row_index = (uint8_t *)malloc(gif->screen_width);
+    anim->row_rgb = (uint8_t *)malloc(3 * gif->screen_width);
+    gif->prefix = (uint16_t *)malloc(HD108_ANIM_LZW_CODES * sizeof(uint16_t));
+    gif->suffix = (uint8_t *)malloc(HD108_ANIM_LZW_CODES);
+    gif->stack = (uint8_t *)malloc(HD108_ANIM_LZW_CODES);
+    if (!anim->row_index || !anim->row_rgb || !gif->prefix || !gif->suffix || !gif->stack) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    gif->transparent = -1;
+
+    return HD108_LLD_OK;
+}
+
+
+/**
+ * @brief Skip data sub-blocks up to and including the terminator.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - true on success, false at the end of the file.
+ */
+static bool hd108_anim_gif_skip_blocks(hd108_anim_t *anim) {
+    for (;;) {
+        int len = hd108_anim_getc(anim);
+        if (EOF == len) {
+            return false;
+        }
+        if (0 == len) {
+            return true;
+        }
+        if (!hd108_anim_read(anim, NULL, len)) {
+            return false;
+        }
+    }
+}
+
+
+/**
+ * @brief Read the next byte of image data sub-blocks.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - The byte, or EOF after the terminator sub-block.
+ */
+static int hd108_anim_gif_data_byte(hd108_anim_t *anim) {
+    hd108_anim_gif_t *gif = anim->gif;
+
+    if (0 == gif->block_left) {
+        if (gif->block_end) {
+            return EOF;
+        }
+        int len = hd108_anim_getc(anim);
+        if ((EOF == len) || (0 == len)) {
+            gif->block_end = true;
+            return EOF;
+        }
+        gif->block_left = (uint8_t)len;
+    }
+    gif->block_left--;
+    return hd108_anim_getc(anim);
+}
+
+
+/**
+ * @brief Read the next LZW code.
+ *
+ * @param anim The address of the player.
+ * @param code_size Current code size in bits.
+ *
+ * @return
+ *         - The code, or EOF if the image data has ended.
+ */
+static int hd108_anim_gif_code(hd108_anim_t *anim, uint8_t code_size) {
+    hd108_anim_gif_t *gif = anim->gif;
+
+    while (gif->bit_cnt < code_size) {
+        int c = hd108_anim_gif_data_byte(anim);
+        if (EOF == c) {
+            return EOF;
+        }
+        gif->bit_buf |= (uint32_t)c << gif->bit_cnt;
+        gif->bit_cnt += 8;
+    }
+
+    int code = gif->bit_buf & ((1UL << code_size) - 1);
+    gif->bit_buf >>= code_size;
+    gif->bit_cnt -= code_size;
+
+    return code;
+}
+
+
+/**
+ * @brief Row of the n-th decoded row of an interlaced GIF frame.
+ *
+ * @note Pass 1 holds every 8th row from 0, pass 2 every 8th row from 4,
+ *       pass 3 every 4th row from 2 and pass 4 every 2nd row from 1.
+ *
+ * @param n Index of the decoded row.
+ * @param height Height of the frame.
+ *
+ * @return
+ *         - Row within the frame.
+ */
+static uint16_t hd108_anim_gif_interlace(uint16_t n, uint16_t height) {
+    uint16_t rows = (height + 7) / 8;
+    if (n < rows) {
+        return 8 * n;
+    }
+    n -= rows;
+    rows = (height + 3) / 8;
+    if (n < rows) {
+        return 8 * n + 4;
+    }
+    n -= rows;
+    rows = (height + 1) / 4;
+    if (n < rows) {
+        return 4 * n + 2;
+    }
+    return 2 * (n - rows) + 1;
+}
+
+
+/**
+ * @brief Write one decoded row of a GIF frame.
+ *
+ * @note Runs of opaque pixels are converted through the palette and written,
+ *       transparent pixels keep the previous frame.
+ *
+ * @param anim The address of the player.
+ * @param rect Rectangle of the frame: left, top, width, height.
+ * @param row Row within the frame.
+ *
+ * @return
+ *         - HD108_LLD_OK
+ */
+static hd108_status_t hd108_anim_gif_row(hd108_anim_t *anim, const uint16_t *rect, uint16_t row) {
+    hd108_anim_gif_t *gif = anim->gif;
+    hd108_status_t status = HD108_LLD_OK;
+    uint16_t start = 0;
+
+    for (uint16_t x = 0; x <= rect[2]; x++) {
+        bool opaque = (x < rect[2]) && (anim->row_index[x] != gif->transparent);
+        if (opaque) {
+            memcpy(&anim->row_rgb[3 * x], &gif->palette[3 * anim->row_index[x]], 3);
+            continue;
+        }
+        if ((x > start) && (HD108_LLD_OK == status)) {
+            status = hd108_anim_write_run(anim, rect[0] + start, rect[1] + row, x - start, &anim->row_rgb[3 * start]);
+        }
+        start = x + 1;
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Decode one GIF image (image descriptor, color table and LZW data).
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the image is corrupted
+ */
+static hd108_status_t hd108_anim_gif_image(hd108_anim_t *anim) {
+    hd108_anim_gif_t *gif = anim->gif;
+    hd108_status_t status = HD108_LLD_OK;
+    uint8_t desc[9];
+    uint16_t rect[4];
+
+    if (!hd108_anim_read(anim, desc, sizeof(desc))) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        rect[i] = desc[2 * i] | (desc[2 * i + 1] << 8);
+    }
+    if ((0 == rect[2]) || (rect[0] + rect[2] > gif->screen_width) ||
+        (0 == rect[3]) || (rect[1] + rect[3] > gif->screen_height)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // local color table replaces the global one for this frame
+    if (desc[8] & 0x80U) {
+        if (!hd108_anim_read(anim, gif->palette, 3 * (2U << (desc[8] & 0x07U)))) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    } else {
+        memcpy(gif->palette, gif->global, 3 * gif->global_size);
+    }
+    bool interlaced = (0 != (desc[8] & 0x40U));
+
+    // dispose the previous frame
+    if (2 == gif->prev_disposal) {
+        memset(anim->row_rgb, 0, 3 * gif->prev_rect[2]);
+        for (uint16_t y = 0; (y < gif->prev_rect[3]) && (HD108_LLD_OK == status); y++) {
+            status = hd108_anim_write_run(anim, gif->prev_rect[0], gif->prev_rect[1] + y, gif->prev_rect[2], anim->row_rgb);
+        }
+    }
+    memcpy(gif->prev_rect, rect, sizeof(rect));
+    gif->prev_disposal = gif->disposal;
+
+    int min_code_size = hd108_anim_getc(anim);
+    if ((min_code_size < 2) || (min_code_size > 8)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    uint16_t clear = 1U << min_code_size;
+    uint16_t next_code = clear + 2;
+    uint8_t code_size = min_code_size + 1;
+    int prev = -1;
+    uint8_t first = 0;
+    uint16_t x = 0;
+    uint16_t y = 0;
+
+    gif->block_left = 0;
+    gif->block_end = false;
+    gif->bit_buf = 0;
+    gif->bit_cnt = 0;
+    for (uint16_t i = 0; i < clear; i++) {
+        gif->suffix[i] = (uint8_t)i;
+    }
+
+    while ((y < rect[3]) && (HD108_LLD_OK == status)) {
+        int code = hd108_anim_gif_code(anim, code_size);
+        if ((EOF == code) || (clear + 1 == code)) {
+            break;
+        }
+        if (clear == code) {
+            next_code = clear + 2;
+            code_size = min_code_size + 1;
+            prev = -1;
+            continue;
+        }
+
+        uint16_t sp = 0;
+        int in = code;
+        if (-1 == prev) {
+            if (code >= clear) {
+                return HD108_LLD_ERROR_INVALID;
+            }
+            first = (uint8_t)code;
+            gif->stack[sp++] = first;
+        } else {
+            if (code > next_code) {
+                return HD108_LLD_ERROR_INVALID;
+            }
+            if (code == next_code) {
+                // the code is being defined right now: previous string + its first byte
+                gif->stack[sp++] = first;
+                code = prev;
+            }
+            while (code >= clear) {
+                gif->stack[sp++] = gif->suffix[code];
+                code = gif->prefix[code];
+            }
+            first = gif->suffix[code];
+            gif->stack[sp++] = first;
+
+            if (next_code < HD108_ANIM_LZW_CODES) {
+                gif->prefix[next_code] = (uint16_t)prev;
+                gif->suffix[next_code] = first;
+                next_code++;
+                if ((next_code == (1U << code_size)) && (code_size < 12)) {
+                    code_size++;
+                }
+            }
+        }
+        prev = in;
+
+        // the stack holds the string in reverse order
+        while ((sp > 0) && (y < rect[3])) {
+            anim->row_index[x++] = gif->stack[--sp];
+            if (x < rect[2]) {
+                continue;
+            }
+            if (HD108_LLD_OK == status) {
+                status = hd108_anim_gif_row(anim, rect, interlaced ? hd108_anim_gif_interlace(y, rect[3]) : y);
+            }
+            x = 0;
+            y++;
+        }
+    }
+
+    // skip the rest of the image data
+    if (!gif->block_end) {
+        if ((0 != gif->block_left) && !hd108_anim_read(anim, NULL, gif->block_left)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+        if (!hd108_anim_gif_skip_blocks(anim)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    }
+
+    gif->transparent = -1;
+    gif->disposal = 0;
+
+    return status;
+}
+
+
+/**
+ * @brief Decode the next GIF frame.
+ *
+ * @note Extensions before the image are parsed, the graphic control extension
+ *       sets delay, transparency and disposal. At the trailer the animation is
+ *       restarted or ended.
+ *
+ * @param anim The address of the player.
+ * @param delay_us Out parameter for the delay of the frame.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the file is corrupted
+ */
+static hd108_status_t hd108_anim_gif_frame(hd108_anim_t *anim, uint32_t *delay_us) {
+    hd108_anim_gif_t *gif = anim->gif;
+    bool restarted = false;
+
+    gif->delay_us = HD108_ANIM_GIF_DEF_DELAY;
+
+    for (;;) {
+        int introducer = hd108_anim_getc(anim);
+        switch (introducer) {
+            case 0x21: {
+                // extension
+                int label = hd108_anim_getc(anim);
+                if (0xf9 == label) {
+                    uint8_t gce[6];
+                    if (!hd108_anim_read(anim, gce, sizeof(gce))) {
+                        return HD108_LLD_ERROR_INVALID;
+                    }
+                    uint32_t delay = 10000UL * (gce[2] | (gce[3] << 8));
+                    gif->delay_us = (delay < HD108_ANIM_GIF_MIN_DELAY) ? HD108_ANIM_GIF_DEF_DELAY : delay;
+                    gif->disposal = (gce[1] >> 2) & 0x07U;
+                    gif->transparent = (gce[1] & 0x01U) ? gce[4] : -1;
+                } else if (!hd108_anim_gif_skip_blocks(anim)) {
+                    return HD108_LLD_ERROR_INVALID;
+                }
+                break;
+            }
+            case 0x2c:
+                // image
+                *delay_us = gif->delay_us;
+                return hd108_anim_gif_image(anim);
+            case 0x3b:
+            case EOF:
+                // trailer
+                if (!anim->loop || restarted) {
+                    anim->ended = true;
+                    return HD108_LLD_OK;
+                }
+                restarted = true;
+                hd108_anim_seek(anim, gif->first_frame);
+                break;
+            default:
+                return HD108_LLD_ERROR_INVALID;
+        }
+    }
+}
+
+
+#if CONFIG_HD108_MJPEG
+/**
+ * @brief tjpgd input function.
+ *
+ * @note The SOI marker, which has been consumed by the search, is passed
+ *       first. The offset of every chunk is kept, the next frame is searched
+ *       from the last one.
+ *
+ * @param jd Decoder object, the device is the player.
+ * @param buf Destination, NULL to skip.
+ * @param len Number of bytes.
+ *
+ * @return
+ *         - Number of bytes read or skipped.
+ */
+static size_t hd108_anim_jpeg_input(JDEC *jd, uint8_t *buf, size_t len) {
+    static const uint8_t soi[2] = {0xff, 0xd8};
+    hd108_anim_t *anim = (hd108_anim_t *)jd->device;
+    size_t i = 0;
+
+    anim->jpeg_chunk = hd108_anim_tell(anim);
+    for (; (i < len) && (0 != anim->jpeg_soi); i++) {
+        if (NULL != buf) {
+            buf[i] = soi[sizeof(soi) - anim->jpeg_soi];
+        }
+        anim->jpeg_soi--;
+    }
+    for (; i < len; i++) {
+        int c = hd108_anim_getc(anim);
+        if (EOF == c) {
+            break;
+        }
+        if (NULL != buf) {
+            buf[i] = (uint8_t)c;
+        }
+    }
+
+    return i;
+}
+
+
+/**
+ * @brief tjpgd output function.
+ *
+ * @note Each decoded block (RGB888) is passed to the update row by row.
+ *
+ * @param jd Decoder object, the device is the player.
+ * @param bitmap RGB888 pixels of the block.
+ * @param rect Rectangle of the block.
+ *
+ * @return
+ *         - 1 to continue, 0 to abandon the frame if the player is being closed.
+ */
+static int hd108_anim_jpeg_output(JDEC *jd, void *bitmap, JRECT *rect) {
+    hd108_anim_t *anim = (hd108_anim_t *)jd->device;
+    const uint8_t *rgb = (const uint8_t *)bitmap;
+    int32_t width = rect->right - rect->left + 1;
+
+    for (int32_t y = rect->top; y <= rect->bottom; y++, rgb += 3 * width) {
+        if (HD108_LLD_OK != hd108_anim_write_run(anim, rect->left, y, width, rgb)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+#endif
+
+
+/**
+ * @brief Decode the next MJPEG frame.
+ *
+ * @note The next frame starts at the next SOI marker. The entropy coded data
+ *       of a frame never contains an SOI and tjpgd requests a chunk only
+ *       while it needs data of the frame, so the search for the next frame
+ *       continues at the last chunk: at most one chunk is read twice.
+ *
+ * @param anim The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the frame is corrupted or MJPEG is not enabled
+ */
+static hd108_status_t hd108_anim_mjpeg_frame(hd108_anim_t *anim) {
+#if CONFIG_HD108_MJPEG
+    bool restarted = false;
+    int prev = 0;
+
+    // find SOI (FF D8)
+    for (;;) {
+        int c = hd108_anim_getc(anim);
+        if (EOF == c) {
+            if (!anim->loop || restarted) {
+                anim->ended = true;
+                return HD108_LLD_OK;
+            }
+            restarted = true;
+            hd108_anim_seek(anim, 0);
+            prev = 0;
+            continue;
+        }
+        if ((0xff == prev) && (0xd8 == c)) {
+            break;
+        }
+        prev = c;
+    }
+
+    JDEC jd;
+    anim->jpeg_soi = 2;
+    JRESULT result = jd_prepare(&jd, hd108_anim_jpeg_input, anim->jpeg_pool, HD108_ANIM_JPEG_POOL, anim);
+    if (JDR_OK == result) {
+        result = jd_decomp(&jd, hd108_anim_jpeg_output, 0);
+    }
+
+    hd108_anim_seek(anim, anim->jpeg_chunk);
+
+    return (JDR_OK == result) ? HD108_LLD_OK : HD108_LLD_ERROR_INVALID;
+#else
+    (void)anim;
+    return HD108_LLD_ERROR_INVALID;
+#endif
+}
+
+
+/**
+ * @brief Decoder task.
+ *
+ * @note The frames are decoded one after the other, each is followed by its
+ *       end marker. The ring holds only a few runs, so the task decodes at
+ *       most that far ahead of the update function, and the rest of a frame
+ *       is decoded while its first runs are written. File system access and
+ *       decoding stay out of the update function.
+ *
+ * @param anim_in The address of the player.
+ */
+static void hd108_anim_task(void *anim_in) {
+    // cast player
+    hd108_anim_t *anim = anim_in;
+    uint8_t run;
+
+    bool running = hd108_anim_clear(anim);
+    while (running && !anim->ended) {
+        uint32_t delay_us = anim->frame_us;
+        hd108_status_t status;
+        if (HD108_ANIM_GIF == anim->format) {
+            status = hd108_anim_gif_frame(anim, &delay_us);
+        } else {
+            status = hd108_anim_mjpeg_frame(anim);
+        }
+        running = !anim->stop && hd108_anim_end_frame(anim, status, delay_us);
+    }
+
+    // nothing left to decode, the runs still come back until the close
+    while (!anim->stop && (pdTRUE == xQueueReceive(anim->free_runs, &run, portMAX_DELAY))) {
+    }
+
+    xSemaphoreGive(anim->done);
+    vTaskDelete(NULL);
+}
+
+
+/**
+ * @brief Free the player and everything it has allocated.
+ *
+ * @param anim The address of the player.
+ */
+static void hd108_anim_free(hd108_anim_t *anim) {
+    if (anim->gif) {
+        free(anim->gif->prefix);
+        free(anim->gif->suffix);
+        free(anim->gif->stack);
+        free(anim->gif);
+    }
+    if (anim->done) {
+        vSemaphoreDelete(anim->done);
+    }
+    if (anim->full_runs) {
+        vQueueDelete(anim->full_runs);
+    }
+    if (anim->free_runs) {
+        vQueueDelete(anim->free_runs);
+    }
+    free(anim->run_rgb);
+    free(anim->row_index);
+    free(anim->row_rgb);
+    free(anim->jpeg_pool);
+    if (anim->file) {
+        fclose(anim->file);
+    }
+    free(anim);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_anim_open(const hd108_anim_configuration_t *anim_configuration, void **anim_out) {
+    uint8_t magic[6];
+    hd108_status_t status = HD108_LLD_OK;
+
+    // check mapping and path
+    if ((NULL == anim_configuration->map) || (NULL == anim_configuration->path)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for player
+    hd108_anim_t *anim = (hd108_anim_t *)calloc(1, sizeof(hd108_anim_t));
+    if (!anim) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    anim->file = fopen(anim_configuration->path, "rb");
+    if (!anim->file) {
+        hd108_anim_free(anim);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    anim->map = anim_configuration->map;
+    anim->current = anim_configuration->current;
+    anim->loop = anim_configuration->loop;
+    anim->frame_us = anim_configuration->mjpeg_frame_us;
+    hd108_map2d_get_size(anim->map, &anim->width, &anim->height);
+
+    // detect format
+    if (!hd108_anim_read(anim, magic, sizeof(magic))) {
+        status = HD108_LLD_ERROR_INVALID;
+    } else if ((0 == memcmp(magic, "GIF87a", 6)) || (0 == memcmp(magic, "GIF89a", 6))) {
+        anim->format = HD108_ANIM_GIF;
+        anim->gif = (hd108_anim_gif_t *)calloc(1, sizeof(hd108_anim_gif_t));
+        status = anim->gif ? hd108_anim_gif_header(anim) : HD108_LLD_ERROR_NO_MEMORY;
+    } else if ((0xff == magic[0]) && (0xd8 == magic[1])) {
+#if CONFIG_HD108_MJPEG
+        anim->format = HD108_ANIM_MJPEG_STREAM;
+        anim->jpeg_pool = malloc(HD108_ANIM_JPEG_POOL);
+        status = anim->jpeg_pool ? HD108_LLD_OK : HD108_LLD_ERROR_NO_MEMORY;
+        hd108_anim_seek(anim, 0);
+#else
+        status = HD108_LLD_ERROR_INVALID;
+#endif
+    } else {
+        status = HD108_LLD_ERROR_INVALID;
+    }
+
+    if ((HD108_LLD_OK == status) && (HD108_ANIM_MJPEG_STREAM == anim->format) && (0 == anim->frame_us)) {
+        status = HD108_LLD_ERROR_INVALID;
+    }
+
+    // the free queue has a spare slot for the wake-up of the close
+    if (HD108_LLD_OK == status) {
+        anim->run_rgb = (uint8_t *)malloc(HD108_ANIM_RUN_COUNT * 3UL * anim->width);
+        anim->free_runs = xQueueCreate(HD108_ANIM_RUN_COUNT + 1, sizeof(uint8_t));
+        anim->full_runs = xQueueCreate(HD108_ANIM_RUN_COUNT, sizeof(uint8_t));
+        anim->done = xSemaphoreCreateBinary();
+        if (!anim->run_rgb || !anim->free_runs || !anim->full_runs || !anim->done) {
+            status = HD108_LLD_ERROR_NO_MEMORY;
+        }
+    }
+    for (uint8_t run = 0; (HD108_LLD_OK == status) && (run < HD108_ANIM_RUN_COUNT); run++) {
+        (void)xQueueSend(anim->free_runs, &run, 0);
+    }
+
+    if ((HD108_LLD_OK == status) &&
+        (pdPASS != xTaskCreate(hd108_anim_task, "hd108_anim", HD108_ANIM_TASK_STACK, anim, anim_configuration->priority, NULL))) {
+        status = HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    if (HD108_LLD_OK != status) {
+        hd108_anim_free(anim);
+        return status;
+    }
+
+    // the task decodes the first frame right away
+    anim->due = esp_timer_get_time();
+
+    // set out parameter
+    *anim_out = anim;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_anim_update(void *anim_in) {
+    // cast player
+    hd108_anim_t *anim = anim_in;
+    uint8_t run;
+
+    int64_t now = esp_timer_get_time();
+    if (anim->finished) {
+        return HD108_LLD_OK;
+    }
+    if (!anim->showing) {
+        if (now < anim->due) {
+            return HD108_LLD_OK;
+        }
+        anim->showing = true;
+        anim->status = HD108_LLD_OK;
+    }
+
+    // write the runs of the due frame as they come, if the decoder is late
+    // the rest of the frame follows with the next updates
+    while (pdTRUE == xQueueReceive(anim->full_runs, &run, 0)) {
+        hd108_anim_run_t *entry = &anim->runs[run];
+        if (0 != entry->count) {
+            hd108_status_t status = hd108_map2d_write_rgb888(anim->map, entry->x, entry->y, entry->count, 1,
+                                                             &anim->run_rgb[3 * (size_t)run * anim->width], anim->current);
+            if (HD108_LLD_OK == anim->status) {
+                anim->status = status;
+            }
+            (void)xQueueSend(anim->free_runs, &run, 0);
+            continue;
+        }
+
+        // end of the frame
+        bool ended = entry->ended;
+        uint32_t delay_us = entry->delay_us;
+        hd108_status_t status = (HD108_LLD_OK != entry->status) ? entry->status : anim->status;
+        (void)xQueueSend(anim->free_runs, &run, 0);
+        anim->showing = false;
+        if (ended) {
+            anim->finished = true;
+            return HD108_LLD_OK;
+        }
+
+        // keep the pace, but do not try to catch up after a long stall
+        anim->due += delay_us;
+        if (anim->due < now) {
+            anim->due = now + delay_us;
+        }
+        return status;
+    }
+
+    return HD108_LLD_OK;
+}
+
+void hd108_anim_close(void *anim_in) {
+    // cast player
+    hd108_anim_t *anim = anim_in;
+    uint8_t wake = HD108_ANIM_NO_RUN;
+
+    // the task abandons the frame in progress at its next run, the free queue
+    // has a spare slot for the wake-up
+    anim->stop = true;
+    (void)xQueueSend(anim->free_runs, &wake, portMAX_DELAY);
+    (void)xSemaphoreTake(anim->done, portMAX_DELAY);
+
+    hd108_anim_free(anim);
+}
@@ -0,0 +1,198 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "HD108_arena.h"
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Size class.
+ */
+typedef struct {
+    uint8_t            *base;           ///< First slot
+    uint32_t            size;           ///< Size of a slot, multiple of HD108_ARENA_ALIGN
+    uint16_t            slots;          ///< Number of slots
+    uint16_t            free_count;     ///< Number of free slots
+    uint16_t           *free_slots;     ///< Stack of the free slot indices
+    uint16_t            high_water;     ///< Most slots in use at the same time
+    uint32_t            failed;         ///< Requests that found no free slot
+} hd108_arena_class_ctx_t;
+
+
+/**
+ * @brief Arena variable.
+ */
+typedef struct {
+    portMUX_TYPE            lock;       ///< Protects the free slots
+    void                   *mem;        ///< The reserved block
+    uint8_t                 count;      ///< Number of classes
+    hd108_arena_class_ctx_t classes[HD108_ARENA_MAX_CLASSES];  ///< Size classes
+} hd108_arena_t;
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_arena_init(const hd108_arena_configuration_t *arena_configuration, void **arena_out) {
+    size_t total = 0;
+    size_t slots = 0;
+
+    // check classes
+    if ((NULL == arena_configuration->classes) || (0 == arena_configuration->class_count) ||
+        (HD108_ARENA_MAX_CLASSES < arena_configuration->class_count)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    for (uint8_t i = 0; i < arena_configuration->class_count; i++) {
+        const hd108_arena_class_t *cls = &arena_configuration->classes[i];
+        if ((0 == cls->size) || (0 == cls->slots) || ((0 != i) && (cls->size <= arena_configuration->classes[i - 1].size))) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+        total += (size_t)((cls->size + HD108_ARENA_ALIGN - 1) & ~(HD108_ARENA_ALIGN - 1)) * cls->slots;
+        slots += cls->slots;
+    }
+
+    // allocate memory for arena, the free slot stacks share one block
+    hd108_arena_t *arena = (hd108_arena_t *)calloc(1, sizeof(hd108_arena_t));
+    uint16_t *free_slots = (uint16_t *)malloc(slots * sizeof(uint16_t));
+    uint32_t caps = (0 != arena_configuration->caps) ? arena_configuration->caps : (MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
+    void *mem = heap_caps_aligned_alloc(HD108_ARENA_ALIGN, total, caps);
+    if (!arena || !free_slots || !mem) {
+        heap_caps_free(mem);
+        free(free_slots);
+        free(arena);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    arena->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    arena->mem = mem;
+    arena->count = arena_configuration->class_count;
+
+    uint8_t *base = mem;
+    for (uint8_t i = 0; i < arena->count; i++) {
+        hd108_arena_class_ctx_t *cls = &arena->classes[i];
+        cls->base = base;
+        cls->size = (arena_configuration->classes[i].size + HD108_ARENA_ALIGN - 1) & ~(HD108_ARENA_ALIGN - 1);
+        cls->slots = arena_configuration->classes[i].slots;
+        cls->free_slots = free_slots;
+        cls->free_count = cls->slots;
+        // lowest slot on top of the stack
+        for (uint16_t slot = 0; slot < cls->slots; slot++) {
+            cls->free_slots[slot] = cls->slots - 1 - slot;
+        }
+        base += (size_t)cls->size * cls->slots;
+        free_slots += cls->slots;
+    }
+
+    // set out parameter
+    *arena_out = arena;
+
+    return HD108_LLD_OK;
+}
+
+void *hd108_arena_alloc(void *arena_in, size_t size) {
+    // cast arena
+    hd108_arena_t *arena = arena_in;
+    void *mem = NULL;
+
+    portENTER_CRITICAL(&arena->lock);
+    uint8_t fit = arena->count;
+    for (uint8_t i = 0; i < arena->count; i++) {
+        hd108_arena_class_ctx_t *cls = &arena->classes[i];
+        if (cls->size < size) {
+            continue;
+        }
+        if (fit == arena->count) {
+            fit = i;
+        }
+        if (0 != cls->free_count) {
+            uint16_t slot = cls->free_slots[--cls->free_count];
+            uint16_t used = cls->slots - cls->free_count;
+            if (used > cls->high_water) {
+                cls->high_water = used;
+            }
+            mem = cls->base + (size_t)cls->size * slot;
+            break;
+        }
+    }
+    if ((NULL == mem) && (fit != arena->count)) {
+        arena->classes[fit].failed++;
+    }
+    portEXIT_CRITICAL(&arena->lock);
+
+    return mem;
+}
+
+void hd108_arena_free(void *arena_in, void *mem) {
+    // cast arena
+    hd108_arena_t *arena = arena_in;
+
+    if (NULL == mem) {
+        return;
+    }
+
+    portENTER_CRITICAL(&arena->lock);
+    for (uint8_t i = 0; i < arena->count; i++) {
+        hd108_arena_class_ctx_t *cls = &arena->classes[i];
+        if (((uint8_t *)mem >= cls->base) && ((uint8_t *)mem < cls->base + (size_t)cls->size * cls->slots)) {
+            cls->free_slots[cls->free_count++] = (uint16_t)(((uint8_t *)mem - cls->base) / cls->size);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&arena->lock);
+}
+
+hd108_status_t hd108_arena_get_stats(void *arena_in, uint8_t class_index, hd108_arena_stats_t *stats_out) {
+    // cast arena
+    hd108_arena_t *arena = arena_in;
+
+    if (class_index >= arena->count) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    portENTER_CRITICAL(&arena->lock);
+    const hd108_arena_class_ctx_t *cls = &arena->classes[class_index];
+    stats_out->size = cls->size;
+    stats_out->slots = cls->slots;
+    stats_out->used = cls->slots - cls->free_count;
+    stats_out->high_water = cls->high_water;
+    stats_out->failed = cls->failed;
+    portEXIT_CRITICAL(&arena->lock);
+
+    return HD108_LLD_OK;
+}
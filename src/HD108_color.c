@@ -0,0 +1,551 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <string.h>
+
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+#include "HD108_color.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_COLOR_SIN_BITS        (       8UL)    ///< quarter wave table has 2^8 + 1 entries
+#define HD108_COLOR_SIN_FRAC_BITS   (       6UL)    ///< interpolated bits between two table entries
+#define HD108_COLOR_SIMD_ALIGN      (      16UL)    ///< alignment of the vector loads and stores
+#define HD108_COLOR_SIMD_LANES      (       8UL)    ///< color values per vector
+#define HD108_COLOR_BLOCK           (       8UL)    ///< color values per block of the scalar array loops
+#define HD108_COLOR_F2              (393016785UL)   ///< simplex skew factor (sqrt(3) - 1) / 2 in Q30
+#define HD108_COLOR_G2              (   13850L)     ///< simplex unskew factor (3 - sqrt(3)) / 6 in Q16
+#define HD108_COLOR_F3              (357913941UL)   ///< simplex skew factor 1 / 3 in Q30
+#define HD108_COLOR_G3              (   10923L)     ///< simplex unskew factor 1 / 6 in Q16
+#define HD108_COLOR_SCALE2          (      70L)     ///< scales the 2D simplex sum to [-1 .. 1]
+#define HD108_COLOR_SCALE3          (      32L)     ///< scales the 3D simplex sum to [-1 .. 1]
+
+#ifndef HD108_COLOR_SIMD
+#if CONFIG_IDF_TARGET_ESP32S3
+#define HD108_COLOR_SIMD            (1)             ///< array kernels use the PIE vector instructions of the ESP32-S3
+#else
+#define HD108_COLOR_SIMD            (0)
+#endif
+#endif
+
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/**
+ * @brief Quarter wave sine table, 32767 * sin(k * pi / 512).
+ */
+static const int16_t hd108_color_sin_table[(1UL << HD108_COLOR_SIN_BITS) + 1] = {
+        0,   201,   402,   603,   804,  1005,  1206,  1407,
+     1608,  1809,  2009,  2210,  2410,  2611,  2811,  3012,
+     3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+     6393,  6590,  6786,  6983,  7179,  7375,  7571,  7767,
+     7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+     9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849,
+    11039, 11228, 11417, 11605, 11793, 11980, 12167, 12353,
+    12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+    14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+    15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673,
+    16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+    18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357,
+    19519, 19680, 19841, 20000, 20159, 20317, 20475, 20631,
+    20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027,
+    23170, 23311, 23452, 23592, 23731, 23870, 24007, 24143,
+    24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+    25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198,
+    26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+    27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+    28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803,
+    28898, 28992, 29085, 29177, 29268, 29358, 29447, 29534,
+    29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+    30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783,
+    30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297,
+    31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+    31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098,
+    32137, 32176, 32213, 32250, 32285, 32318, 32351, 32382,
+    32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717,
+    32728, 32737, 32745, 32752, 32757, 32761, 32765, 32766,
+    32767,
+};
+
+
+/**
+ * @brief Gradients of 2D simplex noise.
+ */
+static const int8_t hd108_color_grad2[8][2] = {
+    { 1,  1}, {-1,  1}, { 1, -1}, {-1, -1},
+    { 1,  0}, {-1,  0}, { 0,  1}, { 0, -1},
+};
+
+
+/**
+ * @brief Gradients of 3D simplex noise, the edges of a cube.
+ */
+static const int8_t hd108_color_grad3[12][3] = {
+    { 1,  1,  0}, {-1,  1,  0}, { 1, -1,  0}, {-1, -1,  0},
+    { 1,  0,  1}, {-1,  0,  1}, { 1,  0, -1}, {-1,  0, -1},
+    { 0,  1,  1}, { 0, -1,  1}, { 0,  1, -1}, { 0, -1, -1},
+};
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static uint16_t     hd108_color_hash16          (uint32_t x);
+static uint16_t     hd108_color_fade16          (uint16_t t);
+static int32_t      hd108_color_corner2         (uint16_t hash, int32_t x, int32_t y);
+static int32_t      hd108_color_corner3         (uint16_t hash, int32_t x, int32_t y, int32_t z);
+#if HD108_COLOR_SIMD
+static void         hd108_color_qadd16_pie      (hd108_color_t *dst, const hd108_color_t *src, size_t blocks);
+static void         hd108_color_scale16_pie     (hd108_color_t *dst, const hd108_color_t *src, size_t blocks, uint16_t factor);
+#endif
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Integer hash of a lattice point.
+ *
+ * @param x Lattice point, coordinates already mixed.
+ *
+ * @return
+ *         - Random value in the range [0 .. 65535].
+ */
+static uint16_t hd108_color_hash16(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dUL;
+    x ^= x >> 15;
+    x *= 0x846ca68bUL;
+    x ^= x >> 16;
+    return (uint16_t)x;
+}
+
+
+/**
+ * @brief Smoothstep fade curve, 3t^2 - 2t^3.
+ *
+ * @param t Fraction in Q16.
+ *
+ * @return
+ *         - Faded fraction in Q16.
+ */
+static uint16_t hd108_color_fade16(uint16_t t) {
+    uint32_t t2 = ((uint32_t)t * t) >> 16;
+    uint32_t t3 = (t2 * t) >> 16;
+    uint32_t v = 3 * t2 - 2 * t3;
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+
+/**
+ * @brief Contribution of a corner of a 2D simplex.
+ *
+ * @note The offsets are below 1.0, so Q15 squares fit 32 bits.
+ *
+ * @param hash Hash of the corner, it selects the gradient.
+ * @param x First offset from the corner, Q16.
+ * @param y Second offset from the corner, Q16.
+ *
+ * @return
+ *         - (0.5 - x^2 - y^2)^4 * dot(gradient, offset) in Q31, 0 outside of the radius.
+ */
+static int32_t hd108_color_corner2(uint16_t hash, int32_t x, int32_t y) {
+    x >>= 1;
+    y >>= 1;
+    int32_t t = 16384L - ((x * x) >> 15) - ((y * y) >> 15);
+    if (t <= 0) {
+        return 0;
+    }
+
+    const int8_t *grad = hd108_color_grad2[hash & 7U];
+    int32_t t2 = (t * t) >> 14;
+    int32_t t4 = (t2 * t2) >> 16;
+    return t4 * (grad[0] * x + grad[1] * y);
+}
+
+
+/**
+ * @brief Contribution of a corner of a 3D simplex.
+ *
+ * @param hash Hash of the corner, it selects the gradient.
+ * @param x First offset from the corner, Q16.
+ * @param y Second offset from the corner, Q16.
+ * @param z Third offset from the corner, Q16.
+ *
+ * @return
+ *         - (0.6 - x^2 - y^2 - z^2)^4 * dot(gradient, offset) in Q30, 0 outside of the radius.
+ */
+static int32_t hd108_color_corner3(uint16_t hash, int32_t x, int32_t y, int32_t z) {
+    x >>= 1;
+    y >>= 1;
+    z >>= 1;
+    int32_t t = 19661L - ((x * x) >> 15) - ((y * y) >> 15) - ((z * z) >> 15);
+    if (t <= 0) {
+        return 0;
+    }
+
+    const int8_t *grad = hd108_color_grad3[((uint32_t)hash * 12U) >> 16];
+    int32_t t2 = (t * t) >> 14;
+    int32_t t4 = (t2 * t2) >> 16;
+    return (t4 * (grad[0] * x + grad[1] * y + grad[2] * z)) >> 1;
+}
+
+
+#if HD108_COLOR_SIMD
+/**
+ * @brief Saturating addition of 8 color values per step with the PIE.
+ *
+ * @note The lanes are widened to 32 bits by zipping them with zero, added
+ *       and limited to 65535, then narrowed again. Both arrays shall be
+ *       aligned to HD108_COLOR_SIMD_ALIGN.
+ *
+ * @param dst Destination and first operand.
+ * @param src Second operand.
+ * @param blocks Number of vectors, at least 1.
+ */
+static void hd108_color_qadd16_pie(hd108_color_t *dst, const hd108_color_t *src, size_t blocks) {
+    const uint32_t limit = UINT16_MAX;
+    hd108_color_t *out = dst;
+
+    __asm__ volatile (
+        "ee.vldbc.32        q6, %[limit]                \n"
+        "1:                                             \n"
+        "ee.vld.128.ip      q0, %[dst], 16              \n"
+        "ee.vld.128.ip      q2, %[src], 16              \n"
+        "ee.zero.q          q1                          \n"
+        "ee.zero.q          q3                          \n"
+        "ee.vzip.16         q0, q1                      \n"
+        "ee.vzip.16         q2, q3                      \n"
+        "ee.vadds.s32       q0, q0, q2                  \n"
+        "ee.vadds.s32       q1, q1, q3                  \n"
+        "ee.vmin.s32        q0, q0, q6                  \n"
+        "ee.vmin.s32        q1, q1, q6                  \n"
+        "ee.vunzip.16       q0, q1                      \n"
+        "addi               %[blocks], %[blocks], -1    \n"
+        "ee.vst.128.ip      q0, %[out], 16              \n"
+        "bnez               %[blocks], 1b               \n"
+        : [dst] "+r" (dst), [src] "+r" (src), [out] "+r" (out), [blocks] "+r" (blocks)
+        : [limit] "r" (&limit)
+        : "memory"
+    );
+}
+
+
+/**
+ * @brief Scale 8 color values per step with the PIE.
+ *
+ * @note EE.VMUL.U16 shifts the 32-bit products right by SAR, which is 16 here.
+ *       Both arrays shall be aligned to HD108_COLOR_SIMD_ALIGN.
+ *
+ * @param dst Destination, can be the same as src.
+ * @param src Color values.
+ * @param blocks Number of vectors, at least 1.
+ * @param factor Scale factor plus 1, at most 65535.
+ */
+static void hd108_color_scale16_pie(hd108_color_t *dst, const hd108_color_t *src, size_t blocks, uint16_t factor) {
+    const uint32_t shift = 16;
+
+    __asm__ volatile (
+        "wsr.sar            %[shift]                    \n"
+        "ee.vldbc.16        q1, %[factor]               \n"
+        "1:                                             \n"
+        "ee.vld.128.ip      q0, %[src], 16              \n"
+        "ee.vmul.u16        q2, q0, q1                  \n"
+        "addi               %[blocks], %[blocks], -1    \n"
+        "ee.vst.128.ip      q2, %[dst], 16              \n"
+        "bnez               %[blocks], 1b               \n"
+        : [dst] "+r" (dst), [src] "+r" (src), [blocks] "+r" (blocks)
+        : [shift] "r" (shift), [factor] "r" (&factor)
+        : "memory"
+    );
+}
+#endif
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+void hd108_color_qadd16_array(hd108_color_t *dst, const hd108_color_t *src, size_t count) {
+    size_t i = 0;
+
+#if HD108_COLOR_SIMD
+    // the arrays can be aligned together if their offsets match
+    if (0 == (((uintptr_t)dst ^ (uintptr_t)src) & (HD108_COLOR_SIMD_ALIGN - 1))) {
+        for (; (i < count) && (0 != ((uintptr_t)&dst[i] & (HD108_COLOR_SIMD_ALIGN - 1))); i++) {
+            dst[i] = hd108_color_qadd16(dst[i], src[i]);
+        }
+        size_t blocks = (count - i) / HD108_COLOR_SIMD_LANES;
+        if (0 != blocks) {
+            hd108_color_qadd16_pie(&dst[i], &src[i], blocks);
+            i += blocks * HD108_COLOR_SIMD_LANES;
+        }
+    }
+#endif
+
+    // an add and a compare per value in blocks of a fixed length, which the
+    // compiler vectorizes or unrolls, each value only depends on the same index
+    for (; i + HD108_COLOR_BLOCK <= count; i += HD108_COLOR_BLOCK) {
+#pragma GCC ivdep
+        for (size_t j = i; j < i + HD108_COLOR_BLOCK; j++) {
+            dst[j] = hd108_color_qadd16(dst[j], src[j]);
+        }
+    }
+    for (; i < count; i++) {
+        dst[i] = hd108_color_qadd16(dst[i], src[i]);
+    }
+}
+
+void hd108_color_scale16_array(hd108_color_t *dst, const hd108_color_t *src, size_t count, uint16_t scale) {
+    uint32_t factor = (uint32_t)scale + 1;
+    size_t i = 0;
+
+#if HD108_COLOR_SIMD
+    // the factor of a full scale does not fit a lane
+    if ((UINT16_MAX != scale) && (0 == (((uintptr_t)dst ^ (uintptr_t)src) & (HD108_COLOR_SIMD_ALIGN - 1)))) {
+        for (; (i < count) && (0 != ((uintptr_t)&dst[i] & (HD108_COLOR_SIMD_ALIGN - 1))); i++) {
+            dst[i] = (hd108_color_t)((src[i] * factor) >> 16);
+        }
+        size_t blocks = (count - i) / HD108_COLOR_SIMD_LANES;
+        if (0 != blocks) {
+            hd108_color_scale16_pie(&dst[i], &src[i], blocks, (uint16_t)factor);
+            i += blocks * HD108_COLOR_SIMD_LANES;
+        }
+    }
+#endif
+
+    // independent products keep the multiplier pipeline busy
+    for (; i + 3 < count; i += 4) {
+        uint32_t p0 = src[i + 0] * factor;
+        uint32_t p1 = src[i + 1] * factor;
+        uint32_t p2 = src[i + 2] * factor;
+        uint32_t p3 = src[i + 3] * factor;
+        dst[i + 0] = (hd108_color_t)(p0 >> 16);
+        dst[i + 1] = (hd108_color_t)(p1 >> 16);
+        dst[i + 2] = (hd108_color_t)(p2 >> 16);
+        dst[i + 3] = (hd108_color_t)(p3 >> 16);
+    }
+
+    for (; i < count; i++) {
+        dst[i] = (hd108_color_t)((src[i] * factor) >> 16);
+    }
+}
+
+void hd108_color_lerp16_array(hd108_color_t *dst, const hd108_color_t *a, const hd108_color_t *b, size_t count, hd108_fract16_t frac) {
+    size_t i = 0;
+
+    // a * (65536 - frac) + b * frac is (a << 16) + (b - a) * frac, one product
+    // per value, exact in modulo 2^32 arithmetic as the sum fits 32 bits
+    for (; i + HD108_COLOR_BLOCK <= count; i += HD108_COLOR_BLOCK) {
+#pragma GCC ivdep
+        for (size_t j = i; j < i + HD108_COLOR_BLOCK; j++) {
+            uint32_t v = ((uint32_t)a[j] << 16) + (uint32_t)((int32_t)b[j] - a[j]) * frac;
+            dst[j] = (hd108_color_t)(v >> 16);
+        }
+    }
+    for (; i < count; i++) {
+        uint32_t v = ((uint32_t)a[i] << 16) + (uint32_t)((int32_t)b[i] - a[i]) * frac;
+        dst[i] = (hd108_color_t)(v >> 16);
+    }
+}
+
+int16_t hd108_sin16(uint16_t theta) {
+    uint16_t quadrant = theta >> 14;
+    uint16_t offset = theta & 0x3fffU;
+
+    // mirror the table in the second and fourth quadrant
+    if (quadrant & 1U) {
+        offset = 0x4000U - offset;
+    }
+
+    uint16_t entry = offset >> HD108_COLOR_SIN_FRAC_BITS;
+    uint16_t frac = offset & ((1U << HD108_COLOR_SIN_FRAC_BITS) - 1);
+    int32_t value = hd108_color_sin_table[entry];
+    if (0 != frac) {
+        value += ((hd108_color_sin_table[entry + 1] - value) * (int32_t)frac) >> HD108_COLOR_SIN_FRAC_BITS;
+    }
+
+    return (int16_t)((quadrant & 2U) ? -value : value);
+}
+
+int16_t hd108_cos16(uint16_t theta) {
+    return hd108_sin16((uint16_t)(theta + 0x4000U));
+}
+
+void hd108_sin16_array(int16_t *dst, const uint16_t *theta, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = hd108_sin16(theta[i]);
+    }
+}
+
+uint16_t hd108_noise16_1d(uint32_t x) {
+    uint32_t xi = x >> 16;
+    hd108_fract16_t fx = hd108_color_fade16(x & 0xffffU);
+
+    return hd108_color_lerp16(hd108_color_hash16(xi), hd108_color_hash16(xi + 1), fx);
+}
+
+uint16_t hd108_noise16_2d(uint32_t x, uint32_t y) {
+    uint32_t xi = x >> 16;
+    uint32_t yi = (y >> 16) * 0x9e3779b1UL;
+    uint32_t yj = yi + 0x9e3779b1UL;
+    hd108_fract16_t fx = hd108_color_fade16(x & 0xffffU);
+    hd108_fract16_t fy = hd108_color_fade16(y & 0xffffU);
+
+    uint16_t v0 = hd108_color_lerp16(hd108_color_hash16(xi ^ yi), hd108_color_hash16((xi + 1) ^ yi), fx);
+    uint16_t v1 = hd108_color_lerp16(hd108_color_hash16(xi ^ yj), hd108_color_hash16((xi + 1) ^ yj), fx);
+
+    return hd108_color_lerp16(v0, v1, fy);
+}
+
+uint16_t hd108_noise16_3d(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t zi = (z >> 16) * 0x85ebca77UL;
+    uint32_t zj = zi + 0x85ebca77UL;
+    hd108_fract16_t fz = hd108_color_fade16(z & 0xffffU);
+
+    // each z slice is a 2D noise with a different seed
+    uint16_t v0 = hd108_noise16_2d(x ^ (zi & 0xffff0000UL), y + (zi << 16));
+    uint16_t v1 = hd108_noise16_2d(x ^ (zj & 0xffff0000UL), y + (zj << 16));
+
+    return hd108_color_lerp16(v0, v1, fz);
+}
+
+void hd108_noise16_2d_row(uint16_t *dst, size_t count, uint32_t x, uint32_t dx, uint32_t y) {
+    uint32_t yi = (y >> 16) * 0x9e3779b1UL;
+    uint32_t yj = yi + 0x9e3779b1UL;
+    hd108_fract16_t fy = hd108_color_fade16(y & 0xffffU);
+    uint32_t xi = (x >> 16) + 1;
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+
+    for (size_t i = 0; i < count; i++, x += dx) {
+        // corners are blended along y once per lattice cell
+        if ((x >> 16) != xi) {
+            xi = x >> 16;
+            c0 = hd108_color_lerp16(hd108_color_hash16(xi ^ yi), hd108_color_hash16(xi ^ yj), fy);
+            c1 = hd108_color_lerp16(hd108_color_hash16((xi + 1) ^ yi), hd108_color_hash16((xi + 1) ^ yj), fy);
+        }
+        dst[i] = hd108_color_lerp16(c0, c1, hd108_color_fade16(x & 0xffffU));
+    }
+}
+
+uint16_t hd108_simplex16_2d(uint32_t x, uint32_t y) {
+    // skew the input space to find the cell, only the offsets in the cell are needed
+    uint64_t skew = (((uint64_t)x + y) * HD108_COLOR_F2) >> 30;
+    uint64_t xs = x + skew;
+    uint64_t ys = y + skew;
+    uint32_t i = (uint32_t)(xs >> 16);
+    uint32_t j = (uint32_t)(ys >> 16);
+    int32_t fx = (int32_t)(xs & 0xffffU);
+    int32_t fy = (int32_t)(ys & 0xffffU);
+    int32_t unskew = (int32_t)(((uint32_t)(fx + fy) * HD108_COLOR_G2) >> 16);
+    int32_t x0 = fx - unskew;
+    int32_t y0 = fy - unskew;
+
+    // the middle corner depends on the triangle of the cell
+    uint32_t i1 = (x0 > y0) ? 1 : 0;
+    uint32_t j1 = 1 - i1;
+
+    int32_t n = hd108_color_corner2(hd108_color_hash16(i ^ (j * 0x9e3779b1UL)), x0, y0);
+    n += hd108_color_corner2(hd108_color_hash16((i + i1) ^ ((j + j1) * 0x9e3779b1UL)),
+                             x0 - (int32_t)(i1 << 16) + HD108_COLOR_G2, y0 - (int32_t)(j1 << 16) + HD108_COLOR_G2);
+    n += hd108_color_corner2(hd108_color_hash16((i + 1) ^ ((j + 1) * 0x9e3779b1UL)),
+                             x0 - 65536L + 2 * HD108_COLOR_G2, y0 - 65536L + 2 * HD108_COLOR_G2);
+
+    int64_t value = ((int64_t)n * HD108_COLOR_SCALE2 * 32767) >> 31;
+    value = (value > 32767) ? 32767 : ((value < -32768) ? -32768 : value);
+    return (uint16_t)(value + 32768);
+}
+
+uint16_t hd108_simplex16_3d(uint32_t x, uint32_t y, uint32_t z) {
+    // skew the input space to find the cell, only the offsets in the cell are needed
+    uint64_t skew = (((uint64_t)x + y + z) * HD108_COLOR_F3) >> 30;
+    uint64_t xs = x + skew;
+    uint64_t ys = y + skew;
+    uint64_t zs = z + skew;
+    uint32_t i = (uint32_t)(xs >> 16);
+    uint32_t j = (uint32_t)(ys >> 16);
+    uint32_t k = (uint32_t)(zs >> 16);
+    int32_t fx = (int32_t)(xs & 0xffffU);
+    int32_t fy = (int32_t)(ys & 0xffffU);
+    int32_t fz = (int32_t)(zs & 0xffffU);
+    int32_t unskew = (int32_t)(((uint32_t)(fx + fy + fz) * HD108_COLOR_G3) >> 16);
+    int32_t x0 = fx - unskew;
+    int32_t y0 = fy - unskew;
+    int32_t z0 = fz - unskew;
+
+    // the middle corners depend on the order of the offsets
+    uint32_t i1, j1, k1, i2, j2, k2;
+    if (x0 >= y0) {
+        if (y0 >= z0) {
+            i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+        } else if (x0 >= z0) {
+            i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1;
+        } else {
+            i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1;
+        }
+    } else {
+        if (y0 < z0) {
+            i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1;
+        } else if (x0 < z0) {
+            i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1;
+        } else {
+            i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0;
+        }
+    }
+
+    int32_t n = hd108_color_corner3(hd108_color_hash16(i ^ (j * 0x9e3779b1UL) ^ (k * 0x85ebca77UL)), x0, y0, z0);
+    n += hd108_color_corner3(hd108_color_hash16((i + i1) ^ ((j + j1) * 0x9e3779b1UL) ^ ((k + k1) * 0x85ebca77UL)),
+                             x0 - (int32_t)(i1 << 16) + HD108_COLOR_G3,
+                             y0 - (int32_t)(j1 << 16) + HD108_COLOR_G3,
+                             z0 - (int32_t)(k1 << 16) + HD108_COLOR_G3);
+    n += hd108_color_corner3(hd108_color_hash16((i + i2) ^ ((j + j2) * 0x9e3779b1UL) ^ ((k + k2) * 0x85ebca77UL)),
+                             x0 - (int32_t)(i2 << 16) + 2 * HD108_COLOR_G3,
+                             y0 - (int32_t)(j2 << 16) + 2 * HD108_COLOR_G3,
+                             z0 - (int32_t)(k2 << 16) + 2 * HD108_COLOR_G3);
+    n += hd108_color_corner3(hd108_color_hash16((i + 1) ^ ((j + 1) * 0x9e3779b1UL) ^ ((k + 1) * 0x85ebca77UL)),
+                             x0 - 65536L + 3 * HD108_COLOR_G3,
+                             y0 - 65536L + 3 * HD108_COLOR_G3,
+                             z0 - 65536L + 3 * HD108_COLOR_G3);
+
+    int64_t value = ((int64_t)n * HD108_COLOR_SCALE3 * 32767) >> 30;
+    value = (value > 32767) ? 32767 : ((value < -32768) ? -32768 : value);
+    return (uint16_t)(value + 32768);
+}
@@ -0,0 +1,191 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "HD108_copy.h"
+
+#if defined(__has_include)
+#if __has_include("soc/soc_caps.h")
+#include "soc/soc_caps.h"
+#endif
+#endif
+
+#if defined(SOC_ASYNC_MEMCPY_SUPPORTED) && SOC_ASYNC_MEMCPY_SUPPORTED
+#include "esp_attr.h"
+#include "esp_async_memcpy.h"
+#define HD108_COPY_DMA              (1)
+#endif
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_COPY_BACKLOG          (       4UL)    ///< number of copies the DMA can queue
+#define HD108_COPY_PSRAM_ALIGN      (      64UL)    ///< alignment of blocks in PSRAM, the largest cache line
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Copy engine variable.
+ */
+typedef struct {
+    hd108_copy_backend_t    backend;    ///< Backend of the engine
+#ifdef HD108_COPY_DMA
+    async_memcpy_handle_t   driver;     ///< Async memcpy driver
+#endif
+    SemaphoreHandle_t       done;       ///< Given when the last copy in progress is done
+    uint32_t                pending;    ///< Number of copies in progress (atomic)
+} hd108_copy_t;
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+#ifdef HD108_COPY_DMA
+/**
+ * @brief Async memcpy done callback, called from ISR.
+ *
+ * @param driver Async memcpy driver.
+ * @param event Event data.
+ * @param copy_in The address of the engine.
+ *
+ * @return
+ *         - true if a higher priority task has been woken.
+ */
+static bool IRAM_ATTR hd108_copy_done(async_memcpy_handle_t driver, async_memcpy_event_t *event, void *copy_in) {
+    hd108_copy_t *copy = copy_in;
+    BaseType_t woken = pdFALSE;
+
+    if (0 == __atomic_sub_fetch(&copy->pending, 1, __ATOMIC_ACQ_REL)) {
+        (void)xSemaphoreGiveFromISR(copy->done, &woken);
+    }
+
+    return (pdTRUE == woken);
+}
+#endif
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_copy_init(hd108_copy_backend_t backend, void **copy_out) {
+    // check backend
+    if ((HD108_COPY_AUTO != backend) && (HD108_COPY_CPU != backend)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for engine
+    hd108_copy_t *copy = (hd108_copy_t *)calloc(1, sizeof(hd108_copy_t));
+    if (!copy) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    copy->backend = HD108_COPY_CPU;
+
+#ifdef HD108_COPY_DMA
+    if (HD108_COPY_AUTO == backend) {
+        async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+        config.backlog = HD108_COPY_BACKLOG;
+        config.psram_trans_align = HD108_COPY_PSRAM_ALIGN;
+
+        copy->done = xSemaphoreCreateBinary();
+        if (!copy->done) {
+            free(copy);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        }
+        esp_err_t err = esp_async_memcpy_install(&config, &copy->driver);
+        if (ESP_OK != err) {
+            vSemaphoreDelete(copy->done);
+            free(copy);
+            return (ESP_ERR_NO_MEM == err) ? HD108_LLD_ERROR_NO_MEMORY : HD108_LLD_ERROR_NO_DMA;
+        }
+        copy->backend = HD108_COPY_AUTO;
+    }
+#endif
+
+    // set out parameter
+    *copy_out = copy;
+
+    return HD108_LLD_OK;
+}
+
+bool hd108_copy_start(void *copy_in, void *dst, const void *src, size_t len) {
+#ifdef HD108_COPY_DMA
+    // cast engine
+    hd108_copy_t *copy = copy_in;
+
+    if (HD108_COPY_AUTO == copy->backend) {
+        __atomic_add_fetch(&copy->pending, 1, __ATOMIC_ACQ_REL);
+        if (ESP_OK == esp_async_memcpy(copy->driver, dst, (void *)src, len, hd108_copy_done, copy)) {
+            return true;
+        }
+        // not started, so the callback will not come for it
+        __atomic_sub_fetch(&copy->pending, 1, __ATOMIC_ACQ_REL);
+    }
+#else
+    (void)copy_in;
+#endif
+
+    memcpy(dst, src, len);
+    return false;
+}
+
+void hd108_copy_wait(void *copy_in) {
+    // cast engine
+    hd108_copy_t *copy = copy_in;
+
+    // a give of an earlier wait may be left over, so check the counter again
+    while (0 != __atomic_load_n(&copy->pending, __ATOMIC_ACQUIRE)) {
+        (void)xSemaphoreTake(copy->done, portMAX_DELAY);
+    }
+}
+
+void hd108_copy_deinit(void *copy_in) {
+    // cast engine
+    hd108_copy_t *copy = copy_in;
+
+    hd108_copy_wait(copy);
+
+#ifdef HD108_COPY_DMA
+    if (HD108_COPY_AUTO == copy->backend) {
+        (void)esp_async_memcpy_uninstall(copy->driver);
+        vSemaphoreDelete(copy->done);
+    }
+#endif
+
+    free(copy);
+}
@@ -0,0 +1,302 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_dedic.h"
+
+#if defined(__has_include)
+#if __has_include("soc/soc_caps.h")
+#include "soc/soc_caps.h"
+#endif
+#endif
+
+#if defined(SOC_DEDICATED_GPIO_SUPPORTED) && SOC_DEDICATED_GPIO_SUPPORTED
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "driver/dedic_gpio.h"
+#include "hal/dedic_gpio_cpu_ll.h"
+#define HD108_DEDIC_SUPPORTED       (1)
+#endif
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_DEDIC_NUM_OF_0S       (      16UL)    ///< number of 0 bytes at the begining of the transfer
+
+#if defined(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#define HD108_DEDIC_CPU_MHZ         (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)   ///< CPU clock of the transfers
+#else
+#define HD108_DEDIC_CPU_MHZ         (     240UL)    ///< CPU clock of the transfers, the fastest one if it is not configured
+#endif
+
+/**
+ * @brief CPU cycles of each clock phase.
+ *
+ * @note Half of a bit time at HD108_LLD_MAX_SPI_SPEED rounded up, e.g. 3 at
+ *       240 MHz, 2 at 160 MHz and 1 at 80 MHz. The write of the channels is
+ *       one cycle, the rest of the phase is padded with nops.
+ */
+#define HD108_DEDIC_PHASE_CYCLES    ((HD108_DEDIC_CPU_MHZ * 1000000UL + 2 * HD108_LLD_MAX_SPI_SPEED - 1) / (2 * HD108_LLD_MAX_SPI_SPEED))
+
+/**
+ * @brief Pad a clock phase after the write of the channels.
+ */
+#define HD108_DEDIC_PAD()           __asm__ __volatile__(".rept %c0\n\tnop\n\t.endr" :: "i" (HD108_DEDIC_PHASE_CYCLES - 1))
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Transport variable.
+ */
+typedef struct {
+#ifdef HD108_DEDIC_SUPPORTED
+    dedic_gpio_bundle_handle_t  bundle;     ///< Bundle of the data and clock pins
+#endif
+    uint8_t                     lanes;      ///< Number of lanes
+    uint32_t                    lane_len;   ///< Number of bytes on each lane
+    uint8_t                     offset;     ///< First channel of the bundle
+    uint8_t                     clk;        ///< Channel mask of the clock, relative to the offset
+    uint8_t                    *slices;     ///< Transposed buffer, one byte per bit time
+} hd108_dedic_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static inline uint64_t  hd108_dedic_transpose8  (uint64_t x);
+static void             hd108_dedic_transpose   (hd108_dedic_t *dedic, const uint8_t *data, uint32_t data_len);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Transpose an 8 x 8 bit matrix.
+ *
+ * @note Byte k of the input is row k, bit j is column j. After the transpose
+ *       byte j holds column j: its bit k is bit j of input byte k.
+ *
+ * @param x The matrix.
+ *
+ * @return
+ *         - The transposed matrix.
+ */
+static inline uint64_t hd108_dedic_transpose8(uint64_t x) {
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+
+    return x;
+}
+
+
+/**
+ * @brief Transpose the lanes into the slices.
+ *
+ * @note For every byte position the bytes of the lanes form an 8 x 8 bit
+ *       matrix, its transpose gives the 8 bit times MSB first, bit k of a
+ *       slice is the bit of lane k. The slices are shifted to the channels
+ *       of the bundle already, so the transfer only has to add the clock.
+ *
+ * @param dedic The address of the transport.
+ * @param data Data of the lanes back to back.
+ * @param data_len Number of bytes of data.
+ */
+static void hd108_dedic_transpose(hd108_dedic_t *dedic, const uint8_t *data, uint32_t data_len) {
+    uint8_t *slice = dedic->slices + 8 * HD108_DEDIC_NUM_OF_0S;
+
+    for (uint32_t pos = 0; pos < dedic->lane_len; pos++, slice += 8) {
+        uint64_t x = 0;
+        for (uint8_t lane = 0; lane < dedic->lanes; lane++) {
+            uint32_t i = lane * dedic->lane_len + pos;
+            if (i < data_len) {
+                x |= (uint64_t)data[i] << (8 * lane);
+            }
+        }
+        x = hd108_dedic_transpose8(x);
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            slice[bit] = (uint8_t)(x >> (8 * (7 - bit))) << dedic->offset;
+        }
+    }
+}
+
+
+#ifdef HD108_DEDIC_SUPPORTED
+/**
+ * @brief Clock out the slices.
+ *
+ * @note Mode 3 like the SPI transport: the clock idles high, data changes
+ *       with the falling edge and is sampled with the rising edge. Every
+ *       bit is two single-cycle writes of the dedicated GPIO channels, the
+ *       loop is unrolled by four and reads the slices as words, so there is
+ *       one load per four bits. Each write is followed by the padding of
+ *       its phase, so neither the low nor the high phase of the clock is
+ *       shorter than at HD108_LLD_MAX_SPI_SPEED. The bit rate is at most
+ *       HD108_DEDIC_CPU_MHZ / (2 * HD108_DEDIC_PHASE_CYCLES), i.e. 40 MHz at
+ *       80, 160 and 240 MHz; the extraction of the slices and the loop only
+ *       lengthen the low phases.
+ *
+ * @param slices Transposed buffer, 4 byte aligned.
+ * @param len Number of slices, multiple of 4.
+ * @param mask Channel mask of the data and clock lines.
+ * @param clk Channel mask of the clock.
+ */
+static void IRAM_ATTR hd108_dedic_shift(const uint8_t *slices, uint32_t len, uint32_t mask, uint32_t clk) {
+    const uint32_t *word = (const uint32_t *)slices;
+
+    for (uint32_t i = 0; i < len / 4; i++) {
+        uint32_t w = word[i];
+        dedic_gpio_cpu_ll_write_mask(mask, w & 0xffU);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, (w & 0xffU) | clk);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, (w >> 8) & 0xffU);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, ((w >> 8) & 0xffU) | clk);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, (w >> 16) & 0xffU);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, ((w >> 16) & 0xffU) | clk);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, w >> 24);
+        HD108_DEDIC_PAD();
+        dedic_gpio_cpu_ll_write_mask(mask, (w >> 24) | clk);
+        HD108_DEDIC_PAD();
+    }
+}
+#endif
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_dedic_init(uint8_t pin_clk, const uint8_t *pin_data, uint8_t lane_count, uint32_t lane_len, void **dedic_out) {
+#ifdef HD108_DEDIC_SUPPORTED
+    int pins[HD108_LLD_MAX_LANES + 1];
+    uint32_t offset;
+
+    // check lanes
+    if ((NULL == pin_data) || (0 == lane_count) || (HD108_LLD_MAX_LANES < lane_count) || (0 == lane_len)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for transport
+    hd108_dedic_t *dedic = (hd108_dedic_t *)calloc(1, sizeof(hd108_dedic_t));
+    if (!dedic) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // the slices of the 0 bytes stay 0
+    dedic->slices = (uint8_t *)calloc(HD108_DEDIC_NUM_OF_0S + lane_len, 8);
+    if (!dedic->slices) {
+        free(dedic);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // data lines on the first channels, clock on the next one
+    for (uint8_t lane = 0; lane < lane_count; lane++) {
+        pins[lane] = pin_data[lane];
+    }
+    pins[lane_count] = pin_clk;
+
+    dedic_gpio_bundle_config_t bundle_config = {
+        .gpio_array = pins,
+        .array_size = lane_count + 1,
+        .flags = {
+            .out_en = 1
+        }
+    };
+    if ((ESP_OK != dedic_gpio_new_bundle(&bundle_config, &dedic->bundle)) ||
+        (ESP_OK != dedic_gpio_get_out_offset(dedic->bundle, &offset))) {
+        if (dedic->bundle) {
+            (void)dedic_gpio_del_bundle(dedic->bundle);
+        }
+        free(dedic->slices);
+        free(dedic);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    dedic->lanes = lane_count;
+    dedic->lane_len = lane_len;
+    dedic->offset = (uint8_t)offset;
+    dedic->clk = (uint8_t)(1U << lane_count);
+
+    // clock idles high
+    dedic_gpio_cpu_ll_write_mask((uint32_t)((dedic->clk << 1) - 1) << offset, (uint32_t)dedic->clk << offset);
+
+    // set out parameter
+    *dedic_out = dedic;
+
+    return HD108_LLD_OK;
+#else
+    (void)pin_clk;
+    (void)pin_data;
+    (void)lane_count;
+    (void)lane_len;
+    (void)dedic_out;
+    return HD108_LLD_ERROR_INVALID;
+#endif
+}
+
+void hd108_dedic_transmit(void *dedic_in, const uint8_t *data, uint32_t data_len) {
+    // cast transport
+    hd108_dedic_t *dedic = dedic_in;
+
+    hd108_dedic_transpose(dedic, data, data_len);
+
+#ifdef HD108_DEDIC_SUPPORTED
+    uint32_t mask = (uint32_t)((dedic->clk << 1) - 1) << dedic->offset;
+    hd108_dedic_shift(dedic->slices, 8 * (HD108_DEDIC_NUM_OF_0S + dedic->lane_len), mask, (uint32_t)dedic->clk << dedic->offset);
+#endif
+}
+
+void hd108_dedic_deinit(void *dedic_in) {
+    // cast transport
+    hd108_dedic_t *dedic = dedic_in;
+
+#ifdef HD108_DEDIC_SUPPORTED
+    (void)dedic_gpio_del_bundle(dedic->bundle);
+#endif
+    free(dedic->slices);
+    free(dedic);
+}
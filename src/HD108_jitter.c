@@ -0,0 +1,341 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "HD108_arena.h"
+#include "HD108_color.h"
+#include "HD108_jitter.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_JITTER_EWMA_SHIFT     (       4UL)    ///< smoothing of interval and jitter estimation (1/16)
+#define HD108_JITTER_DELAY_SHIFT    (       5UL)    ///< speed of playout delay adaptation (1/32)
+#define HD108_JITTER_DELAY_SIGMA    (       3L)     ///< playout delay covers this many times the jitter
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Jitter buffer variable to store frames and timing information.
+ */
+typedef struct {
+    SemaphoreHandle_t   lock;           ///< Protects every member below
+    hd108_pixel_t      *frames;         ///< Frame slots, depth x count pixels
+    void               *arena;          ///< Arena of the frame slots, NULL if they are allocated from the heap
+    int64_t            *pts;            ///< Presentation time of each slot in microseconds
+    uint16_t            count;          ///< Number of pixels in one frame
+    uint8_t             depth;          ///< Number of frame slots
+    uint8_t             head;           ///< Slot of the oldest frame
+    uint8_t             used;           ///< Number of slots in use
+    int64_t             last_arrival;   ///< Arrival time of the last frame
+    int64_t             last_pts;       ///< Presentation time of the last frame
+    int32_t             interval;       ///< Smoothed frame interval
+    int32_t             jitter;         ///< Smoothed arrival jitter
+    int32_t             delay;          ///< Current playout delay
+    int32_t             min_delay;      ///< Lower limit of the playout delay
+    int32_t             max_delay;      ///< Upper limit of the playout delay
+    uint32_t            frame_cnt;      ///< Number of frames pushed
+    uint32_t            underruns;      ///< Number of held output slots
+    uint32_t            overruns;       ///< Number of dropped frames
+} hd108_jitter_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static void         hd108_jitter_update_timing  (hd108_jitter_t *jb, int64_t arrival);
+static int32_t      hd108_jitter_clamp          (int32_t value, int32_t min, int32_t max);
+static void         hd108_jitter_free           (hd108_jitter_t *jb);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Helper function to limit a value.
+ *
+ * @param value Value to be limited.
+ * @param min Lower limit.
+ * @param max Upper limit.
+ *
+ * @return
+ *         - The limited value.
+ */
+static int32_t hd108_jitter_clamp(int32_t value, int32_t min, int32_t max) {
+    if (value < min) {
+        return min;
+    }
+    if (value > max) {
+        return max;
+    }
+    return value;
+}
+
+
+/**
+ * @brief Update timing estimation with a new arrival.
+ *
+ * @note The presentation time of a frame is predicted from the previous one
+ *       and the smoothed frame interval, then pulled slowly towards the
+ *       arrival time, so the presentation times stay evenly spaced while the
+ *       arrival times jitter. The deviation between the arrival and the
+ *       prediction drives the jitter estimation, the jitter drives the
+ *       target playout delay.
+ *
+ * @param jb The address of the jitter buffer.
+ * @param arrival Arrival time in microseconds.
+ */
+static void hd108_jitter_update_timing(hd108_jitter_t *jb, int64_t arrival) {
+    if (0 == jb->frame_cnt) {
+        jb->last_pts = arrival;
+        jb->last_arrival = arrival;
+        return;
+    }
+
+    int32_t inter_arrival = (int32_t)(arrival - jb->last_arrival);
+    if (0 == jb->interval) {
+        jb->interval = inter_arrival;
+    } else {
+        jb->interval += (inter_arrival - jb->interval) / (1L << HD108_JITTER_EWMA_SHIFT);
+    }
+
+    int64_t pts = jb->last_pts + jb->interval;
+    int32_t deviation = (int32_t)(arrival - pts);
+    if ((deviation > jb->max_delay) || (deviation < -jb->max_delay)) {
+        // stream has been paused or restarted, resync
+        pts = arrival;
+        deviation = 0;
+    } else {
+        pts += deviation / (1L << HD108_JITTER_EWMA_SHIFT);
+    }
+
+    int32_t abs_deviation = (deviation < 0) ? -deviation : deviation;
+    jb->jitter += (abs_deviation - jb->jitter) / (1L << HD108_JITTER_EWMA_SHIFT);
+
+    int32_t target = hd108_jitter_clamp(jb->interval + HD108_JITTER_DELAY_SIGMA * jb->jitter, jb->min_delay, jb->max_delay);
+    jb->delay += (target - jb->delay) / (1L << HD108_JITTER_DELAY_SHIFT);
+
+    jb->last_pts = pts;
+    jb->last_arrival = arrival;
+}
+
+
+/**
+ * @brief Release jitter buffer.
+ *
+ * @note It frees the jitter buffer and every buffer that is owned by it, the
+ *       frame slots go back to the arena or the heap they came from.
+ *
+ * @param jb The address of the jitter buffer.
+ */
+static void hd108_jitter_free(hd108_jitter_t *jb) {
+    if (jb->lock) {
+        vSemaphoreDelete(jb->lock);
+    }
+    free(jb->pts);
+    if (NULL != jb->arena) {
+        hd108_arena_free(jb->arena, jb->frames);
+    } else {
+        free(jb->frames);
+    }
+    free(jb);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_jitter_init(const hd108_jitter_configuration_t *jitter_configuration, void **jitter_out) {
+    // check frame length
+    if ((HD108_LLD_MIN_COUNT > jitter_configuration->count) || (HD108_LLD_MAX_COUNT < jitter_configuration->count)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // check depth and delay limits
+    if ((HD108_JITTER_MIN_DEPTH > jitter_configuration->depth) || (HD108_JITTER_MAX_DEPTH < jitter_configuration->depth)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((jitter_configuration->min_delay_us > jitter_configuration->max_delay_us) || (INT32_MAX < jitter_configuration->max_delay_us)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for the jitter buffer
+    hd108_jitter_t *jb = (hd108_jitter_t *)calloc(1, sizeof(hd108_jitter_t));
+    if (!jb) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // the frame slots come from the arena if there is one
+    jb->arena = jitter_configuration->arena;
+    size_t frames_len = (size_t)jitter_configuration->depth * jitter_configuration->count * sizeof(hd108_pixel_t);
+    if (NULL != jitter_configuration->arena) {
+        jb->frames = (hd108_pixel_t *)hd108_arena_alloc(jitter_configuration->arena, frames_len);
+        if (jb->frames) {
+            memset(jb->frames, 0, frames_len);
+        }
+    } else {
+        jb->frames = (hd108_pixel_t *)calloc(1, frames_len);
+    }
+    jb->pts = (int64_t *)calloc(jitter_configuration->depth, sizeof(int64_t));
+    jb->lock = xSemaphoreCreateMutex();
+    if (!jb->frames || !jb->pts || !jb->lock) {
+        hd108_jitter_free(jb);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    jb->count = jitter_configuration->count;
+    jb->depth = jitter_configuration->depth;
+    jb->min_delay = (int32_t)jitter_configuration->min_delay_us;
+    jb->max_delay = (int32_t)jitter_configuration->max_delay_us;
+    jb->delay = jb->min_delay;
+
+    // set out parameter
+    *jitter_out = jb;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_jitter_push(void *jitter_in, const hd108_pixel_t *frame) {
+    // cast jitter buffer
+    hd108_jitter_t *jb = jitter_in;
+
+    if (NULL == frame) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    int64_t arrival = esp_timer_get_time();
+
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+
+    hd108_jitter_update_timing(jb, arrival);
+
+    // drop the oldest frame if all slots are in use
+    if (jb->used == jb->depth) {
+        jb->head = (jb->head + 1) % jb->depth;
+        jb->used--;
+        jb->overruns++;
+    }
+
+    uint8_t slot = (jb->head + jb->used) % jb->depth;
+    memcpy(&jb->frames[(size_t)slot * jb->count], frame, jb->count * sizeof(hd108_pixel_t));
+    jb->pts[slot] = jb->last_pts;
+    jb->used++;
+    jb->frame_cnt++;
+
+    xSemaphoreGive(jb->lock);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_jitter_render(void *jitter_in, void *ctx_in) {
+    // cast jitter buffer
+    hd108_jitter_t *jb = jitter_in;
+    hd108_status_t status = HD108_LLD_OK;
+
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+
+    if (0 == jb->used) {
+        // nothing has been received yet
+        xSemaphoreGive(jb->lock);
+        return HD108_LLD_OK;
+    }
+
+    int64_t playout = esp_timer_get_time() - jb->delay;
+
+    // release frames that are entirely in the past
+    while ((jb->used >= 2) && (jb->pts[(jb->head + 1) % jb->depth] <= playout)) {
+        jb->head = (jb->head + 1) % jb->depth;
+        jb->used--;
+    }
+
+    uint8_t slot_a = jb->head;
+    uint8_t slot_b = (jb->head + 1) % jb->depth;
+    const hd108_pixel_t *frame_a = &jb->frames[(size_t)slot_a * jb->count];
+    const hd108_pixel_t *frame_b = &jb->frames[(size_t)slot_b * jb->count];
+
+    if ((1 == jb->used) || (playout <= jb->pts[slot_a])) {
+        // hold the oldest frame, it is an underrun if playout is already past it
+        if ((1 == jb->used) && (playout > jb->pts[slot_a])) {
+            jb->underruns++;
+        }
+        for (uint16_t i = 0; (i < jb->count) && (HD108_LLD_OK == status); i++) {
+            status = hd108_lld_set_pixel(ctx_in, i, &frame_a[i]);
+        }
+    } else {
+        // frame b is later than playout, so the fraction is always below 1
+        int64_t span = jb->pts[slot_b] - jb->pts[slot_a];
+        hd108_fract16_t frac = (span > 0) ? (hd108_fract16_t)(((playout - jb->pts[slot_a]) << 16) / span) : 0;
+        for (uint16_t i = 0; (i < jb->count) && (HD108_LLD_OK == status); i++) {
+            hd108_pixel_t pixel;
+            hd108_pixel_lerp16(&frame_a[i], &frame_b[i], frac, &pixel);
+            status = hd108_lld_set_pixel(ctx_in, i, &pixel);
+        }
+    }
+
+    xSemaphoreGive(jb->lock);
+
+    return status;
+}
+
+void hd108_jitter_get_stats(void *jitter_in, hd108_jitter_stats_t *stats_out) {
+    // cast jitter buffer
+    hd108_jitter_t *jb = jitter_in;
+
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+    stats_out->delay_us = (uint32_t)jb->delay;
+    stats_out->jitter_us = (uint32_t)jb->jitter;
+    stats_out->interval_us = (uint32_t)jb->interval;
+    stats_out->frames = jb->frame_cnt;
+    stats_out->underruns = jb->underruns;
+    stats_out->overruns = jb->overruns;
+    xSemaphoreGive(jb->lock);
+}
+
+void hd108_jitter_deinit(void *jitter_in) {
+    // cast jitter buffer
+    hd108_jitter_t *jb = jitter_in;
+
+    // wait for a push or render in progress
+    (void)xSemaphoreTake(jb->lock, portMAX_DELAY);
+    (void)xSemaphoreGive(jb->lock);
+
+    hd108_jitter_free(jb);
+}
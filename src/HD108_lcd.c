@@ -0,0 +1,379 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "esp_lcd_panel_interface.h"
+#include "HD108_lcd.h"
+#include "HD108_map2d.h"
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Panel variable, the esp_lcd base is the first member.
+ */
+typedef struct {
+    esp_lcd_panel_t     base;           ///< esp_lcd panel interface
+    void               *map;            ///< The address of the 2D mapping
+    uint16_t            width;          ///< Width of the matrix
+    uint16_t            height;         ///< Height of the matrix
+    uint8_t             bpp;            ///< Bytes per pixel of the bitmaps
+    bool                swap_bytes;     ///< RGB565 bitmaps are big endian
+    uint16_t            current;        ///< Current levels for every pixel
+    int                 x_gap;          ///< Offset of the matrix in x direction
+    int                 y_gap;          ///< Offset of the matrix in y direction
+    bool                mirror_x;       ///< Mirror along the x axis
+    bool                mirror_y;       ///< Mirror along the y axis
+    bool                swap_xy;        ///< Swap the axes
+    bool                invert;         ///< Invert the color values
+    bool                on;             ///< Display is on
+    uint8_t            *row;            ///< Row buffer, large enough for the longer side in RGB888
+} hd108_lcd_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static esp_err_t        hd108_lcd_reset         (esp_lcd_panel_t *panel);
+static esp_err_t        hd108_lcd_init_panel    (esp_lcd_panel_t *panel);
+static esp_err_t        hd108_lcd_draw_bitmap   (esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data);
+static esp_err_t        hd108_lcd_mirror        (esp_lcd_panel_t *panel, bool x_axis, bool y_axis);
+static esp_err_t        hd108_lcd_swap_xy       (esp_lcd_panel_t *panel, bool swap_axes);
+static esp_err_t        hd108_lcd_set_gap       (esp_lcd_panel_t *panel, int x_gap, int y_gap);
+static esp_err_t        hd108_lcd_invert_color  (esp_lcd_panel_t *panel, bool invert_color_data);
+static esp_err_t        hd108_lcd_disp_on_off   (esp_lcd_panel_t *panel, bool on_off);
+static esp_err_t        hd108_lcd_disp_sleep    (esp_lcd_panel_t *panel, bool sleep);
+static esp_err_t        hd108_lcd_del           (esp_lcd_panel_t *panel);
+static hd108_status_t   hd108_lcd_write_row     (hd108_lcd_t *lcd, uint16_t x, uint16_t y, uint16_t width, const uint8_t *src);
+static hd108_status_t   hd108_lcd_write_pixels  (hd108_lcd_t *lcd, uint16_t x, uint16_t y, uint16_t width, const uint8_t *src);
+static hd108_status_t   hd108_lcd_clear         (hd108_lcd_t *lcd);
+static esp_err_t        hd108_lcd_to_esp_err    (hd108_status_t status);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Helper function to convert driver status to esp_err_t.
+ *
+ * @param status Driver status.
+ *
+ * @return
+ *         - ESP_OK                  on HD108_LLD_OK
+ *         - ESP_ERR_INVALID_ARG     on HD108_LLD_ERROR_INDEX or HD108_LLD_ERROR_INVALID
+ *         - ESP_FAIL                otherwise
+ */
+static esp_err_t hd108_lcd_to_esp_err(hd108_status_t status) {
+    switch (status) {
+        case HD108_LLD_OK:
+            return ESP_OK;
+        case HD108_LLD_ERROR_INDEX:
+        case HD108_LLD_ERROR_INVALID:
+            return ESP_ERR_INVALID_ARG;
+        default:
+            return ESP_FAIL;
+    }
+}
+
+
+/**
+ * @brief Write one row of a bitmap without transformation.
+ *
+ * @note Big endian RGB565 rows are swapped in the row buffer first.
+ *
+ * @param lcd The address of the panel.
+ * @param x Left column in the matrix.
+ * @param y Row in the matrix.
+ * @param width Number of pixels.
+ * @param src Source pixels.
+ *
+ * @return
+ *         - Status of the 2D mapping write.
+ */
+static hd108_status_t hd108_lcd_write_row(hd108_lcd_t *lcd, uint16_t x, uint16_t y, uint16_t width, const uint8_t *src) {
+    if (3 == lcd->bpp) {
+        return hd108_map2d_write_rgb888(lcd->map, x, y, width, 1, src, lcd->current);
+    }
+
+    const uint16_t *pixels = (const uint16_t *)src;
+    if (lcd->swap_bytes) {
+        uint16_t *row = (uint16_t *)lcd->row;
+        for (uint16_t i = 0; i < width; i++) {
+            row[i] = __builtin_bswap16(pixels[i]);
+        }
+        pixels = row;
+    }
+    return hd108_map2d_write_rgb565(lcd->map, x, y, width, 1, pixels, lcd->current);
+}
+
+
+/**
+ * @brief Write one row of a bitmap pixel by pixel.
+ *
+ * @note It is used if the panel is mirrored, swapped or inverted. The panel
+ *       position is swapped first, then mirrored within the matrix.
+ *
+ * @param lcd The address of the panel.
+ * @param x Left column on the panel.
+ * @param y Row on the panel.
+ * @param width Number of pixels.
+ * @param src Source pixels.
+ *
+ * @return
+ *         - Status of the driver write.
+ */
+static hd108_status_t hd108_lcd_write_pixels(hd108_lcd_t *lcd, uint16_t x, uint16_t y, uint16_t width, const uint8_t *src) {
+    hd108_status_t status = HD108_LLD_OK;
+
+    for (uint16_t i = 0; (i < width) && (HD108_LLD_OK == status); i++, src += lcd->bpp) {
+        uint16_t mx = lcd->swap_xy ? y : x + i;
+        uint16_t my = lcd->swap_xy ? x + i : y;
+        if (lcd->mirror_x) {
+            mx = lcd->width - 1 - mx;
+        }
+        if (lcd->mirror_y) {
+            my = lcd->height - 1 - my;
+        }
+
+        if (3 == lcd->bpp) {
+            uint8_t pixel[3] = {src[0], src[1], src[2]};
+            if (lcd->invert) {
+                pixel[0] = ~pixel[0];
+                pixel[1] = ~pixel[1];
+                pixel[2] = ~pixel[2];
+            }
+            status = hd108_map2d_write_rgb888(lcd->map, mx, my, 1, 1, pixel, lcd->current);
+        } else {
+            uint16_t pixel;
+            memcpy(&pixel, src, sizeof(pixel));
+            if (lcd->swap_bytes) {
+                pixel = __builtin_bswap16(pixel);
+            }
+            if (lcd->invert) {
+                pixel = ~pixel;
+            }
+            status = hd108_map2d_write_rgb565(lcd->map, mx, my, 1, 1, &pixel, lcd->current);
+        }
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Clear every LED of the matrix.
+ *
+ * @param lcd The address of the panel.
+ *
+ * @return
+ *         - Status of the 2D mapping write.
+ */
+static hd108_status_t hd108_lcd_clear(hd108_lcd_t *lcd) {
+    hd108_status_t status = HD108_LLD_OK;
+
+    memset(lcd->row, 0, 3 * lcd->width);
+    for (uint16_t y = 0; (y < lcd->height) && (HD108_LLD_OK == status); y++) {
+        status = hd108_map2d_write_rgb888(lcd->map, 0, y, lcd->width, 1, lcd->row, lcd->current);
+    }
+
+    return status;
+}
+
+
+/*
+ * esp_lcd panel operations.
+ *
+ * Operation documentation can be found in esp_lcd_panel_ops.h!
+ */
+static esp_err_t hd108_lcd_reset(esp_lcd_panel_t *panel) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    return hd108_lcd_to_esp_err(hd108_lcd_clear(lcd));
+}
+
+
+static esp_err_t hd108_lcd_init_panel(esp_lcd_panel_t *panel) {
+    (void)panel;
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    const uint8_t *src = (const uint8_t *)color_data;
+    bool transformed = lcd->mirror_x || lcd->mirror_y || lcd->swap_xy || lcd->invert;
+    uint16_t panel_width = lcd->swap_xy ? lcd->height : lcd->width;
+    uint16_t panel_height = lcd->swap_xy ? lcd->width : lcd->height;
+    hd108_status_t status = HD108_LLD_OK;
+
+    if ((x_start >= x_end) || (y_start >= y_end) || (NULL == color_data)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!lcd->on) {
+        return ESP_OK;
+    }
+
+    // clip the rectangle to the matrix, the source keeps its stride
+    size_t stride = (size_t)(x_end - x_start) * lcd->bpp;
+    int x0 = x_start + lcd->x_gap;
+    int y0 = y_start + lcd->y_gap;
+    int x1 = x_end + lcd->x_gap;
+    int y1 = y_end + lcd->y_gap;
+    int skip_x = (x0 < 0) ? -x0 : 0;
+    int skip_y = (y0 < 0) ? -y0 : 0;
+    x0 += skip_x;
+    y0 += skip_y;
+    x1 = (x1 > panel_width) ? panel_width : x1;
+    y1 = (y1 > panel_height) ? panel_height : y1;
+    if ((x0 >= x1) || (y0 >= y1)) {
+        return ESP_OK;
+    }
+    src += skip_y * stride + (size_t)skip_x * lcd->bpp;
+
+    for (int y = y0; (y < y1) && (HD108_LLD_OK == status); y++, src += stride) {
+        if (transformed) {
+            status = hd108_lcd_write_pixels(lcd, x0, y, x1 - x0, src);
+        } else {
+            status = hd108_lcd_write_row(lcd, x0, y, x1 - x0, src);
+        }
+    }
+
+    return hd108_lcd_to_esp_err(status);
+}
+
+
+static esp_err_t hd108_lcd_mirror(esp_lcd_panel_t *panel, bool x_axis, bool y_axis) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    lcd->mirror_x = x_axis;
+    lcd->mirror_y = y_axis;
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_swap_xy(esp_lcd_panel_t *panel, bool swap_axes) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    lcd->swap_xy = swap_axes;
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_set_gap(esp_lcd_panel_t *panel, int x_gap, int y_gap) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    lcd->x_gap = x_gap;
+    lcd->y_gap = y_gap;
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_invert_color(esp_lcd_panel_t *panel, bool invert_color_data) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    lcd->invert = invert_color_data;
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_disp_on_off(esp_lcd_panel_t *panel, bool on_off) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    lcd->on = on_off;
+    if (!on_off) {
+        return hd108_lcd_to_esp_err(hd108_lcd_clear(lcd));
+    }
+    return ESP_OK;
+}
+
+
+static esp_err_t hd108_lcd_disp_sleep(esp_lcd_panel_t *panel, bool sleep) {
+    return hd108_lcd_disp_on_off(panel, !sleep);
+}
+
+
+static esp_err_t hd108_lcd_del(esp_lcd_panel_t *panel) {
+    hd108_lcd_t *lcd = (hd108_lcd_t *)panel;
+    free(lcd->row);
+    free(lcd);
+    return ESP_OK;
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_lcd_init(const hd108_lcd_configuration_t *lcd_configuration, esp_lcd_panel_handle_t *panel_out) {
+    // check mapping and color depth
+    if (NULL == lcd_configuration->map) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((16 != lcd_configuration->bits_per_pixel) && (24 != lcd_configuration->bits_per_pixel)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for panel
+    hd108_lcd_t *lcd = (hd108_lcd_t *)calloc(1, sizeof(hd108_lcd_t));
+    if (!lcd) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    hd108_map2d_get_size(lcd_configuration->map, &lcd->width, &lcd->height);
+
+    // allocate memory for row buffer
+    uint16_t longer = (lcd->width > lcd->height) ? lcd->width : lcd->height;
+    lcd->row = (uint8_t *)malloc(3 * longer);
+    if (!lcd->row) {
+        free(lcd);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    lcd->map = lcd_configuration->map;
+    lcd->bpp = lcd_configuration->bits_per_pixel / 8;
+    lcd->swap_bytes = lcd_configuration->swap_bytes;
+    lcd->current = lcd_configuration->current;
+    lcd->on = true;
+
+    lcd->base.reset = hd108_lcd_reset;
+    lcd->base.init = hd108_lcd_init_panel;
+    lcd->base.draw_bitmap = hd108_lcd_draw_bitmap;
+    lcd->base.mirror = hd108_lcd_mirror;
+    lcd->base.swap_xy = hd108_lcd_swap_xy;
+    lcd->base.set_gap = hd108_lcd_set_gap;
+    lcd->base.invert_color = hd108_lcd_invert_color;
+    lcd->base.disp_on_off = hd108_lcd_disp_on_off;
+    lcd->base.disp_sleep = hd108_lcd_disp_sleep;
+    lcd->base.del = hd108_lcd_del;
+
+    // set out parameter
+    *panel_out = &lcd->base;
+
+    return HD108_LLD_OK;
+}
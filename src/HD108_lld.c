@@ -26,29 +26,47 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_idf_version.h"
 #include "esp_timer.h"
 #include "HD108_lld.h"
+#include "HD108_arena.h"
+#include "HD108_color.h"
+#include "HD108_copy.h"
+#include "HD108_dedic.h"
+#include "HD108_prof.h"
+#include "HD108_trace.h"
 
 
 /******************************************************************************
  * Configuration
  *****************************************************************************/
 #define HD108_LLD_NUM_OF_0S         (      16UL)    ///< number of 0 bytes at the begining of transaction
+#define HD108_LLD_START_BIT         (  0x8000UL)    ///< start bit in the first half-word of the pixel
+#define HD108_LLD_PLANE_ALIGN       (      16UL)    ///< alignment of the planes in bytes
+#define HD108_LLD_BOUNCE_COUNT      (      64UL)    ///< number of LEDs in one bounce buffer of the compact layout
 
 
 /******************************************************************************
  * Typedefs
  *****************************************************************************/
 /**
- * @brief Helpre struct to easily set start bit.
+ * @brief Input pixel formats of the bulk write functions.
  */
-typedef struct {
-    hd108_current_t          :15;   ///< reserved
-    hd108_current_t bit_start:1;    ///< Start bit in pixel data
-} hd108_pixel_data_t;
+typedef enum {
+    HD108_LLD_FORMAT_RGB565     = 0,    ///< 16-bit RGB565
+    HD108_LLD_FORMAT_RGB888     = 1,    ///< 3 x 8-bit
+    HD108_LLD_FORMAT_RGBA8888   = 2,    ///< 4 x 8-bit, alpha is premultiplied
+    HD108_LLD_FORMAT_RGB48      = 3,    ///< 3 x 16-bit
+    HD108_LLD_FORMAT_FLOAT      = 4     ///< 3 x float [0.0 .. 1.0]
+} hd108_format_t;
 
 
 /**
@@ -59,16 +77,109 @@ typedef struct {
     spi_transaction_t   transaction;    ///< SPI transaction data
     callback_update     callback;       ///< Address of the callback function
     uint16_t            strip_length;   ///< Number of LEDs in the strip [1 .. HD108_LLD_MAX_COUNT]
+    uint8_t             key_divider;    ///< Number of output frames per keyframe, 0 if upconversion is disabled
+    uint8_t             key_phase;      ///< Output frames since the last keyframe [1 .. key_divider]
+    hd108_pixel_t      *key_prev;       ///< Previous keyframe, blending starts from here
+    hd108_pixel_t      *key_next;       ///< Next keyframe, written by hd108_lld_set_pixel
+    uint16_t            render_count;   ///< Number of pixels rendered by the update function [1 .. strip_length]
+    hd108_upsample_t    upsample;       ///< Interpolation used to upsample the rendered pixels to the strip
+    uint16_t            render_next;    ///< Render count set by hd108_lld_set_resolution, applied by the next frame
+    hd108_upsample_t    upsample_next;  ///< Interpolation set by hd108_lld_set_resolution, applied by the next frame
+    hd108_pixel_t      *samples;        ///< Rendered pixels, NULL if spatial upsampling is disabled
+    hd108_planes_t      planes;         ///< Planar frame, the planes are NULL if the layout is not planar
+    void               *planes_mem;     ///< Memory block of the planes
+    void               *copy;           ///< Copy engine of hd108_lld_load_frame, NULL if async copy is disabled
+    uint8_t            *compact;        ///< Compact frame, 3 bytes per LED, NULL if the layout is not compact
+    uint32_t            compact_current;    ///< Current levels with start bit of the compact layout, big endian
+    uint16_t           *compact_lut;    ///< Expansion of 8-bit values of the compact layout, big endian
+    uint8_t            *bounce[2];      ///< Bounce buffers of the compact layout, the first one starts with the 0 bytes
+    spi_transaction_t   bounce_transaction[2];  ///< Transactions of the bounce buffers
+    bool                external_update;    ///< Updates are triggered by hd108_lld_update instead of the timer
+    void               *dedic;          ///< Dedicated GPIO transport, NULL if the transport is SPI
+    bool                bus_shared;     ///< The SPI bus is shared, it is acquired for every frame
+    portMUX_TYPE        bus_lock;       ///< Protects the bus statistics
+    hd108_bus_stats_t   bus_stats;      ///< Statistics of the shared bus
+    bool                dirty_tracking; ///< Transfers end at the last LED written since the previous transfer
+    uint16_t            dirty_end;      ///< Number of LEDs to be sent by the next transfer, 0 if nothing was written
+    hd108_prof_t       *prof;           ///< Profiler of the stages, NULL if profiling is disabled
+    void               *arena;          ///< Arena of the buffers, NULL if they are allocated from the heap
+    esp_timer_handle_t  timer;          ///< Periodic timer, NULL if updates are external
+    esp_timer_handle_t  fence;          ///< One-shot timer that runs after a callback of the timer in flight, NULL if updates are external
+    SemaphoreHandle_t   fenced;         ///< Given by the fence timer
+    bool                stopping;       ///< Set by the deinit under the update lock, updates and refreshes are not started any more
+    SemaphoreHandle_t   update_lock;    ///< Held while an update runs, the deinit waits for it
+    spi_host_device_t   spi_host;       ///< SPI host of the device
+    bool                bus_owned;      ///< The SPI bus was initialized by the driver, it is freed with the device
+    bool                refresh_on_change;  ///< The timer is one-shot, it is armed by the writes
+    bool                refresh_armed;  ///< A refresh is pending, the writes do not arm the timer again
+    uint32_t            period_us;      ///< Update period in microseconds
+    int64_t             transfer_start; ///< Start of the transfer of the last update, 0 if nothing was sent
 } hd108_ctx_t;
 
 
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/**
+ * @brief 5-bit to 16-bit expansion by bit replication.
+ */
+static const uint16_t hd108_lld_expand5[32] = {
+    0x0000, 0x0842, 0x1084, 0x18c6, 0x2108, 0x294a, 0x318c, 0x39ce,
+    0x4210, 0x4a52, 0x5294, 0x5ad6, 0x6318, 0x6b5a, 0x739c, 0x7bde,
+    0x8421, 0x8c63, 0x94a5, 0x9ce7, 0xa529, 0xad6b, 0xb5ad, 0xbdef,
+    0xc631, 0xce73, 0xd6b5, 0xdef7, 0xe739, 0xef7b, 0xf7bd, 0xffff
+};
+
+
+/**
+ * @brief 6-bit to 16-bit expansion by bit replication.
+ */
+static const uint16_t hd108_lld_expand6[64] = {
+    0x0000, 0x0410, 0x0820, 0x0c30, 0x1041, 0x1451, 0x1861, 0x1c71,
+    0x2082, 0x2492, 0x28a2, 0x2cb2, 0x30c3, 0x34d3, 0x38e3, 0x3cf3,
+    0x4104, 0x4514, 0x4924, 0x4d34, 0x5145, 0x5555, 0x5965, 0x5d75,
+    0x6186, 0x6596, 0x69a6, 0x6db6, 0x71c7, 0x75d7, 0x79e7, 0x7df7,
+    0x8208, 0x8618, 0x8a28, 0x8e38, 0x9249, 0x9659, 0x9a69, 0x9e79,
+    0xa28a, 0xa69a, 0xaaaa, 0xaeba, 0xb2cb, 0xb6db, 0xbaeb, 0xbefb,
+    0xc30c, 0xc71c, 0xcb2c, 0xcf3c, 0xd34d, 0xd75d, 0xdb6d, 0xdf7d,
+    0xe38e, 0xe79e, 0xebae, 0xefbe, 0xf3cf, 0xf7df, 0xfbef, 0xffff
+};
+
+
 /******************************************************************************
  * Prototypes
  *****************************************************************************/
+static inline void  hd108_lld_swap_pixel                (const hd108_pixel_t *src, volatile uint32_t *dst);
 static void         hd108_lld_copy_pixel                (const hd108_pixel_t *src, hd108_pixel_t *dst);
+static inline void  hd108_lld_mark_dirty                (hd108_ctx_t *ctx, uint16_t end);
+static void         hd108_lld_encode_lerp               (const hd108_pixel_t *a, const hd108_pixel_t *b, hd108_fract16_t frac, hd108_pixel_t *dst, uint16_t count);
+static hd108_color_t hd108_lld_cubic16                   (int32_t p0, int32_t p1, int32_t p2, int32_t p3, hd108_fract16_t frac);
+static void         hd108_lld_upsample                  (const hd108_ctx_t *ctx, const hd108_pixel_t *src, hd108_pixel_t *dst);
+static bool         hd108_lld_apply_resolution          (hd108_ctx_t *ctx);
+static void         hd108_lld_upconvert                 (hd108_ctx_t *ctx, uint32_t *stamp);
+static void         hd108_lld_interleave                (const hd108_planes_t *planes, hd108_pixel_t *dst, uint16_t count);
+static void         hd108_lld_commit                    (hd108_ctx_t *ctx);
+static void         hd108_lld_expand_compact            (const hd108_ctx_t *ctx, uint16_t first, uint16_t count, uint32_t *dst);
+static void         hd108_lld_transfer_compact          (hd108_ctx_t *ctx);
+static void         hd108_lld_acquire_bus               (hd108_ctx_t *ctx);
+static bool         hd108_lld_queue                     (hd108_ctx_t *ctx, spi_transaction_t *transaction);
+static void        *hd108_lld_alloc                     (hd108_ctx_t *ctx, size_t size, uint32_t caps);
+static void         hd108_lld_release                   (hd108_ctx_t *ctx, void *mem);
+static void         hd108_lld_free_ctx                  (hd108_ctx_t *ctx);
+static void         hd108_lld_store_pixel               (hd108_ctx_t *ctx, uint16_t index, const hd108_pixel_t *pixel);
+static inline void  hd108_lld_load                      (hd108_format_t format, const void *src, uint16_t i, uint16_t *red, uint16_t *green, uint16_t *blue);
+static inline hd108_status_t hd108_lld_write_format     (void *ctx_in, uint16_t first, uint16_t count, uint16_t current, hd108_format_t format, const void *src);
+static inline void  hd108_lld_prof_stage                (hd108_ctx_t *ctx, hd108_prof_stage_t stage, uint32_t *stamp);
 static void         hd108_lld_periodic_timer_callback   (void* arg);
+static void         hd108_lld_fence_callback            (void *arg);
 static uint32_t     hd108_get_update_period_time        (hd108_update_frequency_hz_t freq_hz);
-static esp_err_t    hd108_lld_start_timer_for_ctx       (void *ctx, hd108_update_frequency_hz_t freq);
+static esp_err_t    hd108_lld_start_timer_for_ctx       (hd108_ctx_t *ctx, hd108_update_frequency_hz_t freq);
+static hd108_status_t hd108_lld_init_spi                (const hd108_configuration_t *hd108_configuration, hd108_ctx_t *ctx, uint16_t buffer_len);
+static void         hd108_lld_deinit_transport          (hd108_ctx_t *ctx);
+static void         hd108_lld_pre_transfer              (spi_transaction_t *transaction);
+#if CONFIG_HD108_TRACE
+static void         hd108_lld_trace_post                (spi_transaction_t *transaction);
+#endif
 
 
 /******************************************************************************
@@ -76,6 +187,31 @@ static esp_err_t    hd108_lld_start_timer_for_ctx       (void *ctx, hd108_update
  *****************************************************************************/
 
 
+/**
+ * @brief Swap one pixel into the TX buffer.
+ *
+ * @note The start bit is set and every half-word is swapped to big endian,
+ *       the pixel is written with two aligned 32-bit stores without a fence,
+ *       see hd108_lld_copy_pixel.
+ *
+ * @param src Source of data.
+ * @param dst Destination in the TX buffer, shall be 4 byte aligned.
+ */
+static inline void hd108_lld_swap_pixel(const hd108_pixel_t *src, volatile uint32_t *dst) {
+    uint32_t word[2];
+
+    memcpy(word, src, sizeof(word));
+    word[0] |= HD108_LLD_START_BIT;
+
+    // change endianness of each uint16_t from little to big
+    word[0] = ((word[0] & 0x00ff00ffUL) << 8) | ((word[0] >> 8) & 0x00ff00ffUL);
+    word[1] = ((word[1] & 0x00ff00ffUL) << 8) | ((word[1] >> 8) & 0x00ff00ffUL);
+
+    dst[0] = word[0];
+    dst[1] = word[1];
+}
+
+
 /**
  * @brief Copy pixel data to TX buffer.
  *
@@ -86,288 +222,1584 @@ static esp_err_t    hd108_lld_start_timer_for_ctx       (void *ctx, hd108_update
  *       Then 3 x  5 bit for driving current (RGB).
  *       Then 3 x 16 bit for color intensity (RGB).
  *
+ *       The pixel is written with two aligned 32-bit stores, the first one
+ *       carries the start bit, the current levels and red, the second one
+ *       green and blue. A concurrent DMA read can never see a half-updated
+ *       color channel or a cleared start bit. The stores are followed by a
+ *       release fence, so the pixel is visible to any task (or DMA transfer)
+ *       that is started after the function returns.
+ *
  * @param src Source of data.
- * @param dst Destination in the TX buffer.
+ * @param dst Destination in the TX buffer, shall be 4 byte aligned.
  */
 static void hd108_lld_copy_pixel(const hd108_pixel_t *src, hd108_pixel_t *dst) {
-    const uint8_t *src_raw = (const uint8_t *)src;
-    uint8_t *dst_raw = (uint8_t *)dst;
+    hd108_lld_swap_pixel(src, (volatile uint32_t *)dst);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief Mark LEDs to be sent.
+ *
+ * @note With dirty tracking the next transfer sends at least the first end
+ *       LEDs. It is called after the pixels are written, so a transfer that
+ *       takes the mark also carries the pixels. With refresh on change the
+ *       first write after a transfer arms the one-shot timer, the writes
+ *       within one update period are sent together.
+ *
+ * @param ctx The address of the context.
+ * @param end Index of the last written LED plus one.
+ */
+static inline void hd108_lld_mark_dirty(hd108_ctx_t *ctx, uint16_t end) {
+    if (ctx->dirty_tracking) {
+        uint16_t dirty = __atomic_load_n(&ctx->dirty_end, __ATOMIC_RELAXED);
+        while ((dirty < end) && !__atomic_compare_exchange_n(&ctx->dirty_end, &dirty, end, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
 
-    // change endianness from little to big
-    dst_raw[0] = src_raw[1];
-    dst_raw[1] = src_raw[0];
-    dst_raw[2] = src_raw[3];
-    dst_raw[3] = src_raw[2];
-    dst_raw[4] = src_raw[5];
-    dst_raw[5] = src_raw[4];
-    dst_raw[6] = src_raw[7];
-    dst_raw[7] = src_raw[6];
+    if (ctx->refresh_on_change && !__atomic_load_n(&ctx->stopping, __ATOMIC_ACQUIRE) &&
+        !__atomic_exchange_n(&ctx->refresh_armed, true, __ATOMIC_ACQ_REL)) {
+        (void)esp_timer_start_once(ctx->timer, ctx->period_us);
+    }
 }
 
 
 /**
- * @brief Timer callback function.
+ * @brief Blend two frames into the TX buffer.
  *
- * @note The timer is responsible to achieve the desired update frequency.
- *       In each iteration it queues the next transaction and waits until
- *       the transaction is done. At the end of the transaction is calls
- *       the update function so the user can change the value of any LED
- *       for the next transaction.
- *       
+ * @note The fraction is the same for every pixel, so the kernel is a single
+ *       pass of lerp and copy without any per pixel branching on the mode.
  *
- * @param arg The address of the context.
+ * @param a Frame at fraction 0.
+ * @param b Frame at fraction 1.
+ * @param frac Fraction of the way from a to b.
+ * @param dst First pixel in the TX buffer.
+ * @param count Number of pixels.
  */
-static void hd108_lld_periodic_timer_callback(void* arg) {
-    spi_transaction_t *transaction;
-    hd108_ctx_t *ctx = (hd108_ctx_t *)arg;
-    (void)spi_device_queue_trans(ctx->device_handle, &ctx->transaction, portMAX_DELAY);
-    (void)spi_device_get_trans_result(ctx->device_handle, &transaction, portMAX_DELAY);
-    ctx->callback();
+static void hd108_lld_encode_lerp(const hd108_pixel_t *a, const hd108_pixel_t *b, hd108_fract16_t frac, hd108_pixel_t *dst, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        hd108_pixel_t pixel;
+        hd108_pixel_lerp16(&a[i], &b[i], frac, &pixel);
+        hd108_lld_copy_pixel(&pixel, &dst[i]);
+    }
 }
 
 
 /**
- * @brief Helper function to calculate timer period time.
+ * @brief Catmull-Rom interpolation between p1 and p2.
  *
- * @note It calculates the timer period time in microseconds from
- *       LED update frequency.
+ * @note The result is clamped to the color range, the curve may overshoot.
+ *
+ * @param p0 Sample before p1.
+ * @param p1 Sample at fraction 0.
+ * @param p2 Sample at fraction 1.
+ * @param p3 Sample after p2.
+ * @param frac Fraction of the way from p1 to p2.
  *
- * @param freq_hz Frequency in Hz.
- * 
  * @return
- *         - The timer period, in microseconds.
+ *         - The interpolated color value.
  */
-static uint32_t hd108_get_update_period_time(hd108_update_frequency_hz_t freq_hz) {
-    return 1000000 / freq_hz;
+static hd108_color_t hd108_lld_cubic16(int32_t p0, int32_t p1, int32_t p2, int32_t p3, hd108_fract16_t frac) {
+    int64_t t = frac;
+    int64_t a = 3 * (p1 - p2) + p3 - p0;
+    int64_t b = 2 * p0 - 5 * p1 + 4 * p2 - p3;
+    int64_t c = p2 - p0;
+
+    int64_t v = (((((a * t) >> 16) + b) * t >> 16) + c) * t >> 17;
+    v += p1;
+
+    if (v < 0) {
+        return 0;
+    }
+    if (v > UINT16_MAX) {
+        return UINT16_MAX;
+    }
+    return (hd108_color_t)v;
 }
 
 
 /**
- * @brief Creates and starts timer.
+ * @brief Upsample the rendered pixels into the TX buffer.
  *
- * @note It creates and starts the periodic timer that is used to
- *       create and handle SPI transaction.
+ * @note The position in the rendered pixels advances with a Q16 fixed-point
+ *       step per LED, so the inner loop has no division. Current levels are
+ *       always interpolated linearly, color values linearly or with a
+ *       Catmull-Rom spline.
  *
  * @param ctx The address of the context.
- * @param freq The update frequency of the LEd (strip)
- * 
- * @return
- *      - ESP_OK on success
- *      - ESP_ERR_INVALID_ARG if some of the create_args are not valid
- *      - ESP_ERR_INVALID_STATE if esp_timer library is not initialized yet
- *      - ESP_ERR_NO_MEM if memory allocation fails
+ * @param src Rendered pixels, render_count pixels.
+ * @param dst First pixel in the TX buffer.
  */
-static esp_err_t hd108_lld_start_timer_for_ctx(void *ctx, hd108_update_frequency_hz_t freq) {
-    esp_err_t err;
-    const esp_timer_create_args_t periodic_timer_args = {
-        .arg = ctx,
-        .callback = &hd108_lld_periodic_timer_callback,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = NULL,
-        .skip_unhandled_events = true
-    };
-
-    esp_timer_handle_t periodic_timer;
+static void hd108_lld_upsample(const hd108_ctx_t *ctx, const hd108_pixel_t *src, hd108_pixel_t *dst) {
+    uint16_t last = ctx->render_count - 1;
 
-    err = esp_timer_create(&periodic_timer_args, &periodic_timer);
-    if (ESP_OK != err) {
-        return err;
+    if ((ctx->render_count == ctx->strip_length) || (1 == ctx->strip_length)) {
+        for (uint16_t i = 0; i < ctx->strip_length; i++) {
+            hd108_lld_copy_pixel(&src[i], &dst[i]);
+        }
+        return;
     }
-    
-    err = esp_timer_start_periodic(periodic_timer, hd108_get_update_period_time(freq));
-    if (ESP_OK != err) {
-        // delete timer
-        esp_timer_delete(periodic_timer);
-        return err;
+
+    uint32_t step = ((uint32_t)last << 16) / (ctx->strip_length - 1);
+    uint32_t pos = 0;
+
+    for (uint16_t i = 0; i < ctx->strip_length; i++, pos += step) {
+        uint16_t j = pos >> 16;
+        hd108_fract16_t frac = pos & 0xffffU;
+        const hd108_pixel_t *p1 = &src[j];
+        const hd108_pixel_t *p2 = &src[(j < last) ? j + 1 : last];
+        hd108_pixel_t pixel;
+
+        hd108_pixel_lerp16(p1, p2, frac, &pixel);
+        if (HD108_LLD_UPSAMPLE_CUBIC == ctx->upsample) {
+            const hd108_pixel_t *p0 = &src[(j > 0) ? j - 1 : 0];
+            const hd108_pixel_t *p3 = &src[(j + 2 <= last) ? j + 2 : last];
+            pixel.red   = hd108_lld_cubic16(p0->red,   p1->red,   p2->red,   p3->red,   frac);
+            pixel.green = hd108_lld_cubic16(p0->green, p1->green, p2->green, p3->green, frac);
+            pixel.blue  = hd108_lld_cubic16(p0->blue,  p1->blue,  p2->blue,  p3->blue,  frac);
+        }
+        hd108_lld_copy_pixel(&pixel, &dst[i]);
     }
+}
 
-    return err;
+
+/**
+ * @brief Apply the resolution set by hd108_lld_set_resolution.
+ *
+ * @note It is called before the update function renders a frame, so a frame
+ *       is rendered and upsampled with the same render count.
+ *
+ * @param ctx The address of the context.
+ *
+ * @return
+ *         - true if the render count has changed
+ */
+static bool hd108_lld_apply_resolution(hd108_ctx_t *ctx) {
+    bool changed = (ctx->render_count != ctx->render_next);
+    ctx->render_count = ctx->render_next;
+    ctx->upsample = ctx->upsample_next;
+    return changed;
 }
 
 
-/******************************************************************************
- * Interface functions
- * 
- * Interface function documentation can be found in the header file!
- *****************************************************************************/
-hd108_status_t hd108_lld_init(const hd108_configuration_t *hd108_configuration, void **ctx_out) {
-    esp_err_t err;
+/**
+ * @brief Frame-rate upconversion step.
+ *
+ * @note It is called once per output frame. Every key_divider-th output frame
+ *       the next keyframe becomes the previous one and the update function is
+ *       called to render a new next keyframe. Every output frame the blend of
+ *       the two keyframes is encoded into the TX buffer, the last output frame
+ *       of the period shows the next keyframe exactly. A keyframe rendered at a
+ *       new resolution is held for its period instead of being blended with a
+ *       keyframe of the previous resolution. The update function is timed
+ *       as the update stage of the profiler, the swap of the keyframes and
+ *       the blend as the encode stage.
+ *
+ * @param ctx The address of the context.
+ * @param stamp Start of the current stage of the profiler, it is advanced.
+ */
+static void hd108_lld_upconvert(hd108_ctx_t *ctx, uint32_t *stamp) {
+    hd108_pixel_t *dst = (hd108_pixel_t *)((uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S);
 
-    // check strip length
-    if( (HD108_LLD_MIN_COUNT > hd108_configuration->count) || (HD108_LLD_MAX_COUNT < hd108_configuration->count)) {
-        return HD108_LLD_ERROR_LENGTH;
+    if (ctx->key_phase == ctx->key_divider) {
+        hd108_pixel_t *key = ctx->key_prev;
+        ctx->key_prev = ctx->key_next;
+        ctx->key_next = key;
+        HD108_TRACE(HD108_TRACE_SWAP, ctx);
+        // pixels that are not written keep their value
+        memcpy(ctx->key_next, ctx->key_prev, ctx->strip_length * sizeof(hd108_pixel_t));
+        bool resized = hd108_lld_apply_resolution(ctx);
+        hd108_lld_prof_stage(ctx, HD108_PROF_STAGE_ENCODE, stamp);
+        HD108_TRACE(HD108_TRACE_RENDER_START, ctx);
+        ctx->callback();
+        HD108_TRACE(HD108_TRACE_RENDER_END, ctx);
+        hd108_lld_prof_stage(ctx, HD108_PROF_STAGE_UPDATE, stamp);
+        if (resized) {
+            memcpy(ctx->key_prev, ctx->key_next, ctx->render_count * sizeof(hd108_pixel_t));
+        }
+        ctx->key_phase = 0;
     }
 
-    // check SPI frequency
-    if ( HD108_LLD_MAX_SPI_SPEED < hd108_configuration->spi_speed_hz) {
-        return HD108_LLD_ERROR_INVALID;
+    HD108_TRACE(HD108_TRACE_ENCODE_START, ctx);
+
+    ctx->key_phase++;
+    hd108_fract16_t frac = (hd108_fract16_t)(((uint32_t)ctx->key_phase << 16) / ctx->key_divider);
+    if (NULL != ctx->samples) {
+        // blend the rendered pixels first, then upsample them
+        if (ctx->key_phase == ctx->key_divider) {
+            memcpy(ctx->samples, ctx->key_next, ctx->render_count * sizeof(hd108_pixel_t));
+        } else {
+            for (uint16_t i = 0; i < ctx->render_count; i++) {
+                hd108_pixel_lerp16(&ctx->key_prev[i], &ctx->key_next[i], frac, &ctx->samples[i]);
+            }
+        }
+        hd108_lld_upsample(ctx, ctx->samples, dst);
+    } else if (ctx->key_phase == ctx->key_divider) {
+        hd108_lld_encode_lerp(ctx->key_next, ctx->key_next, 0, dst, ctx->strip_length);
+    } else {
+        hd108_lld_encode_lerp(ctx->key_prev, ctx->key_next, frac, dst, ctx->strip_length);
     }
+    HD108_TRACE(HD108_TRACE_ENCODE_END, ctx);
+}
 
-    // check callback function
-    if (NULL == hd108_configuration->update_function) {
-        return HD108_LLD_ERROR_INVALID;
+
+/**
+ * @brief Interleave planes into the TX buffer.
+ *
+ * @note Two pixels are handled per iteration. Each plane is read as one
+ *       32-bit word holding two values, the bytes of both values are swapped
+ *       at once, and the halves are recombined into the 32-bit words of the
+ *       two pixels. The start bit is added to the current levels.
+ *
+ * @param planes Planar frame.
+ * @param dst First pixel in the TX buffer.
+ * @param count Number of pixels.
+ */
+static void hd108_lld_interleave(const hd108_planes_t *planes, hd108_pixel_t *dst, uint16_t count) {
+    const uint32_t *cur = (const uint32_t *)planes->current;
+    const uint32_t *red = (const uint32_t *)planes->red;
+    const uint32_t *green = (const uint32_t *)planes->green;
+    const uint32_t *blue = (const uint32_t *)planes->blue;
+    volatile uint32_t *out = (volatile uint32_t *)dst;
+    uint16_t pairs = count / 2;
+
+    for (uint16_t i = 0; i < pairs; i++) {
+        uint32_t c = cur[i] | ((HD108_LLD_START_BIT << 16) | HD108_LLD_START_BIT);
+        uint32_t r = red[i];
+        uint32_t g = green[i];
+        uint32_t b = blue[i];
+
+        c = ((c & 0x00ff00ffUL) << 8) | ((c >> 8) & 0x00ff00ffUL);
+        r = ((r & 0x00ff00ffUL) << 8) | ((r >> 8) & 0x00ff00ffUL);
+        g = ((g & 0x00ff00ffUL) << 8) | ((g >> 8) & 0x00ff00ffUL);
+        b = ((b & 0x00ff00ffUL) << 8) | ((b >> 8) & 0x00ff00ffUL);
+
+        out[0] = (c & 0xffffUL) | (r << 16);
+        out[1] = (g & 0xffffUL) | (b << 16);
+        out[2] = (c >> 16) | (r & 0xffff0000UL);
+        out[3] = (g >> 16) | (b & 0xffff0000UL);
+        out += 4;
     }
 
-    // check data rate
-    uint16_t buffer_len = HD108_LLD_NUM_OF_0S + hd108_configuration->count * sizeof(hd108_pixel_t);
-    uint32_t rate = buffer_len * 8 * hd108_configuration->frequency_hz * 2;
-    if (rate > hd108_configuration->spi_speed_hz) {
-        return HD108_LLD_ERROR_DATA_RATE;
+    if (count & 1U) {
+        uint16_t last = count - 1;
+        uint16_t words[4] = {
+            planes->current[last], planes->red[last], planes->green[last], planes->blue[last]
+        };
+        hd108_lld_copy_pixel((const hd108_pixel_t *)words, &dst[last]);
     }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
 
-    // allocate memory for context
-    hd108_ctx_t *ctx = (hd108_ctx_t *)calloc(1, sizeof(hd108_ctx_t));
-    if (!ctx) {
-        return HD108_LLD_ERROR_NO_MEMORY;
+
+/**
+ * @brief Commit the rendered frame.
+ *
+ * @note It is called after the update function. Depending on the
+ *       configuration it interleaves the planes or upsamples the rendered
+ *       pixels into the TX buffer. Pixels written directly need no commit.
+ *
+ * @param ctx The address of the context.
+ */
+static void hd108_lld_commit(hd108_ctx_t *ctx) {
+    hd108_pixel_t *dst = (hd108_pixel_t *)((uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S);
+
+    if (NULL != ctx->planes.red) {
+        hd108_lld_interleave(&ctx->planes, dst, ctx->strip_length);
+    } else if (NULL != ctx->samples) {
+        hd108_lld_upsample(ctx, ctx->samples, dst);
     }
+}
 
-    // allocate memory for LED strip data (TX buffer)
-    uint8_t *buffer = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
-    if (!buffer) {
-        free(ctx);
-        return HD108_LLD_ERROR_NO_MEMORY;
+
+/**
+ * @brief Expand LEDs of the compact frame into a bounce buffer.
+ *
+ * @note Each channel is expanded through the LUT, which holds the 16-bit
+ *       values already in big endian, so one pixel is two table lookups
+ *       per word and two 32-bit stores.
+ *
+ * @param ctx The address of the context.
+ * @param first Index of the first LED.
+ * @param count Number of LEDs.
+ * @param dst Destination in the bounce buffer.
+ */
+static void hd108_lld_expand_compact(const hd108_ctx_t *ctx, uint16_t first, uint16_t count, uint32_t *dst) {
+    const uint8_t *src = &ctx->compact[3 * first];
+    const uint16_t *lut = ctx->compact_lut;
+    uint32_t current = ctx->compact_current;
+
+    for (uint16_t i = 0; i < count; i++, src += 3, dst += 2) {
+        dst[0] = current | ((uint32_t)lut[src[0]] << 16);
+        dst[1] = lut[src[1]] | ((uint32_t)lut[src[2]] << 16);
     }
+}
 
-    // initialize TX buffer
-    memset(buffer, 0, buffer_len);
 
-    // initialize transaction
-    ctx->transaction.tx_buffer = buffer;
-    ctx->transaction.length = 8 * buffer_len;
-    ctx->strip_length = hd108_configuration->count;
-    ctx->callback = hd108_configuration->update_function;
+/**
+ * @brief Transfer the compact frame.
+ *
+ * @note The frame is sent in chunks of HD108_LLD_BOUNCE_COUNT LEDs through
+ *       two bounce buffers. While one chunk is being sent the next one is
+ *       expanded into the other buffer, the device queue holds two
+ *       transactions, so the bus only pauses if the expansion is slower
+ *       than the transfer. The clock simply stops between the chunks, the
+ *       LEDs do not need a continuous stream.
+ *
+ * @param ctx The address of the context.
+ */
+static void hd108_lld_transfer_compact(hd108_ctx_t *ctx) {
+    spi_transaction_t *transaction;
+    uint8_t in_flight = 0;
+    uint8_t slot = 0;
 
-    // init SPI bus
-    spi_bus_config_t bus_config = {
-        .mosi_io_num = hd108_configuration->pin_mosi,
-        .sclk_io_num = hd108_configuration->pin_clk,
-        .miso_io_num = -1,
-        .quadhd_io_num = -1,
-        .quadwp_io_num = -1,
-        .flags = SPICOMMON_BUSFLAG_MASTER,
-        .max_transfer_sz = buffer_len,
-    };
+    for (uint16_t index = 0; index < ctx->strip_length; slot ^= 1) {
+        if (2 == in_flight) {
+            (void)spi_device_get_trans_result(ctx->device_handle, &transaction, portMAX_DELAY);
+            in_flight--;
+        }
 
-    err = spi_bus_initialize(hd108_configuration->spi_host, &bus_config, SPI_DMA_CH_AUTO);
-    switch (err) {
-        case ESP_ERR_INVALID_ARG:
-            //   if configuration is invalid
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_INVALID;
-        case ESP_ERR_INVALID_STATE:
-            // if host already is in use
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_SPI_IN_USE;
-        case ESP_ERR_NOT_FOUND:
-            // if there is no available DMA channel
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_NO_DMA;
-        case ESP_ERR_NO_MEM:
-            // if out of memory
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_NO_MEMORY;
-        case ESP_OK:
-            // on success
-            break;
-        default:
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_UNKNOWN;
-    }
+        uint16_t count = ctx->strip_length - index;
+        if (count > HD108_LLD_BOUNCE_COUNT) {
+            count = HD108_LLD_BOUNCE_COUNT;
+        }
 
-    // init SPI device
-    spi_device_interface_config_t device_interface_config = {
-        .clock_speed_hz = hd108_configuration->spi_speed_hz,
-        .mode = 3,
-        .spics_io_num = -1,
-        .queue_size = 1,
-        .command_bits = 0,
-        .address_bits = 0,
-        .dummy_bits = 0
-    };
+        // the 0 bytes are sent only before the first chunk
+        uint8_t *data = ctx->bounce[slot] + HD108_LLD_NUM_OF_0S;
+        hd108_lld_expand_compact(ctx, index, count, (uint32_t *)data);
 
-    err = spi_bus_add_device(hd108_configuration->spi_host, &device_interface_config, &ctx->device_handle);
-    switch (err) {
-        case ESP_ERR_INVALID_ARG:
-            // if parameter is invalid
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_INVALID;
-        case ESP_ERR_NOT_FOUND:
-            // if host doesn't have any free CS slots
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_NO_CS;
-        case ESP_ERR_NO_MEM:
-            // if out of memory
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_NO_MEMORY;
-        case ESP_OK:
-            // on success
+        spi_transaction_t *chunk = &ctx->bounce_transaction[slot];
+        chunk->tx_buffer = (0 == index) ? ctx->bounce[slot] : data;
+        chunk->length = 8 * (sizeof(hd108_pixel_t) * count + ((0 == index) ? HD108_LLD_NUM_OF_0S : 0));
+        if (!hd108_lld_queue(ctx, chunk)) {
+            // the rest of the frame would be sent to the wrong LEDs
             break;
-        default:
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_UNKNOWN;
+        }
+        in_flight++;
+        index += count;
     }
 
-    err = hd108_lld_start_timer_for_ctx((void*)ctx, hd108_configuration->frequency_hz);
-
-    switch (err) {
-        case ESP_ERR_INVALID_ARG:
-            // if parameter is invalid
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_INVALID;
-        case ESP_ERR_INVALID_STATE:
-            // if host already is in use
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_SPI_IN_USE;
-        case ESP_ERR_NO_MEM:
-            // if out of memory
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_NO_MEMORY;
-        case ESP_OK:
-            // on success
-            break;
-        default:
-            free(buffer);
-            free(ctx);
-            return HD108_LLD_ERROR_UNKNOWN;
+    while (0 != in_flight) {
+        (void)spi_device_get_trans_result(ctx->device_handle, &transaction, portMAX_DELAY);
+        in_flight--;
     }
+}
 
-    // set out parameter
-    *ctx_out = ctx;
 
-    return HD108_LLD_OK;
+/**
+ * @brief Acquire the shared bus.
+ *
+ * @note It waits until the transactions of the other devices are done and
+ *       keeps them out until the bus is released after the frame. The wait
+ *       is added to the bus statistics.
+ *
+ * @param ctx The address of the context.
+ */
+static void hd108_lld_acquire_bus(hd108_ctx_t *ctx) {
+    int64_t start = esp_timer_get_time();
+    (void)spi_device_acquire_bus(ctx->device_handle, portMAX_DELAY);
+    uint32_t wait = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&ctx->bus_lock);
+    ctx->bus_stats.frames++;
+    ctx->bus_stats.wait_last_us = wait;
+    ctx->bus_stats.wait_total_us += wait;
+    if (wait > ctx->bus_stats.wait_max_us) {
+        ctx->bus_stats.wait_max_us = wait;
+    }
+    portEXIT_CRITICAL(&ctx->bus_lock);
 }
 
-hd108_status_t hd108_lld_set_pixel(void *ctx_in, uint16_t index, hd108_pixel_t *pixel) {
-    // cast context
-    hd108_ctx_t *ctx = ctx_in;
 
-    // Check index
-    if (index >= ctx->strip_length) {
-        return HD108_LLD_ERROR_INDEX;
+/**
+ * @brief Queue a transaction.
+ *
+ * @note A transaction refused by the SPI master, e.g. because it is longer
+ *       than the max_transfer_sz of a shared bus, is counted as an error in
+ *       the bus statistics.
+ *
+ * @param ctx The address of the context.
+ * @param transaction The transaction.
+ *
+ * @return
+ *         - true if the transaction has been queued
+ */
+static bool hd108_lld_queue(hd108_ctx_t *ctx, spi_transaction_t *transaction) {
+    HD108_TRACE(HD108_TRACE_QUEUE, ctx);
+    if (ESP_OK == spi_device_queue_trans(ctx->device_handle, transaction, portMAX_DELAY)) {
+        return true;
     }
 
-    // Set start bit
-    hd108_pixel_data_t *pixel_data = (hd108_pixel_data_t *)pixel;
-    pixel_data->bit_start = 1;
+    portENTER_CRITICAL(&ctx->bus_lock);
+    ctx->bus_stats.errors++;
+    portEXIT_CRITICAL(&ctx->bus_lock);
 
-    // calculate address
-    uint8_t *dst = (uint8_t*)ctx->transaction.tx_buffer;
+    return false;
+}
 
-    // set data in buffer
+
+/**
+ * @brief Allocate a buffer of the context.
+ *
+ * @note It takes the buffer from the arena of the context, or from the heap
+ *       if there is no arena. The buffer is zeroed and aligned to 16 bytes.
+ *
+ * @param ctx The address of the context.
+ * @param size Size of the buffer in bytes.
+ * @param caps Capabilities of the heap memory, the arena has its own.
+ *
+ * @return
+ *         - The address of the buffer, NULL if memory allocation is not possible
+ */
+static void *hd108_lld_alloc(hd108_ctx_t *ctx, size_t size, uint32_t caps) {
+    void *mem;
+    if (NULL != ctx->arena) {
+        mem = hd108_arena_alloc(ctx->arena, size);
+    } else {
+        mem = heap_caps_aligned_alloc(HD108_LLD_PLANE_ALIGN, size, caps);
+    }
+    if (NULL != mem) {
+        memset(mem, 0, size);
+    }
+    return mem;
+}
+
+
+/**
+ * @brief Release a buffer of the context.
+ *
+ * @param ctx The address of the context.
+ * @param mem The address of the buffer, NULL is ignored.
+ */
+static void hd108_lld_release(hd108_ctx_t *ctx, void *mem) {
+    if (NULL != ctx->arena) {
+        hd108_arena_free(ctx->arena, mem);
+    } else {
+        heap_caps_free(mem);
+    }
+}
+
+
+/**
+ * @brief Release the transport.
+ *
+ * @note It removes the SPI device and frees the bus if the driver has
+ *       initialized it, a shared bus stays with the application. It is used
+ *       by the deinit and by every failed init, so the host can be used again.
+ *
+ * @param ctx The address of the context.
+ */
+static void hd108_lld_deinit_transport(hd108_ctx_t *ctx) {
+    if (NULL != ctx->device_handle) {
+        (void)spi_bus_remove_device(ctx->device_handle);
+        ctx->device_handle = NULL;
+    }
+    if (ctx->bus_owned) {
+        (void)spi_bus_free(ctx->spi_host);
+        ctx->bus_owned = false;
+    }
+    if (NULL != ctx->dedic) {
+        hd108_dedic_deinit(ctx->dedic);
+        ctx->dedic = NULL;
+    }
+}
+
+
+/**
+ * @brief Release context.
+ *
+ * @note It releases the transport, then frees the context and every buffer
+ *       that is owned by the context.
+ *
+ * @param ctx The address of the context.
+ */
+static void hd108_lld_free_ctx(hd108_ctx_t *ctx) {
+    hd108_lld_deinit_transport(ctx);
+    hd108_lld_release(ctx, (void *)ctx->transaction.tx_buffer);
+    hd108_lld_release(ctx, ctx->key_prev);
+    hd108_lld_release(ctx, ctx->key_next);
+    hd108_lld_release(ctx, ctx->samples);
+    hd108_lld_release(ctx, ctx->planes_mem);
+    hd108_lld_release(ctx, ctx->compact);
+    hd108_lld_release(ctx, ctx->compact_lut);
+    if (ctx->update_lock) {
+        vSemaphoreDelete(ctx->update_lock);
+    }
+    if (ctx->fence) {
+        (void)esp_timer_delete(ctx->fence);
+    }
+    if (ctx->fenced) {
+        vSemaphoreDelete(ctx->fenced);
+    }
+    if (ctx->copy) {
+        hd108_copy_deinit(ctx->copy);
+    }
+    free(ctx);
+}
+
+
+/**
+ * @brief Store pixel.
+ *
+ * @note It stores the pixel according to the configuration: into the next
+ *       keyframe, the planes, the rendered pixels or the TX buffer. The index
+ *       shall be checked by the caller.
+ *
+ * @param ctx The address of the context.
+ * @param index The index of the pixel.
+ * @param pixel Pointer to the pixel data.
+ */
+static void hd108_lld_store_pixel(hd108_ctx_t *ctx, uint16_t index, const hd108_pixel_t *pixel) {
+    // calculate address
+    uint8_t *dst = (uint8_t*)ctx->transaction.tx_buffer;
+
+    // keyframes are stored as they are, they are encoded by the upconversion
+    if (NULL != ctx->key_next) {
+        ctx->key_next[index] = *pixel;
+        return;
+    }
+
+    // pixels are split into the planes, they are interleaved by the commit
+    if (NULL != ctx->planes.red) {
+        uint16_t current;
+        memcpy(&current, pixel, sizeof(current));
+        ctx->planes.current[index] = current & ~HD108_LLD_START_BIT;
+        ctx->planes.red[index] = pixel->red;
+        ctx->planes.green[index] = pixel->green;
+        ctx->planes.blue[index] = pixel->blue;
+        return;
+    }
+
+    // rendered pixels are stored as they are, they are encoded by the upsampling
+    if (NULL != ctx->samples) {
+        ctx->samples[index] = *pixel;
+        return;
+    }
+
+    // compact frame keeps the upper 8 bits, it is expanded by the transfer
+    if (NULL != ctx->compact) {
+        uint8_t *compact = &ctx->compact[3 * index];
+        compact[0] = pixel->red >> 8;
+        compact[1] = pixel->green >> 8;
+        compact[2] = pixel->blue >> 8;
+        return;
+    }
+
+    // set data in buffer (start bit is set by the copy)
     hd108_lld_copy_pixel(pixel, (hd108_pixel_t *)(dst + HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * index));
+}
+
+
+/**
+ * @brief Load one pixel of the source and expand it to 16-bit.
+ *
+ * @param format Source format.
+ * @param src Source pixels.
+ * @param i Index of the pixel in the source.
+ * @param red Out parameter for red.
+ * @param green Out parameter for green.
+ * @param blue Out parameter for blue.
+ */
+static inline void hd108_lld_load(hd108_format_t format, const void *src, uint16_t i, uint16_t *red, uint16_t *green, uint16_t *blue) {
+    switch (format) {
+        case HD108_LLD_FORMAT_RGB565: {
+            uint16_t v = ((const uint16_t *)src)[i];
+            *red = hd108_lld_expand5[v >> 11];
+            *green = hd108_lld_expand6[(v >> 5) & 0x3fU];
+            *blue = hd108_lld_expand5[v & 0x1fU];
+            break;
+        }
+        case HD108_LLD_FORMAT_RGB888: {
+            const uint8_t *v = &((const uint8_t *)src)[3 * i];
+            *red = v[0] * 0x0101U;
+            *green = v[1] * 0x0101U;
+            *blue = v[2] * 0x0101U;
+            break;
+        }
+        case HD108_LLD_FORMAT_RGBA8888: {
+            const uint8_t *v = &((const uint8_t *)src)[4 * i];
+            uint16_t alpha = v[3] * 0x0101U;
+            *red = hd108_color_scale16(v[0] * 0x0101U, alpha);
+            *green = hd108_color_scale16(v[1] * 0x0101U, alpha);
+            *blue = hd108_color_scale16(v[2] * 0x0101U, alpha);
+            break;
+        }
+        case HD108_LLD_FORMAT_RGB48: {
+            const uint16_t *v = &((const uint16_t *)src)[3 * i];
+            *red = v[0];
+            *green = v[1];
+            *blue = v[2];
+            break;
+        }
+        case HD108_LLD_FORMAT_FLOAT:
+        default: {
+            const float *v = &((const float *)src)[3 * i];
+            uint16_t *out[3] = {red, green, blue};
+            for (uint8_t c = 0; c < 3; c++) {
+                float f = v[c];
+                *out[c] = (f <= 0.0f) ? 0 : ((f >= 1.0f) ? UINT16_MAX : (uint16_t)(f * 65535.0f + 0.5f));
+            }
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief Bulk write of pixels in an input format.
+ *
+ * @note It is inlined into each bulk write function with a constant format,
+ *       so every format gets its own conversion and encode loop. The range is
+ *       checked once for the whole block. If the pixels are written into the
+ *       TX buffer directly they are encoded in the same pass, otherwise they
+ *       are stored like hd108_lld_set_pixel does.
+ *
+ * @param ctx_in The address of the context.
+ * @param first Index of the first pixel.
+ * @param count Number of pixels.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ * @param format Source format.
+ * @param src Source pixels.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+static inline __attribute__((always_inline)) hd108_status_t hd108_lld_write_format(void *ctx_in, uint16_t first, uint16_t count, uint16_t current, hd108_format_t format, const void *src) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+    uint16_t red;
+    uint16_t green;
+    uint16_t blue;
+
+    // Check range
+    if ((uint32_t)first + count > ctx->render_count) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    if (NULL != ctx->compact) {
+        uint8_t *dst = &ctx->compact[3 * first];
+        if (HD108_LLD_FORMAT_RGB888 == format) {
+            memcpy(dst, src, 3 * count);
+            return HD108_LLD_OK;
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            hd108_lld_load(format, src, i, &red, &green, &blue);
+            dst[3 * i + 0] = red >> 8;
+            dst[3 * i + 1] = green >> 8;
+            dst[3 * i + 2] = blue >> 8;
+        }
+        return HD108_LLD_OK;
+    }
+
+    if ((NULL == ctx->key_next) && (NULL == ctx->planes.red) && (NULL == ctx->samples)) {
+        volatile uint32_t *dst = (volatile uint32_t *)((uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * first);
+        uint32_t wire_current = HD108_LLD_WIRE_CURRENT(current);
+        for (uint16_t i = 0; i < count; i++) {
+            hd108_lld_load(format, src, i, &red, &green, &blue);
+            hd108_lld_encode_pixel(wire_current, red, green, blue, &dst[2 * i]);
+        }
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        hd108_lld_mark_dirty(ctx, first + count);
+        return HD108_LLD_OK;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        hd108_pixel_t pixel;
+        hd108_lld_load(format, src, i, &red, &green, &blue);
+        memcpy(&pixel, &current, sizeof(current));
+        pixel.red = red;
+        pixel.green = green;
+        pixel.blue = blue;
+        hd108_lld_store_pixel(ctx, first + i, &pixel);
+    }
 
     return HD108_LLD_OK;
 }
 
+
+/**
+ * @brief Profile a stage.
+ *
+ * @note It adds the cycles since the stamp to the stage and moves the stamp
+ *       to now. Without a profiler it does nothing.
+ *
+ * @param ctx The address of the context.
+ * @param stage Stage that has ended.
+ * @param stamp End of the previous stage.
+ */
+static inline void hd108_lld_prof_stage(hd108_ctx_t *ctx, hd108_prof_stage_t stage, uint32_t *stamp) {
+#if HD108_PROF_ENABLE
+    if (NULL != ctx->prof) {
+        uint32_t now = hd108_prof_now();
+        hd108_prof_add(ctx->prof, stage, now - *stamp);
+        *stamp = now;
+    }
+#else
+    (void)ctx;
+    (void)stage;
+    (void)stamp;
+#endif
+}
+
+
+/**
+ * @brief Timer callback function.
+ *
+ * @note The timer is responsible to achieve the desired update frequency.
+ *       In each iteration it queues the next transaction and waits until
+ *       the transaction is done. At the end of the transaction is calls
+ *       the update function so the user can change the value of any LED
+ *       for the next transaction. A shared bus is held for the transaction
+ *       only. If frame-rate upconversion is enabled
+ *       the update function is called only for keyframes. Frames loaded
+ *       in the background are completed before the transaction is queued.
+ *       With dirty tracking the transaction ends at the last written LED,
+ *       the lanes of dedicated GPIO are always sent in full. With a profiler
+ *       the stages are timed and the frame is closed at the end. The update
+ *       lock is held for the whole update. With refresh on change the
+ *       pending refresh is taken before the transfer. The start of the
+ *       transfer is taken when its first transaction starts on the bus.
+ *       Once the deinit has started nothing is done.
+ *
+ * @param arg The address of the context.
+ */
+static void hd108_lld_periodic_timer_callback(void* arg) {
+    spi_transaction_t *transaction;
+    hd108_ctx_t *ctx = (hd108_ctx_t *)arg;
+    (void)xSemaphoreTake(ctx->update_lock, portMAX_DELAY);
+    if (ctx->stopping) {
+        // the context is released by the deinit after the fence
+        (void)xSemaphoreGive(ctx->update_lock);
+        return;
+    }
+    uint32_t stamp = hd108_prof_now();
+    HD108_TRACE(HD108_TRACE_TIMER, ctx);
+    if (ctx->refresh_on_change) {
+        // writes from now on arm the next refresh
+        (void)__atomic_exchange_n(&ctx->refresh_armed, false, __ATOMIC_ACQ_REL);
+    }
+    if (NULL != ctx->copy) {
+        hd108_copy_wait(ctx->copy);
+    }
+    ctx->transfer_start = 0;
+    uint16_t end = ctx->strip_length;
+    if (ctx->dirty_tracking) {
+        end = __atomic_exchange_n(&ctx->dirty_end, 0, __ATOMIC_ACQUIRE);
+        ctx->transaction.length = 8 * (HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * end);
+    }
+    if (0 == end) {
+        // nothing was written since the previous transfer, the LEDs keep their values
+    } else if (NULL != ctx->dedic) {
+        ctx->transfer_start = esp_timer_get_time();
+        hd108_dedic_transmit(ctx->dedic, (const uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S, sizeof(hd108_pixel_t) * ctx->strip_length);
+    } else {
+        if (ctx->bus_shared) {
+            hd108_lld_acquire_bus(ctx);
+        }
+        if (NULL != ctx->compact) {
+            hd108_lld_transfer_compact(ctx);
+        } else {
+            if (hd108_lld_queue(ctx, &ctx->transaction)) {
+                (void)spi_device_get_trans_result(ctx->device_handle, &transaction, portMAX_DELAY);
+            }
+        }
+        if (ctx->bus_shared) {
+            spi_device_release_bus(ctx->device_handle);
+        }
+    }
+    hd108_lld_prof_stage(ctx, HD108_PROF_STAGE_TRANSFER, &stamp);
+    if (0 != ctx->key_divider) {
+        // keyframes are rendered inside the upconversion
+        hd108_lld_upconvert(ctx, &stamp);
+    } else if (NULL != ctx->callback) {
+        (void)hd108_lld_apply_resolution(ctx);
+        HD108_TRACE(HD108_TRACE_RENDER_START, ctx);
+        ctx->callback();
+        HD108_TRACE(HD108_TRACE_RENDER_END, ctx);
+        hd108_lld_prof_stage(ctx, HD108_PROF_STAGE_UPDATE, &stamp);
+        HD108_TRACE(HD108_TRACE_ENCODE_START, ctx);
+        hd108_lld_commit(ctx);
+        HD108_TRACE(HD108_TRACE_ENCODE_END, ctx);
+    }
+    hd108_lld_prof_stage(ctx, HD108_PROF_STAGE_ENCODE, &stamp);
+    if (NULL != ctx->prof) {
+        hd108_prof_frame(ctx->prof);
+    }
+    (void)xSemaphoreGive(ctx->update_lock);
+}
+
+
+/**
+ * @brief Fence timer callback.
+ *
+ * @note The esp_timer task runs the callbacks one after the other, so when
+ *       the fence runs, a callback of the periodic timer that was in flight
+ *       has returned.
+ *
+ * @param arg The address of the context.
+ */
+static void hd108_lld_fence_callback(void *arg) {
+    hd108_ctx_t *ctx = (hd108_ctx_t *)arg;
+    (void)xSemaphoreGive(ctx->fenced);
+}
+
+
+/**
+ * @brief Helper function to calculate timer period time.
+ *
+ * @note It calculates the timer period time in microseconds from
+ *       LED update frequency.
+ *
+ * @param freq_hz Frequency in Hz.
+ * 
+ * @return
+ *         - The timer period, in microseconds.
+ */
+static uint32_t hd108_get_update_period_time(hd108_update_frequency_hz_t freq_hz) {
+    return 1000000 / freq_hz;
+}
+
+
+/**
+ * @brief Creates and starts timer.
+ *
+ * @note It creates and starts the periodic timer that is used to
+ *       create and handle SPI transaction. The timer is stored in the
+ *       context for the deinit. With refresh on change the timer is
+ *       one-shot, it is started for the first frame and then by the writes.
+ *       The fence timer of the deinit is created as well.
+ *
+ * @param ctx The address of the context.
+ * @param freq The update frequency of the LEd (strip)
+ * 
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if some of the create_args are not valid
+ *      - ESP_ERR_INVALID_STATE if esp_timer library is not initialized yet
+ *      - ESP_ERR_NO_MEM if memory allocation fails
+ */
+static esp_err_t hd108_lld_start_timer_for_ctx(hd108_ctx_t *ctx, hd108_update_frequency_hz_t freq) {
+    esp_err_t err;
+    const esp_timer_create_args_t periodic_timer_args = {
+        .arg = ctx,
+        .callback = &hd108_lld_periodic_timer_callback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = NULL,
+        .skip_unhandled_events = true
+    };
+
+    const esp_timer_create_args_t fence_timer_args = {
+        .arg = ctx,
+        .callback = &hd108_lld_fence_callback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = NULL,
+        .skip_unhandled_events = true
+    };
+
+    esp_timer_handle_t periodic_timer;
+
+    // the fence and its semaphore are released with the context
+    ctx->fenced = xSemaphoreCreateBinary();
+    if (!ctx->fenced) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = esp_timer_create(&fence_timer_args, &ctx->fence);
+    if (ESP_OK != err) {
+        return err;
+    }
+
+    err = esp_timer_create(&periodic_timer_args, &periodic_timer);
+    if (ESP_OK != err) {
+        return err;
+    }
+    
+    ctx->period_us = hd108_get_update_period_time(freq);
+    if (ctx->refresh_on_change) {
+        ctx->refresh_armed = true;
+        err = esp_timer_start_once(periodic_timer, ctx->period_us);
+    } else {
+        err = esp_timer_start_periodic(periodic_timer, ctx->period_us);
+    }
+    if (ESP_OK != err) {
+        // delete timer
+        esp_timer_delete(periodic_timer);
+        return err;
+    }
+
+    ctx->timer = periodic_timer;
+
+    return err;
+}
+
+
+/**
+ * @brief Init the SPI transport.
+ *
+ * @note It initializes the SPI bus and adds the LEDs as a device. A shared
+ *       bus is initialized by the application, only the device is added.
+ *
+ * @param hd108_configuration Pointer to the configuration struct.
+ * @param ctx The address of the context.
+ * @param buffer_len Length of the TX buffer.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_UNKNOWN     if unknown error occured
+ *         - HD108_LLD_ERROR_INVALID     if one of the configuration parameters is invalid
+ *         - HD108_LLD_ERROR_SPI_IN_USE  if the selected spi host is already in use
+ *         - HD108_LLD_ERROR_NO_DMA      if all the DMAs are used
+ *         - HD108_LLD_ERROR_NO_MEMORY   if memory allocation is not possible
+ *         - HD108_LLD_ERROR_NO_CS       if the SPI host doesn't have any free CS slots
+ */
+static hd108_status_t hd108_lld_init_spi(const hd108_configuration_t *hd108_configuration, hd108_ctx_t *ctx, uint16_t buffer_len) {
+    esp_err_t err = ESP_OK;
+
+    // init SPI bus
+    spi_bus_config_t bus_config = {
+        .mosi_io_num = hd108_configuration->pin_mosi,
+        .sclk_io_num = hd108_configuration->pin_clk,
+        .miso_io_num = -1,
+        .quadhd_io_num = -1,
+        .quadwp_io_num = -1,
+        .flags = SPICOMMON_BUSFLAG_MASTER,
+        .max_transfer_sz = buffer_len,
+    };
+
+    if (!hd108_configuration->spi_bus_shared) {
+        err = spi_bus_initialize(hd108_configuration->spi_host, &bus_config, SPI_DMA_CH_AUTO);
+    }
+    switch (err) {
+        case ESP_ERR_INVALID_ARG:
+            //   if configuration is invalid
+            return HD108_LLD_ERROR_INVALID;
+        case ESP_ERR_INVALID_STATE:
+            // if host already is in use
+            return HD108_LLD_ERROR_SPI_IN_USE;
+        case ESP_ERR_NOT_FOUND:
+            // if there is no available DMA channel
+            return HD108_LLD_ERROR_NO_DMA;
+        case ESP_ERR_NO_MEM:
+            // if out of memory
+            return HD108_LLD_ERROR_NO_MEMORY;
+        case ESP_OK:
+            // on success
+            break;
+        default:
+            return HD108_LLD_ERROR_UNKNOWN;
+    }
+    ctx->spi_host = hd108_configuration->spi_host;
+    ctx->bus_owned = !hd108_configuration->spi_bus_shared;
+
+    // init SPI device
+    spi_device_interface_config_t device_interface_config = {
+        .clock_speed_hz = hd108_configuration->spi_speed_hz,
+        .mode = 3,
+        .spics_io_num = (hd108_configuration->spi_bus_shared && hd108_configuration->spi_bus_gate) ? hd108_configuration->pin_gate : -1,
+        .queue_size = (NULL != ctx->compact) ? 2 : 1,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0
+    };
+
+    // the interrupt callbacks find the context in the transactions
+    device_interface_config.pre_cb = hd108_lld_pre_transfer;
+    ctx->transaction.user = ctx;
+    ctx->bounce_transaction[0].user = ctx;
+    ctx->bounce_transaction[1].user = ctx;
+#if CONFIG_HD108_TRACE
+    device_interface_config.post_cb = hd108_lld_trace_post;
+#endif
+
+    err = spi_bus_add_device(hd108_configuration->spi_host, &device_interface_config, &ctx->device_handle);
+    switch (err) {
+        case ESP_ERR_INVALID_ARG:
+            // if parameter is invalid
+            return HD108_LLD_ERROR_INVALID;
+        case ESP_ERR_NOT_FOUND:
+            // if host doesn't have any free CS slots
+            return HD108_LLD_ERROR_NO_CS;
+        case ESP_ERR_NO_MEM:
+            // if out of memory
+            return HD108_LLD_ERROR_NO_MEMORY;
+        case ESP_OK:
+            // on success
+            break;
+        default:
+            return HD108_LLD_ERROR_UNKNOWN;
+    }
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    // a shared bus may have been initialized for shorter transactions,
+    // the longest one is the frame or the first bounce buffer of the compact layout
+    if (hd108_configuration->spi_bus_shared) {
+        size_t max_len = 0;
+        size_t needed = buffer_len;
+        if ((NULL != ctx->compact) && (HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * HD108_LLD_BOUNCE_COUNT < needed)) {
+            needed = HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * HD108_LLD_BOUNCE_COUNT;
+        }
+        if ((ESP_OK == spi_bus_get_max_transaction_len(hd108_configuration->spi_host, &max_len)) && (max_len < needed)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    }
+#endif
+
+    return HD108_LLD_OK;
+}
+
+
+/**
+ * @brief Start of a transaction, called from the SPI interrupt.
+ *
+ * @note It takes the start time of the first transaction of the frame, the
+ *       update resets it before the transfer.
+ *
+ * @param transaction The transaction, user is the address of the context.
+ */
+static void IRAM_ATTR hd108_lld_pre_transfer(spi_transaction_t *transaction) {
+    hd108_ctx_t *ctx = transaction->user;
+
+    if (0 == ctx->transfer_start) {
+        ctx->transfer_start = esp_timer_get_time();
+    }
+    HD108_TRACE(HD108_TRACE_DMA_START, ctx);
+}
+
+
+#if CONFIG_HD108_TRACE
+
+
+/**
+ * @brief Trace the end of a transaction, called from the SPI interrupt.
+ *
+ * @param transaction The transaction, user is the address of the context.
+ */
+static void IRAM_ATTR hd108_lld_trace_post(spi_transaction_t *transaction) {
+    HD108_TRACE(HD108_TRACE_DMA_DONE, transaction->user);
+}
+#endif
+
+
+/******************************************************************************
+ * Interface functions
+ * 
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_lld_init(const hd108_configuration_t *hd108_configuration, void **ctx_out) {
+    esp_err_t err;
+
+    // check strip length
+    if( (HD108_LLD_MIN_COUNT > hd108_configuration->count) || (HD108_LLD_MAX_COUNT < hd108_configuration->count)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // check SPI frequency
+    if ( HD108_LLD_MAX_SPI_SPEED < hd108_configuration->spi_speed_hz) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check callback function, it is optional only in live write mode
+    if ((NULL == hd108_configuration->update_function) && !hd108_configuration->live_write) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check frame-rate upconversion, keyframes are rendered by the update function
+    if ((1 < hd108_configuration->keyframe_divider) && hd108_configuration->live_write) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check spatial upsampling, the rendered pixels are upsampled after the update function
+    if (hd108_configuration->render_count > hd108_configuration->count) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+    if ((0 != hd108_configuration->render_count) && hd108_configuration->live_write) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_LLD_UPSAMPLE_LINEAR != hd108_configuration->upsample) && (HD108_LLD_UPSAMPLE_CUBIC != hd108_configuration->upsample)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check layout, planes are committed after the update function, the compact frame is expanded by the transfer
+    if ((HD108_LLD_LAYOUT_PLANAR == hd108_configuration->layout) || (HD108_LLD_LAYOUT_COMPACT == hd108_configuration->layout)) {
+        if (hd108_configuration->live_write || (0 != hd108_configuration->render_count) || (1 < hd108_configuration->keyframe_divider)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    } else if (HD108_LLD_LAYOUT_PIXEL != hd108_configuration->layout) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check dirty tracking, the transfer length follows the writes into the TX buffer
+    if (hd108_configuration->dirty_tracking && ((HD108_LLD_LAYOUT_PIXEL != hd108_configuration->layout) ||
+        (0 != hd108_configuration->render_count) || (1 < hd108_configuration->keyframe_divider))) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check refresh on change, the writes of live write mode trigger the refreshes
+    if (hd108_configuration->refresh_on_change && (!hd108_configuration->live_write ||
+        (NULL != hd108_configuration->update_function) || hd108_configuration->external_update)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check transport, the compact layout streams through SPI bounce buffers
+    if (HD108_LLD_TRANSPORT_DEDIC_GPIO == hd108_configuration->transport) {
+        if ((HD108_LLD_MAX_LANES < hd108_configuration->lane_count) || (HD108_LLD_LAYOUT_COMPACT == hd108_configuration->layout)) {
+            return HD108_LLD_ERROR_INVALID;
+        }
+    } else if (HD108_LLD_TRANSPORT_SPI != hd108_configuration->transport) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // check data rate, dedicated GPIO is clocked by the CPU
+    uint16_t buffer_len = HD108_LLD_NUM_OF_0S + hd108_configuration->count * sizeof(hd108_pixel_t);
+    uint32_t rate = buffer_len * 8 * hd108_configuration->frequency_hz * 2;
+    if ((HD108_LLD_TRANSPORT_SPI == hd108_configuration->transport) && (rate > hd108_configuration->spi_speed_hz)) {
+        return HD108_LLD_ERROR_DATA_RATE;
+    }
+
+    hd108_trace_init();
+
+    // allocate memory for context
+    hd108_ctx_t *ctx = (hd108_ctx_t *)calloc(1, sizeof(hd108_ctx_t));
+    if (!ctx) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+    ctx->arena = hd108_configuration->arena;
+    ctx->update_lock = xSemaphoreCreateMutex();
+    if (!ctx->update_lock) {
+        free(ctx);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // allocate memory for LED strip data (TX buffer), the compact layout has two bounce buffers only
+    uint16_t alloc_len = buffer_len;
+    if (HD108_LLD_LAYOUT_COMPACT == hd108_configuration->layout) {
+        alloc_len = 2 * (HD108_LLD_NUM_OF_0S + HD108_LLD_BOUNCE_COUNT * sizeof(hd108_pixel_t));
+    }
+    uint8_t *buffer = (uint8_t *)hd108_lld_alloc(ctx, alloc_len, MALLOC_CAP_DMA | MALLOC_CAP_32BIT);
+    if (!buffer) {
+        hd108_lld_free_ctx(ctx);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // initialize transaction
+    ctx->transaction.tx_buffer = buffer;
+    ctx->transaction.length = 8 * buffer_len;
+    ctx->strip_length = hd108_configuration->count;
+    ctx->callback = hd108_configuration->update_function;
+    ctx->dirty_tracking = hd108_configuration->dirty_tracking;
+    ctx->dirty_end = ctx->strip_length;
+
+    ctx->render_count = ctx->strip_length;
+    ctx->render_next = ctx->strip_length;
+    ctx->upsample = hd108_configuration->upsample;
+    ctx->upsample_next = ctx->upsample;
+
+    // allocate rendered pixels for spatial upsampling
+    if (0 != hd108_configuration->render_count) {
+        ctx->render_count = hd108_configuration->render_count;
+        ctx->render_next = ctx->render_count;
+        ctx->samples = (hd108_pixel_t *)hd108_lld_alloc(ctx, ctx->strip_length * sizeof(hd108_pixel_t), MALLOC_CAP_8BIT);
+        if (!ctx->samples) {
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        }
+    }
+
+    // allocate planes for planar layout, one block with aligned planes
+    if (HD108_LLD_LAYOUT_PLANAR == hd108_configuration->layout) {
+        size_t plane_len = (ctx->strip_length * sizeof(uint16_t) + HD108_LLD_PLANE_ALIGN - 1) & ~(HD108_LLD_PLANE_ALIGN - 1);
+        uint8_t *mem = (uint8_t *)hd108_lld_alloc(ctx, 4 * plane_len, MALLOC_CAP_8BIT);
+        if (!mem) {
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        }
+        ctx->planes_mem = mem;
+        ctx->planes.red = (hd108_color_t *)(mem + 0 * plane_len);
+        ctx->planes.green = (hd108_color_t *)(mem + 1 * plane_len);
+        ctx->planes.blue = (hd108_color_t *)(mem + 2 * plane_len);
+        ctx->planes.current = (uint16_t *)(mem + 3 * plane_len);
+        ctx->planes.count = ctx->strip_length;
+    }
+
+    // allocate compact frame and expansion table for compact layout
+    if (HD108_LLD_LAYOUT_COMPACT == hd108_configuration->layout) {
+        ctx->compact = (uint8_t *)hd108_lld_alloc(ctx, ctx->strip_length * 3, MALLOC_CAP_8BIT);
+        ctx->compact_lut = (uint16_t *)hd108_lld_alloc(ctx, 256 * sizeof(uint16_t), MALLOC_CAP_8BIT);
+        if (!ctx->compact || !ctx->compact_lut) {
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        }
+        for (uint16_t v = 0; v < 256; v++) {
+            uint16_t value = hd108_configuration->compact_lut ? hd108_configuration->compact_lut[v] : v * 0x0101U;
+            ctx->compact_lut[v] = __builtin_bswap16(value);
+        }
+        ctx->compact_current = __builtin_bswap16((uint16_t)(hd108_configuration->compact_current | HD108_LLD_START_BIT));
+        ctx->bounce[0] = buffer;
+        ctx->bounce[1] = buffer + alloc_len / 2;
+    }
+
+    // allocate keyframes for frame-rate upconversion
+    if (1 < hd108_configuration->keyframe_divider) {
+        ctx->key_divider = hd108_configuration->keyframe_divider;
+        ctx->key_phase = ctx->key_divider;
+        ctx->key_prev = (hd108_pixel_t *)hd108_lld_alloc(ctx, ctx->strip_length * sizeof(hd108_pixel_t), MALLOC_CAP_8BIT);
+        ctx->key_next = (hd108_pixel_t *)hd108_lld_alloc(ctx, ctx->strip_length * sizeof(hd108_pixel_t), MALLOC_CAP_8BIT);
+        if (!ctx->key_prev || !ctx->key_next) {
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        }
+    }
+
+    // create copy engine for loading frames in the background
+    if (hd108_configuration->async_copy) {
+        hd108_status_t status = hd108_copy_init(HD108_COPY_AUTO, &ctx->copy);
+        if (HD108_LLD_OK != status) {
+            hd108_lld_free_ctx(ctx);
+            return status;
+        }
+    }
+
+    // init transport
+    hd108_status_t status;
+    if (HD108_LLD_TRANSPORT_DEDIC_GPIO == hd108_configuration->transport) {
+        uint8_t lanes = (0 == hd108_configuration->lane_count) ? 1 : hd108_configuration->lane_count;
+        const uint8_t *pins = (NULL == hd108_configuration->pin_lanes) ? &hd108_configuration->pin_mosi : hd108_configuration->pin_lanes;
+        uint32_t lane_len = sizeof(hd108_pixel_t) * ((ctx->strip_length + lanes - 1) / lanes);
+        status = hd108_dedic_init(hd108_configuration->pin_clk, pins, lanes, lane_len, &ctx->dedic);
+    } else {
+        status = hd108_lld_init_spi(hd108_configuration, ctx, buffer_len);
+    }
+    if (HD108_LLD_OK != status) {
+        hd108_lld_free_ctx(ctx);
+        return status;
+    }
+
+    ctx->bus_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    ctx->bus_shared = hd108_configuration->spi_bus_shared && (NULL == ctx->dedic);
+    ctx->external_update = hd108_configuration->external_update;
+    ctx->refresh_on_change = hd108_configuration->refresh_on_change;
+    err = ESP_OK;
+    if (!ctx->external_update) {
+        err = hd108_lld_start_timer_for_ctx(ctx, hd108_configuration->frequency_hz);
+    }
+
+    switch (err) {
+        case ESP_ERR_INVALID_ARG:
+            // if parameter is invalid
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_INVALID;
+        case ESP_ERR_INVALID_STATE:
+            // if host already is in use
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_SPI_IN_USE;
+        case ESP_ERR_NO_MEM:
+            // if out of memory
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_NO_MEMORY;
+        case ESP_OK:
+            // on success
+            break;
+        default:
+            hd108_lld_free_ctx(ctx);
+            return HD108_LLD_ERROR_UNKNOWN;
+    }
+
+    // set out parameter
+    *ctx_out = ctx;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_update(void *ctx_in) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // the own timer would run the same update concurrently
+    if (!ctx->external_update) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    hd108_lld_periodic_timer_callback(ctx);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_deinit(void *ctx_in) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // wait for a running update, no update or refresh starts from now on
+    (void)xSemaphoreTake(ctx->update_lock, portMAX_DELAY);
+    __atomic_store_n(&ctx->stopping, true, __ATOMIC_RELEASE);
+    (void)xSemaphoreGive(ctx->update_lock);
+
+    // esp_timer_stop does not wait for a callback in flight, it has returned
+    // when the fence has run, then the timer and the lock can be deleted
+    if (NULL != ctx->timer) {
+        (void)esp_timer_stop(ctx->timer);
+        (void)esp_timer_start_once(ctx->fence, 0);
+        (void)xSemaphoreTake(ctx->fenced, portMAX_DELAY);
+        (void)esp_timer_delete(ctx->timer);
+    }
+
+    // the transport is released with the context, a shared bus stays with the application
+    hd108_lld_free_ctx(ctx);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_set_profiler(void *ctx_in, void *prof_in) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    ctx->prof = prof_in;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_get_bus_stats(void *ctx_in, hd108_bus_stats_t *stats_out) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    if (!ctx->bus_shared) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    portENTER_CRITICAL(&ctx->bus_lock);
+    *stats_out = ctx->bus_stats;
+    portEXIT_CRITICAL(&ctx->bus_lock);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_get_transfer_start(void *ctx_in, int64_t *start_out) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // the start of the last complete update
+    (void)xSemaphoreTake(ctx->update_lock, portMAX_DELAY);
+    *start_out = ctx->transfer_start;
+    (void)xSemaphoreGive(ctx->update_lock);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_set_pixel(void *ctx_in, uint16_t index, const hd108_pixel_t *pixel) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // Check index
+    if (index >= ctx->render_count) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    hd108_lld_store_pixel(ctx, index, pixel);
+    hd108_lld_mark_dirty(ctx, index + 1);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_write_rgb565(void *ctx_in, uint16_t first, uint16_t count, const uint16_t *src, uint16_t current) {
+    return hd108_lld_write_format(ctx_in, first, count, current, HD108_LLD_FORMAT_RGB565, src);
+}
+
+hd108_status_t hd108_lld_write_rgb888(void *ctx_in, uint16_t first, uint16_t count, const uint8_t *src, uint16_t current) {
+    return hd108_lld_write_format(ctx_in, first, count, current, HD108_LLD_FORMAT_RGB888, src);
+}
+
+hd108_status_t hd108_lld_write_rgba8888(void *ctx_in, uint16_t first, uint16_t count, const uint8_t *src, uint16_t current) {
+    return hd108_lld_write_format(ctx_in, first, count, current, HD108_LLD_FORMAT_RGBA8888, src);
+}
+
+hd108_status_t hd108_lld_write_rgb48(void *ctx_in, uint16_t first, uint16_t count, const uint16_t *src, uint16_t current) {
+    return hd108_lld_write_format(ctx_in, first, count, current, HD108_LLD_FORMAT_RGB48, src);
+}
+
+hd108_status_t hd108_lld_write_float(void *ctx_in, uint16_t first, uint16_t count, const float *src, uint16_t current) {
+    return hd108_lld_write_format(ctx_in, first, count, current, HD108_LLD_FORMAT_FLOAT, src);
+}
+
+
+hd108_status_t hd108_lld_scatter(void *ctx_in, const uint16_t *indices, const hd108_pixel_t *pixels, uint16_t count) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+    uint32_t end = 0;
+
+    // an empty batch shall not arm a refresh of the unchanged frame
+    if (0 == count) {
+        return HD108_LLD_OK;
+    }
+
+    // Check the whole batch
+    for (uint16_t i = 0; i < count; i++) {
+        if (indices[i] >= end) {
+            end = indices[i] + 1UL;
+        }
+    }
+    if (end > ctx->render_count) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    if ((NULL == ctx->key_next) && (NULL == ctx->planes.red) && (NULL == ctx->samples) && (NULL == ctx->compact)) {
+        volatile uint32_t *dst = (volatile uint32_t *)((uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S);
+        for (uint16_t i = 0; i < count; i++) {
+            hd108_lld_swap_pixel(&pixels[i], &dst[2 * indices[i]]);
+        }
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    } else {
+        for (uint16_t i = 0; i < count; i++) {
+            hd108_lld_store_pixel(ctx, indices[i], &pixels[i]);
+        }
+    }
+    hd108_lld_mark_dirty(ctx, (uint16_t)end);
+
+    return HD108_LLD_OK;
+}
+
+void hd108_lld_scatter_sort(uint16_t *indices, hd108_pixel_t *pixels, uint16_t count) {
+    static const uint16_t gaps[] = {701, 301, 132, 57, 23, 10, 4, 1};
+
+    // shell sort, in place
+    for (uint8_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        uint16_t gap = gaps[g];
+        for (uint16_t i = gap; i < count; i++) {
+            uint16_t index = indices[i];
+            hd108_pixel_t pixel = pixels[i];
+            uint16_t j = i;
+            while ((j >= gap) && (indices[j - gap] > index)) {
+                indices[j] = indices[j - gap];
+                pixels[j] = pixels[j - gap];
+                j -= gap;
+            }
+            indices[j] = index;
+            pixels[j] = pixel;
+        }
+    }
+}
+
+hd108_status_t hd108_lld_set_resolution(void *ctx_in, uint16_t render_count, hd108_upsample_t upsample) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // spatial upsampling shall be enabled by the configuration
+    if (NULL == ctx->samples) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    if ((HD108_LLD_UPSAMPLE_LINEAR != upsample) && (HD108_LLD_UPSAMPLE_CUBIC != upsample)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    if ((HD108_LLD_MIN_COUNT > render_count) || (ctx->strip_length < render_count)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    ctx->render_next = render_count;
+    ctx->upsample_next = upsample;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_get_planes(void *ctx_in, hd108_planes_t *planes_out) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    if (NULL == ctx->planes.red) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    *planes_out = ctx->planes;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_set_compact_current(void *ctx_in, uint16_t current) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    if (NULL == ctx->compact) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    ctx->compact_current = __builtin_bswap16((uint16_t)(current | HD108_LLD_START_BIT));
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_capture_frame(void *ctx_in, uint16_t first, uint16_t count, void *dst) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // there is no complete TX buffer in compact layout
+    if (NULL != ctx->compact) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // Check range
+    if ((uint32_t)first + count > ctx->strip_length) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    memcpy(dst, (const uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * first, HD108_LLD_FRAME_SIZE(count));
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_load_frame(void *ctx_in, uint16_t first, uint16_t count, const void *src) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // the TX buffer shall not be built after the update function
+    if ((NULL != ctx->key_next) || (NULL != ctx->planes.red) || (NULL != ctx->samples) || (NULL != ctx->compact)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // Check range
+    if ((uint32_t)first + count > ctx->strip_length) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    uint8_t *dst = (uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * first;
+    if (NULL != ctx->copy) {
+        (void)hd108_copy_start(ctx->copy, dst, src, HD108_LLD_FRAME_SIZE(count));
+    } else {
+        memcpy(dst, src, HD108_LLD_FRAME_SIZE(count));
+    }
+    hd108_lld_mark_dirty(ctx, first + count);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_open_frame(void *ctx_in, uint16_t first, uint16_t count, uint32_t **frame_out) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // the TX buffer shall not be built after the update function
+    if ((NULL != ctx->key_next) || (NULL != ctx->planes.red) || (NULL != ctx->samples) || (NULL != ctx->compact)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // Check range
+    if ((uint32_t)first + count > ctx->strip_length) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    *frame_out = (uint32_t *)((uint8_t *)ctx->transaction.tx_buffer + HD108_LLD_NUM_OF_0S + sizeof(hd108_pixel_t) * first);
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_lld_close_frame(void *ctx_in, uint16_t first, uint16_t count) {
+    // cast context
+    hd108_ctx_t *ctx = ctx_in;
+
+    // Check range
+    if ((uint32_t)first + count > ctx->strip_length) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    hd108_lld_mark_dirty(ctx, first + count);
+
+    return HD108_LLD_OK;
+}
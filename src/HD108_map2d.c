@@ -0,0 +1,233 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "HD108_map2d.h"
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Mapping variable to store matrix related information.
+ */
+typedef struct {
+    void                   *ctx;        ///< The address of the driver context
+    uint16_t                width;      ///< Width of the matrix
+    uint16_t                height;     ///< Height of the matrix
+    uint16_t                first;      ///< Index of the LED at position (0, 0)
+    hd108_map2d_order_t     order;      ///< Wiring of the matrix rows
+    const uint16_t         *table;      ///< Index table for table wiring
+    uint8_t                *row;        ///< Row buffer, width pixels of the largest source format
+} hd108_map2d_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static hd108_status_t   hd108_map2d_write_run   (hd108_map2d_t *map, uint16_t index, uint16_t count, const uint8_t *src, uint8_t bpp, uint16_t current);
+static hd108_status_t   hd108_map2d_write_rect  (hd108_map2d_t *map, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *src, uint8_t bpp, uint16_t current);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Write consecutive LEDs.
+ *
+ * @param map The address of the mapping.
+ * @param index Index of the first LED.
+ * @param count Number of LEDs.
+ * @param src Source pixels.
+ * @param bpp Bytes per pixel of the source, 2 for RGB565, 3 for RGB888.
+ * @param current Current levels for every pixel.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the range is out of the strip
+ */
+static hd108_status_t hd108_map2d_write_run(hd108_map2d_t *map, uint16_t index, uint16_t count, const uint8_t *src, uint8_t bpp, uint16_t current) {
+    if (2 == bpp) {
+        return hd108_lld_write_rgb565(map->ctx, index, count, (const uint16_t *)src, current);
+    }
+    return hd108_lld_write_rgb888(map->ctx, index, count, src, current);
+}
+
+
+/**
+ * @brief Write a rectangle.
+ *
+ * @note Common implementation of the RGB565 and RGB888 writes.
+ *
+ * @param map The address of the mapping.
+ * @param x Left column of the rectangle.
+ * @param y Top row of the rectangle.
+ * @param width Width of the rectangle.
+ * @param height Height of the rectangle.
+ * @param src Source pixels, row by row without padding.
+ * @param bpp Bytes per pixel of the source, 2 for RGB565, 3 for RGB888.
+ * @param current Current levels for every pixel.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the rectangle is out of the matrix or the strip
+ */
+static hd108_status_t hd108_map2d_write_rect(hd108_map2d_t *map, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *src, uint8_t bpp, uint16_t current) {
+    hd108_status_t status = HD108_LLD_OK;
+
+    // Check rectangle
+    if (((uint32_t)x + width > map->width) || ((uint32_t)y + height > map->height)) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    for (uint16_t row = y; (row < y + height) && (HD108_LLD_OK == status); row++) {
+        if (HD108_MAP2D_TABLE == map->order) {
+            const uint16_t *indexes = &map->table[(uint32_t)row * map->width + x];
+            for (uint16_t col = 0; (col < width) && (HD108_LLD_OK == status); col++) {
+                if (HD108_MAP2D_NO_LED != indexes[col]) {
+                    status = hd108_map2d_write_run(map, indexes[col], 1, &src[col * bpp], bpp, current);
+                }
+            }
+        } else if ((HD108_MAP2D_SERPENTINE == map->order) && (row & 1U)) {
+            // reversed row, the rightmost pixel is the first LED of the run
+            for (uint16_t col = 0; col < width; col++) {
+                memcpy(&map->row[(width - 1 - col) * bpp], &src[col * bpp], bpp);
+            }
+            uint16_t index = map->first + (uint32_t)row * map->width + (map->width - 1 - (x + width - 1));
+            status = hd108_map2d_write_run(map, index, width, map->row, bpp, current);
+        } else {
+            uint16_t index = map->first + (uint32_t)row * map->width + x;
+            status = hd108_map2d_write_run(map, index, width, src, bpp, current);
+        }
+        src += (uint32_t)width * bpp;
+    }
+
+    return status;
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_map2d_init(const hd108_map2d_configuration_t *map2d_configuration, void **map_out) {
+    // check size
+    if ((0 == map2d_configuration->width) || (HD108_MAP2D_MAX_SIZE < map2d_configuration->width) ||
+        (0 == map2d_configuration->height) || (HD108_MAP2D_MAX_SIZE < map2d_configuration->height)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // check context and wiring
+    if (NULL == map2d_configuration->ctx) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_MAP2D_TABLE == map2d_configuration->order) && (NULL == map2d_configuration->table)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_MAP2D_TABLE != map2d_configuration->order) &&
+        (((uint32_t)map2d_configuration->width * map2d_configuration->height + map2d_configuration->first) > HD108_LLD_MAX_COUNT)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // allocate memory for mapping
+    hd108_map2d_t *map = (hd108_map2d_t *)calloc(1, sizeof(hd108_map2d_t));
+    if (!map) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // allocate memory for row buffer, large enough for RGB888
+    map->row = (uint8_t *)malloc(3 * map2d_configuration->width);
+    if (!map->row) {
+        free(map);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    map->ctx = map2d_configuration->ctx;
+    map->width = map2d_configuration->width;
+    map->height = map2d_configuration->height;
+    map->first = map2d_configuration->first;
+    map->order = map2d_configuration->order;
+    map->table = map2d_configuration->table;
+
+    // set out parameter
+    *map_out = map;
+
+    return HD108_LLD_OK;
+}
+
+uint16_t hd108_map2d_index(void *map_in, uint16_t x, uint16_t y) {
+    // cast mapping
+    hd108_map2d_t *map = map_in;
+
+    if ((x >= map->width) || (y >= map->height)) {
+        return HD108_MAP2D_NO_LED;
+    }
+
+    switch (map->order) {
+        case HD108_MAP2D_TABLE:
+            return map->table[(uint32_t)y * map->width + x];
+        case HD108_MAP2D_SERPENTINE:
+            if (y & 1U) {
+                return map->first + (uint32_t)y * map->width + (map->width - 1 - x);
+            }
+            return map->first + (uint32_t)y * map->width + x;
+        case HD108_MAP2D_PROGRESSIVE:
+        default:
+            return map->first + (uint32_t)y * map->width + x;
+    }
+}
+
+void hd108_map2d_get_size(void *map_in, uint16_t *width_out, uint16_t *height_out) {
+    // cast mapping
+    hd108_map2d_t *map = map_in;
+
+    *width_out = map->width;
+    *height_out = map->height;
+}
+
+hd108_status_t hd108_map2d_write_rgb565(void *map_in, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *src, uint16_t current) {
+    return hd108_map2d_write_rect(map_in, x, y, width, height, (const uint8_t *)src, 2, current);
+}
+
+hd108_status_t hd108_map2d_write_rgb888(void *map_in, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint8_t *src, uint16_t current) {
+    return hd108_map2d_write_rect(map_in, x, y, width, height, src, 3, current);
+}
+
+void hd108_map2d_deinit(void *map_in) {
+    // cast mapping
+    hd108_map2d_t *map = map_in;
+
+    free(map->row);
+    free(map);
+}
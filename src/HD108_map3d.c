@@ -0,0 +1,293 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "esp_partition.h"
+#include "HD108_color.h"
+#include "HD108_map3d.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_MAP3D_BATCH           (      32UL)    ///< number of LEDs rendered per batch
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Mapping variable to store the coordinate planes.
+ */
+typedef struct {
+    void                           *ctx;        ///< The address of the driver context
+    uint16_t                        first;      ///< Index of the LED of the first coordinate
+    uint16_t                        count;      ///< Number of LEDs
+    const int16_t                  *x;          ///< x plane in the blob
+    const int16_t                  *y;          ///< y plane in the blob
+    const int16_t                  *z;          ///< z plane in the blob
+    esp_partition_mmap_handle_t     mmap;       ///< Handle of the mapped partition
+    bool                            mapped;     ///< The blob is a mapped partition
+} hd108_map3d_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static uint32_t     hd108_map3d_isqrt       (uint32_t value);
+static uint16_t     hd108_map3d_falloff     (uint32_t distance, uint16_t width, uint32_t inv_width);
+static void         hd108_map3d_eval_range  (const hd108_map3d_t *map, const hd108_map3d_field_t *field, uint16_t start, uint16_t count, uint16_t *out);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Integer square root.
+ *
+ * @param value Radicand.
+ *
+ * @return
+ *         - floor(sqrt(value)).
+ */
+static uint32_t hd108_map3d_isqrt(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (0 != bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+
+/**
+ * @brief Linear falloff from the surface of a field.
+ *
+ * @param distance Distance from the surface, Q15.
+ * @param width Falloff width, Q15.
+ * @param inv_width Reciprocal of the width, (65535 << 15) / width.
+ *
+ * @return
+ *         - 65535 on the surface, 0 at width distance or farther.
+ */
+static uint16_t hd108_map3d_falloff(uint32_t distance, uint16_t width, uint32_t inv_width) {
+    if (distance >= width) {
+        return 0;
+    }
+    return (uint16_t)(UINT16_MAX - ((distance * inv_width) >> 15));
+}
+
+
+/**
+ * @brief Evaluate a spatial field for a range of LEDs.
+ *
+ * @note The field type is resolved once per range, every loop runs over
+ *       the coordinate planes with integer arithmetic only.
+ *
+ * @param map The address of the mapping.
+ * @param field Pointer to the field descriptor.
+ * @param start First LED of the range.
+ * @param count Number of LEDs in the range.
+ * @param out Field values.
+ */
+static void hd108_map3d_eval_range(const hd108_map3d_t *map, const hd108_map3d_field_t *field, uint16_t start, uint16_t count, uint16_t *out) {
+    const int16_t *x = &map->x[start];
+    const int16_t *y = &map->y[start];
+    const int16_t *z = &map->z[start];
+    uint16_t width = (0 == field->width) ? 1 : field->width;
+    uint32_t inv_width = ((uint32_t)UINT16_MAX << 15) / width;
+
+    switch (field->type) {
+        case HD108_MAP3D_PLANE:
+            for (uint16_t i = 0; i < count; i++) {
+                // three Q30 products overflow 32 bits, e.g. a diagonal normal at a corner
+                int32_t dot = (int32_t)(((int64_t)field->x * x[i] + (int64_t)field->y * y[i] + (int64_t)field->z * z[i]) >> 15);
+                int32_t distance = dot - field->distance;
+                out[i] = hd108_map3d_falloff((distance < 0) ? -distance : distance, width, inv_width);
+            }
+            break;
+        case HD108_MAP3D_SPHERE:
+            for (uint16_t i = 0; i < count; i++) {
+                // Q14 keeps the sum of squares in 32 bits
+                int32_t dx = ((int32_t)x[i] - field->x) >> 1;
+                int32_t dy = ((int32_t)y[i] - field->y) >> 1;
+                int32_t dz = ((int32_t)z[i] - field->z) >> 1;
+                int32_t radius = (int32_t)(hd108_map3d_isqrt((uint32_t)(dx * dx) + (uint32_t)(dy * dy) + (uint32_t)(dz * dz)) << 1);
+                int32_t distance = radius - field->distance;
+                out[i] = hd108_map3d_falloff((distance < 0) ? -distance : distance, width, inv_width);
+            }
+            break;
+        case HD108_MAP3D_NOISE:
+        default: {
+            uint32_t ox = (uint32_t)(int32_t)field->x << 8;
+            uint32_t oy = (uint32_t)(int32_t)field->y << 8;
+            uint32_t oz = (uint32_t)(int32_t)field->z << 8;
+            for (uint16_t i = 0; i < count; i++) {
+                // the bounding box is mapped to [0 .. 1) and scaled to width cells
+                uint32_t nx = (((uint32_t)(x[i] + 32768) * width) >> 8) + ox;
+                uint32_t ny = (((uint32_t)(y[i] + 32768) * width) >> 8) + oy;
+                uint32_t nz = (((uint32_t)(z[i] + 32768) * width) >> 8) + oz;
+                out[i] = hd108_noise16_3d(nx, ny, nz);
+            }
+            break;
+        }
+    }
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_map3d_init(const hd108_map3d_configuration_t *map3d_configuration, void **map_out) {
+    const hd108_map3d_header_t *header = (const hd108_map3d_header_t *)map3d_configuration->blob;
+
+    // check context and blob
+    if ((NULL == map3d_configuration->ctx) || (NULL == header) || (sizeof(hd108_map3d_header_t) > map3d_configuration->blob_len)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_MAP3D_MAGIC != header->magic) || (HD108_MAP3D_VERSION != header->version)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_LLD_MIN_COUNT > header->count) || (HD108_LLD_MAX_COUNT < (uint32_t)header->count + map3d_configuration->first)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+    if (sizeof(hd108_map3d_header_t) + 3 * sizeof(int16_t) * header->count > map3d_configuration->blob_len) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for mapping
+    hd108_map3d_t *map = (hd108_map3d_t *)calloc(1, sizeof(hd108_map3d_t));
+    if (!map) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    const int16_t *planes = (const int16_t *)(header + 1);
+    map->ctx = map3d_configuration->ctx;
+    map->first = map3d_configuration->first;
+    map->count = header->count;
+    map->x = &planes[0];
+    map->y = &planes[header->count];
+    map->z = &planes[2 * header->count];
+
+    // set out parameter
+    *map_out = map;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_map3d_init_partition(void *ctx_in, uint16_t first, const char *partition_label, void **map_out) {
+    const void *blob;
+    esp_partition_mmap_handle_t handle;
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (NULL == partition) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    if (ESP_OK != esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &blob, &handle)) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    hd108_map3d_configuration_t map3d_configuration = {
+        .ctx = ctx_in,
+        .first = first,
+        .blob = blob,
+        .blob_len = partition->size
+    };
+
+    hd108_status_t status = hd108_map3d_init(&map3d_configuration, map_out);
+    if (HD108_LLD_OK != status) {
+        esp_partition_munmap(handle);
+        return status;
+    }
+
+    ((hd108_map3d_t *)*map_out)->mmap = handle;
+    ((hd108_map3d_t *)*map_out)->mapped = true;
+
+    return HD108_LLD_OK;
+}
+
+void hd108_map3d_eval(void *map_in, const hd108_map3d_field_t *field, uint16_t *values_out) {
+    // cast mapping
+    hd108_map3d_t *map = map_in;
+
+    hd108_map3d_eval_range(map, field, 0, map->count, values_out);
+}
+
+hd108_status_t hd108_map3d_render(void *map_in, const hd108_map3d_field_t *field, const hd108_color_t color[3], uint16_t current) {
+    // cast mapping
+    hd108_map3d_t *map = map_in;
+    uint16_t values[HD108_MAP3D_BATCH];
+    uint16_t pixels[3 * HD108_MAP3D_BATCH];
+    hd108_status_t status = HD108_LLD_OK;
+
+    for (uint16_t start = 0; (start < map->count) && (HD108_LLD_OK == status); start += HD108_MAP3D_BATCH) {
+        uint16_t count = map->count - start;
+        if (HD108_MAP3D_BATCH < count) {
+            count = HD108_MAP3D_BATCH;
+        }
+
+        hd108_map3d_eval_range(map, field, start, count, values);
+        for (uint16_t i = 0; i < count; i++) {
+            pixels[3 * i + 0] = hd108_color_scale16(color[0], values[i]);
+            pixels[3 * i + 1] = hd108_color_scale16(color[1], values[i]);
+            pixels[3 * i + 2] = hd108_color_scale16(color[2], values[i]);
+        }
+        status = hd108_lld_write_rgb48(map->ctx, map->first + start, count, pixels, current);
+    }
+
+    return status;
+}
+
+void hd108_map3d_deinit(void *map_in) {
+    // cast mapping
+    hd108_map3d_t *map = map_in;
+
+    if (map->mapped) {
+        esp_partition_munmap(map->mmap);
+    }
+    free(map);
+}
@@ -0,0 +1,142 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#if defined(ESP_PLATFORM)
+#include "esp_rom_sys.h"
+#endif
+#include "HD108_prof.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#if defined(ESP_PLATFORM)
+#define HD108_PROF_CYCLES_PER_US    (esp_rom_get_cpu_ticks_per_us())    ///< CPU cycles per microsecond
+#else
+#define HD108_PROF_CYCLES_PER_US    (1000UL)                            ///< nanoseconds per microsecond
+#endif
+
+
+/******************************************************************************
+ * Constants
+ *****************************************************************************/
+/**
+ * @brief Names of the stages of the driver.
+ */
+static const char *const hd108_prof_stage_names[HD108_PROF_STAGE_COUNT] = {
+    [HD108_PROF_STAGE_TRANSFER] = "transfer",
+    [HD108_PROF_STAGE_UPDATE] = "update",
+    [HD108_PROF_STAGE_ENCODE] = "encode"
+};
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_prof_init(hd108_prof_t **prof_out) {
+    // allocate memory for profiler
+    hd108_prof_t *prof = (hd108_prof_t *)calloc(1, sizeof(hd108_prof_t));
+    if (!prof) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    for (uint8_t stage = 0; stage < HD108_PROF_STAGE_COUNT; stage++) {
+        prof->name[stage] = hd108_prof_stage_names[stage];
+    }
+    prof->count = HD108_PROF_STAGE_COUNT;
+    prof->frame_start = hd108_prof_now();
+
+    // set out parameter
+    *prof_out = prof;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_prof_scope(hd108_prof_t *prof, const char *name, uint8_t *scope_out) {
+    if (HD108_PROF_MAX_SCOPES <= prof->count) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    prof->name[prof->count] = name;
+    *scope_out = prof->count++;
+
+    return HD108_LLD_OK;
+}
+
+void hd108_prof_frame(hd108_prof_t *prof) {
+    uint32_t now = hd108_prof_now();
+
+    for (uint8_t scope = 0; scope < prof->count; scope++) {
+        uint32_t cycles = prof->frame[scope];
+        prof->last[scope] = cycles;
+        prof->total[scope] += cycles;
+        if (cycles > prof->max[scope]) {
+            prof->max[scope] = cycles;
+        }
+        prof->frame[scope] = 0;
+    }
+
+    prof->period_total += now - prof->frame_start;
+    prof->frame_start = now;
+    prof->frames++;
+}
+
+hd108_status_t hd108_prof_get_stats(const hd108_prof_t *prof, uint8_t scope, hd108_prof_stats_t *stats_out) {
+    uint32_t cycles_per_us = HD108_PROF_CYCLES_PER_US;
+
+    if (scope >= prof->count) {
+        return HD108_LLD_ERROR_INDEX;
+    }
+
+    stats_out->name = prof->name[scope];
+    stats_out->last_us = prof->last[scope] / cycles_per_us;
+    stats_out->max_us = prof->max[scope] / cycles_per_us;
+    stats_out->avg_us = (0 == prof->frames) ? 0 : (uint32_t)(prof->total[scope] / prof->frames / cycles_per_us);
+    stats_out->share_ppm = (0 == prof->period_total) ? 0 : (uint32_t)((prof->total[scope] * 1000000ULL) / prof->period_total);
+
+    return HD108_LLD_OK;
+}
+
+void hd108_prof_print(const hd108_prof_t *prof) {
+    hd108_prof_stats_t stats;
+
+    printf("%-16s %10s %10s %10s %8s\n", "scope", "last us", "avg us", "max us", "frame %");
+    for (uint8_t scope = 0; scope < prof->count; scope++) {
+        (void)hd108_prof_get_stats(prof, scope, &stats);
+        printf("%-16s %10lu %10lu %10lu %5lu.%02lu\n", stats.name, (unsigned long)stats.last_us, (unsigned long)stats.avg_us,
+               (unsigned long)stats.max_us, (unsigned long)(stats.share_ppm / 10000), (unsigned long)(stats.share_ppm / 100 % 100));
+    }
+}
@@ -0,0 +1,305 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+
+
+#include "HD108_sampler.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_SAMPLER_BATCH         (      32UL)    ///< number of LEDs written per batch
+
+
+/******************************************************************************
+ * Macros
+ *****************************************************************************/
+/**
+ * @brief RGB565 channels expanded to 16-bit by bit replication.
+ */
+#define HD108_SAMPLER_E5(v)         ((((v) << 11) | ((v) << 6) | ((v) << 1) | ((v) >> 4)) & 0xffffU)
+#define HD108_SAMPLER_E6(v)         ((((v) << 10) | ((v) << 4) | ((v) >> 2)) & 0xffffU)
+#define HD108_SAMPLER_R(p)          HD108_SAMPLER_E5((p) >> 11)
+#define HD108_SAMPLER_G(p)          HD108_SAMPLER_E6(((p) >> 5) & 0x3fU)
+#define HD108_SAMPLER_B(p)          HD108_SAMPLER_E5((p) & 0x1fU)
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Sample table entry of one LED.
+ */
+typedef struct {
+    uint32_t    offset;             ///< Index of the top-left source pixel
+    uint16_t    wx;                 ///< Weight of the right column, Q8 [0 .. 256)
+    uint16_t    wy;                 ///< Weight of the bottom row, Q8 [0 .. 256)
+} hd108_sampler_entry_t;
+
+
+/**
+ * @brief Sampler variable to store the sample table.
+ */
+typedef struct {
+    void                       *ctx;            ///< The address of the driver context
+    uint16_t                    first;          ///< Index of the LED of the first sample
+    uint16_t                    count;          ///< Number of LEDs
+    uint16_t                    image_width;    ///< Width of the source image, the row stride
+    hd108_sampler_format_t      format;         ///< Format of the source image
+    hd108_sampler_entry_t      *table;          ///< Sample table, count entries
+} hd108_sampler_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static inline uint16_t  hd108_sampler_blend     (uint32_t c00, uint32_t c01, uint32_t c10, uint32_t c11, uint32_t wx, uint32_t wy);
+static inline void      hd108_sampler_rgb565    (const hd108_sampler_t *sampler, const uint16_t *image, uint16_t index, uint16_t *rgb);
+static inline void      hd108_sampler_rgb888    (const hd108_sampler_t *sampler, const uint8_t *image, uint16_t index, uint16_t *rgb);
+static void             hd108_sampler_encode    (const hd108_sampler_t *sampler, const void *image, uint16_t current, volatile uint32_t *frame);
+static hd108_status_t   hd108_sampler_batches   (const hd108_sampler_t *sampler, const void *image, uint16_t current);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Bilinear blend of one channel.
+ *
+ * @note The rows are blended first and scaled back to 16-bit, so every
+ *       intermediate stays in 32 bits.
+ *
+ * @param c00 Top-left value, 16-bit.
+ * @param c01 Top-right value, 16-bit.
+ * @param c10 Bottom-left value, 16-bit.
+ * @param c11 Bottom-right value, 16-bit.
+ * @param wx Weight of the right column, Q8.
+ * @param wy Weight of the bottom row, Q8.
+ *
+ * @return
+ *         - The blended value, 16-bit.
+ */
+static inline uint16_t hd108_sampler_blend(uint32_t c00, uint32_t c01, uint32_t c10, uint32_t c11, uint32_t wx, uint32_t wy) {
+    uint32_t top = (c00 * (256 - wx) + c01 * wx) >> 8;
+    uint32_t bottom = (c10 * (256 - wx) + c11 * wx) >> 8;
+    return (uint16_t)((top * (256 - wy) + bottom * wy) >> 8);
+}
+
+
+/**
+ * @brief Gather the sample of one LED from an RGB565 image.
+ *
+ * @param sampler The address of the sampler.
+ * @param image Source image.
+ * @param index Index of the LED in the sample table.
+ * @param rgb RGB48 sample.
+ */
+static inline void hd108_sampler_rgb565(const hd108_sampler_t *sampler, const uint16_t *image, uint16_t index, uint16_t *rgb) {
+    const hd108_sampler_entry_t *entry = &sampler->table[index];
+    const uint16_t *top = &image[entry->offset];
+    const uint16_t *bottom = top + sampler->image_width;
+    uint32_t p00 = top[0], p01 = top[1], p10 = bottom[0], p11 = bottom[1];
+
+    rgb[0] = hd108_sampler_blend(HD108_SAMPLER_R(p00), HD108_SAMPLER_R(p01), HD108_SAMPLER_R(p10), HD108_SAMPLER_R(p11), entry->wx, entry->wy);
+    rgb[1] = hd108_sampler_blend(HD108_SAMPLER_G(p00), HD108_SAMPLER_G(p01), HD108_SAMPLER_G(p10), HD108_SAMPLER_G(p11), entry->wx, entry->wy);
+    rgb[2] = hd108_sampler_blend(HD108_SAMPLER_B(p00), HD108_SAMPLER_B(p01), HD108_SAMPLER_B(p10), HD108_SAMPLER_B(p11), entry->wx, entry->wy);
+}
+
+
+/**
+ * @brief Gather the sample of one LED from an RGB888 image.
+ *
+ * @param sampler The address of the sampler.
+ * @param image Source image.
+ * @param index Index of the LED in the sample table.
+ * @param rgb RGB48 sample.
+ */
+static inline void hd108_sampler_rgb888(const hd108_sampler_t *sampler, const uint8_t *image, uint16_t index, uint16_t *rgb) {
+    const hd108_sampler_entry_t *entry = &sampler->table[index];
+    const uint8_t *top = &image[3 * entry->offset];
+    const uint8_t *bottom = top + 3UL * sampler->image_width;
+
+    for (uint8_t c = 0; c < 3; c++) {
+        rgb[c] = hd108_sampler_blend(top[c] * 0x0101U, top[c + 3] * 0x0101U, bottom[c] * 0x0101U, bottom[c + 3] * 0x0101U, entry->wx, entry->wy);
+    }
+}
+
+
+/**
+ * @brief Sample every LED straight into the TX buffer.
+ *
+ * @note The format is resolved once, each sample is encoded in wire format
+ *       as soon as it is blended.
+ *
+ * @param sampler The address of the sampler.
+ * @param image Source image.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ * @param frame LEDs of the sampler in the TX buffer, see hd108_lld_open_frame.
+ */
+static void hd108_sampler_encode(const hd108_sampler_t *sampler, const void *image, uint16_t current, volatile uint32_t *frame) {
+    uint32_t wire_current = HD108_LLD_WIRE_CURRENT(current);
+    uint16_t rgb[3];
+
+    if (HD108_SAMPLER_RGB565 == sampler->format) {
+        for (uint16_t i = 0; i < sampler->count; i++) {
+            hd108_sampler_rgb565(sampler, (const uint16_t *)image, i, rgb);
+            hd108_lld_encode_pixel(wire_current, rgb[0], rgb[1], rgb[2], &frame[2 * i]);
+        }
+    } else {
+        for (uint16_t i = 0; i < sampler->count; i++) {
+            hd108_sampler_rgb888(sampler, (const uint8_t *)image, i, rgb);
+            hd108_lld_encode_pixel(wire_current, rgb[0], rgb[1], rgb[2], &frame[2 * i]);
+        }
+    }
+}
+
+
+/**
+ * @brief Sample every LED in batches written with the RGB48 bulk write.
+ *
+ * @note Used when the TX buffer is built after the update function, e.g.
+ *       with frame-rate upconversion or the planar layout.
+ *
+ * @param sampler The address of the sampler.
+ * @param image Source image.
+ * @param current Current levels for every pixel, see HD108_LLD_CURRENT.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the LEDs are out of the strip
+ */
+static hd108_status_t hd108_sampler_batches(const hd108_sampler_t *sampler, const void *image, uint16_t current) {
+    uint16_t pixels[3 * HD108_SAMPLER_BATCH];
+    hd108_status_t status = HD108_LLD_OK;
+
+    for (uint16_t start = 0; (start < sampler->count) && (HD108_LLD_OK == status); start += HD108_SAMPLER_BATCH) {
+        uint16_t count = sampler->count - start;
+        if (HD108_SAMPLER_BATCH < count) {
+            count = HD108_SAMPLER_BATCH;
+        }
+
+        for (uint16_t i = 0; i < count; i++) {
+            if (HD108_SAMPLER_RGB565 == sampler->format) {
+                hd108_sampler_rgb565(sampler, (const uint16_t *)image, start + i, &pixels[3 * i]);
+            } else {
+                hd108_sampler_rgb888(sampler, (const uint8_t *)image, start + i, &pixels[3 * i]);
+            }
+        }
+        status = hd108_lld_write_rgb48(sampler->ctx, sampler->first + start, count, pixels, current);
+    }
+
+    return status;
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_sampler_init(const hd108_sampler_configuration_t *sampler_configuration, void **sampler_out) {
+    // check number of LEDs
+    if ((HD108_LLD_MIN_COUNT > sampler_configuration->count) ||
+        (HD108_LLD_MAX_COUNT < (uint32_t)sampler_configuration->count + sampler_configuration->first)) {
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // check context, image and positions
+    if ((NULL == sampler_configuration->ctx) || (NULL == sampler_configuration->u) || (NULL == sampler_configuration->v)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((2 > sampler_configuration->image_width) || (2 > sampler_configuration->image_height)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_SAMPLER_RGB565 != sampler_configuration->format) && (HD108_SAMPLER_RGB888 != sampler_configuration->format)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for sampler and sample table
+    hd108_sampler_t *sampler = (hd108_sampler_t *)calloc(1, sizeof(hd108_sampler_t));
+    if (!sampler) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+    sampler->table = (hd108_sampler_entry_t *)malloc(sampler_configuration->count * sizeof(hd108_sampler_entry_t));
+    if (!sampler->table) {
+        free(sampler);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // the right and bottom neighbours shall be in the image
+    uint32_t max_u = ((uint32_t)(sampler_configuration->image_width - 1) << 16) - 1;
+    uint32_t max_v = ((uint32_t)(sampler_configuration->image_height - 1) << 16) - 1;
+    for (uint16_t i = 0; i < sampler_configuration->count; i++) {
+        uint32_t u = (sampler_configuration->u[i] > max_u) ? max_u : sampler_configuration->u[i];
+        uint32_t v = (sampler_configuration->v[i] > max_v) ? max_v : sampler_configuration->v[i];
+        sampler->table[i].offset = (v >> 16) * sampler_configuration->image_width + (u >> 16);
+        sampler->table[i].wx = (u >> 8) & 0xffU;
+        sampler->table[i].wy = (v >> 8) & 0xffU;
+    }
+
+    sampler->ctx = sampler_configuration->ctx;
+    sampler->first = sampler_configuration->first;
+    sampler->count = sampler_configuration->count;
+    sampler->image_width = sampler_configuration->image_width;
+    sampler->format = sampler_configuration->format;
+
+    // set out parameter
+    *sampler_out = sampler;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_sampler_render(void *sampler_in, const void *image, uint16_t current) {
+    // cast sampler
+    hd108_sampler_t *sampler = sampler_in;
+    uint32_t *frame;
+
+    hd108_status_t status = hd108_lld_open_frame(sampler->ctx, sampler->first, sampler->count, &frame);
+    if (HD108_LLD_ERROR_INVALID == status) {
+        return hd108_sampler_batches(sampler, image, current);
+    }
+    if (HD108_LLD_OK != status) {
+        return status;
+    }
+
+    hd108_sampler_encode(sampler, image, current, frame);
+
+    return hd108_lld_close_frame(sampler->ctx, sampler->first, sampler->count);
+}
+
+void hd108_sampler_deinit(void *sampler_in) {
+    // cast sampler
+    hd108_sampler_t *sampler = sampler_in;
+
+    free(sampler->table);
+    free(sampler);
+}
@@ -0,0 +1,526 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "HD108_sched.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_SCHED_TASK_STACK      (    4096UL)    ///< stack size of the scheduler task, it runs the update functions
+#define HD108_SCHED_COST_SHIFT      (       3UL)    ///< smoothing of the cost measurement (1/8)
+#define HD108_SCHED_RESTORE_PPM     (   50000UL)    ///< rates are restored only below budget minus this utilization
+#define HD108_SCHED_RATE_WINDOW     ( 1000000LL)    ///< window of the rate measurement in microseconds
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Scheduled context.
+ */
+typedef struct {
+    void               *ctx;            ///< The address of the context
+    uint32_t            period;         ///< Nominal period in microseconds
+    uint8_t             priority;       ///< Priority, higher is more important
+    uint8_t             divider;        ///< Rate reduction [1 .. HD108_SCHED_MAX_DIVIDER]
+    int64_t             release;        ///< Release time of the next update
+    int64_t             deadline;       ///< Deadline of the next update
+    uint32_t            cost;           ///< Smoothed cost of one update in microseconds
+    uint32_t            updates;        ///< Number of updates
+    uint32_t            missed;         ///< Number of dropped updates
+    int64_t             window_start;   ///< Start of the rate measurement window
+    uint32_t            window_updates; ///< Updates in the rate measurement window
+    uint32_t            rate_mhz;       ///< Achieved rate of the last window
+} hd108_sched_entry_t;
+
+
+/**
+ * @brief Load of a scheduled context, snapshot for the rebalance.
+ */
+typedef struct {
+    uint32_t            period;         ///< Nominal period in microseconds
+    uint32_t            cost;           ///< Smoothed cost of one update in microseconds
+    uint8_t             priority;       ///< Priority, higher is more important
+    uint8_t             divider;        ///< Rate reduction [1 .. HD108_SCHED_MAX_DIVIDER]
+} hd108_sched_load_t;
+
+
+/**
+ * @brief Scheduler variable.
+ *
+ * @note The task holds update_lock from picking an update until its
+ *       accounting is done, entries are removed only under update_lock.
+ */
+typedef struct {
+    portMUX_TYPE        lock;           ///< Protects the entries
+    hd108_sched_entry_t entries[HD108_SCHED_MAX_CONTEXTS];  ///< Scheduled contexts
+    uint8_t             count;          ///< Number of scheduled contexts
+    uint32_t            budget;         ///< Utilization budget in ppm
+    esp_timer_handle_t  wakeup;         ///< One-shot timer to wake the task at the next release
+    esp_timer_handle_t  fence;          ///< One-shot timer that runs after a wake-up callback in flight
+    SemaphoreHandle_t   wake;           ///< Wakes the task at a release or when a context is added
+    SemaphoreHandle_t   update_lock;    ///< Held by the task while it runs an update
+    SemaphoreHandle_t   done;           ///< Given when the task has stopped and by the fence
+    volatile bool       stop;           ///< Request to stop the task
+} hd108_sched_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static uint32_t     hd108_sched_utilization (const hd108_sched_load_t *load, uint8_t divider);
+static void         hd108_sched_rebalance   (hd108_sched_load_t *loads, uint8_t count, uint32_t budget);
+static int          hd108_sched_find        (hd108_sched_t *sched, const void *ctx);
+static int          hd108_sched_pick        (hd108_sched_t *sched, int64_t now, int64_t *next_release);
+static void         hd108_sched_wakeup      (void *arg);
+static void         hd108_sched_fence       (void *arg);
+static void         hd108_sched_task        (void *arg);
+static void         hd108_sched_free        (hd108_sched_t *sched);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Utilization of a context at a rate reduction.
+ *
+ * @param load The load of the scheduled context.
+ * @param divider Rate reduction.
+ *
+ * @return
+ *         - Share of the CPU in ppm.
+ */
+static uint32_t hd108_sched_utilization(const hd108_sched_load_t *load, uint8_t divider) {
+    return (uint32_t)(((uint64_t)load->cost * 1000000UL) / ((uint64_t)load->period * divider));
+}
+
+
+/**
+ * @brief Distribute the budget among the contexts.
+ *
+ * @note Contexts are served from the highest priority down, each one gets
+ *       the lowest rate reduction that still fits into the remaining budget.
+ *       The contexts of the highest priority always run at their nominal
+ *       rate. A rate is restored only with some headroom, so a context does
+ *       not toggle between two rates while the load is at the budget.
+ *       It works on a snapshot of the entries, outside the critical section.
+ *
+ * @param loads The loads of the scheduled contexts, their dividers are updated.
+ * @param count Number of loads.
+ * @param budget Utilization budget in ppm.
+ */
+static void hd108_sched_rebalance(hd108_sched_load_t *loads, uint8_t count, uint32_t budget) {
+    uint8_t order[HD108_SCHED_MAX_CONTEXTS];
+    uint32_t used = 0;
+
+    // insertion sort by priority, descending, stable
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t j = i;
+        while ((j > 0) && (loads[order[j - 1]].priority < loads[i].priority)) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    // restoring a rate needs headroom
+    uint32_t restore = (budget > HD108_SCHED_RESTORE_PPM) ? budget - HD108_SCHED_RESTORE_PPM : 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        hd108_sched_load_t *load = &loads[order[i]];
+        uint8_t divider = 1;
+
+        if (load->priority != loads[order[0]].priority) {
+            while (divider < HD108_SCHED_MAX_DIVIDER) {
+                uint32_t limit = (divider < load->divider) ? restore : budget;
+                if (used + hd108_sched_utilization(load, divider) <= limit) {
+                    break;
+                }
+                divider++;
+            }
+        }
+
+        load->divider = divider;
+        used += hd108_sched_utilization(load, divider);
+    }
+}
+
+
+/**
+ * @brief Find the entry of a context.
+ *
+ * @note It shall be called in the critical section.
+ *
+ * @param sched The address of the scheduler.
+ * @param ctx The address of the context.
+ *
+ * @return
+ *         - Index of the entry, or -1 if the context has not been added.
+ */
+static int hd108_sched_find(hd108_sched_t *sched, const void *ctx) {
+    for (uint8_t i = 0; i < sched->count; i++) {
+        if (sched->entries[i].ctx == ctx) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/**
+ * @brief Pick the next update.
+ *
+ * @note Among the released updates the one with the earliest deadline wins,
+ *       on equal deadlines the higher priority. Updates whose deadline has
+ *       passed are dropped and released again in the next period.
+ *
+ * @param sched The address of the scheduler.
+ * @param now Current time.
+ * @param next_release Out parameter for the earliest release, if nothing is released.
+ *
+ * @return
+ *         - Index of the entry, or -1 if no update is released.
+ */
+static int hd108_sched_pick(hd108_sched_t *sched, int64_t now, int64_t *next_release) {
+    int best = -1;
+
+    *next_release = INT64_MAX;
+
+    for (uint8_t i = 0; i < sched->count; i++) {
+        hd108_sched_entry_t *entry = &sched->entries[i];
+        int64_t period = (int64_t)entry->period * entry->divider;
+
+        if (entry->deadline <= now) {
+            // too late, skip to the period that contains now
+            entry->missed++;
+            entry->release += period * ((now - entry->release) / period);
+            entry->deadline = entry->release + period;
+        }
+
+        if (entry->release > now) {
+            if (entry->release < *next_release) {
+                *next_release = entry->release;
+            }
+            continue;
+        }
+
+        if ((-1 == best) || (entry->deadline < sched->entries[best].deadline) ||
+            ((entry->deadline == sched->entries[best].deadline) && (entry->priority > sched->entries[best].priority))) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+
+/**
+ * @brief Wake-up timer callback.
+ *
+ * @param arg The address of the scheduler.
+ */
+static void hd108_sched_wakeup(void *arg) {
+    hd108_sched_t *sched = arg;
+    xSemaphoreGive(sched->wake);
+}
+
+
+/**
+ * @brief Fence timer callback.
+ *
+ * @note The esp_timer task runs the callbacks one after the other, so when
+ *       the fence runs, a wake-up callback that was in flight has returned.
+ *
+ * @param arg The address of the scheduler.
+ */
+static void hd108_sched_fence(void *arg) {
+    hd108_sched_t *sched = arg;
+    xSemaphoreGive(sched->done);
+}
+
+
+/**
+ * @brief Scheduler task.
+ *
+ * @param arg The address of the scheduler.
+ */
+static void hd108_sched_task(void *arg) {
+    hd108_sched_t *sched = arg;
+    hd108_sched_load_t loads[HD108_SCHED_MAX_CONTEXTS];
+    int64_t next_release;
+
+    while (!sched->stop) {
+        (void)xSemaphoreTake(sched->update_lock, portMAX_DELAY);
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&sched->lock);
+        int index = hd108_sched_pick(sched, now, &next_release);
+        void *ctx = (-1 == index) ? NULL : sched->entries[index].ctx;
+        portEXIT_CRITICAL(&sched->lock);
+
+        if (-1 == index) {
+            xSemaphoreGive(sched->update_lock);
+            // sleep until the next release or until a context is added
+            if (INT64_MAX != next_release) {
+                (void)esp_timer_start_once(sched->wakeup, next_release - now);
+            }
+            (void)xSemaphoreTake(sched->wake, portMAX_DELAY);
+            (void)esp_timer_stop(sched->wakeup);
+            continue;
+        }
+
+        (void)hd108_lld_update(ctx);
+        int64_t end = esp_timer_get_time();
+        uint32_t cost = (uint32_t)(end - now);
+
+        // account the update and take a snapshot of the loads
+        portENTER_CRITICAL(&sched->lock);
+        hd108_sched_entry_t *entry = &sched->entries[index];
+        entry->cost = (0 == entry->updates) ? cost : entry->cost + (((int32_t)cost - (int32_t)entry->cost) >> HD108_SCHED_COST_SHIFT);
+        entry->updates++;
+        entry->window_updates++;
+        if (end - entry->window_start >= HD108_SCHED_RATE_WINDOW) {
+            entry->rate_mhz = (uint32_t)(((uint64_t)entry->window_updates * 1000000000ULL) / (uint64_t)(end - entry->window_start));
+            entry->window_start = end;
+            entry->window_updates = 0;
+        }
+        uint8_t count = sched->count;
+        for (uint8_t i = 0; i < count; i++) {
+            loads[i].period = sched->entries[i].period;
+            loads[i].cost = sched->entries[i].cost;
+            loads[i].priority = sched->entries[i].priority;
+            loads[i].divider = sched->entries[i].divider;
+        }
+        portEXIT_CRITICAL(&sched->lock);
+
+        hd108_sched_rebalance(loads, count, sched->budget);
+
+        // entries do not move while update_lock is held,
+        // contexts added meanwhile are rebalanced after the next update
+        portENTER_CRITICAL(&sched->lock);
+        for (uint8_t i = 0; i < count; i++) {
+            sched->entries[i].divider = loads[i].divider;
+        }
+        entry->release += (int64_t)entry->period * entry->divider;
+        entry->deadline = entry->release + (int64_t)entry->period * entry->divider;
+        portEXIT_CRITICAL(&sched->lock);
+
+        xSemaphoreGive(sched->update_lock);
+    }
+
+    xSemaphoreGive(sched->done);
+    vTaskDelete(NULL);
+}
+
+
+/**
+ * @brief Release the scheduler and its resources.
+ *
+ * @param sched The address of the scheduler.
+ */
+static void hd108_sched_free(hd108_sched_t *sched) {
+    if (sched->fence) {
+        (void)esp_timer_delete(sched->fence);
+    }
+    if (sched->wakeup) {
+        (void)esp_timer_delete(sched->wakeup);
+    }
+    if (sched->wake) {
+        vSemaphoreDelete(sched->wake);
+    }
+    if (sched->done) {
+        vSemaphoreDelete(sched->done);
+    }
+    if (sched->update_lock) {
+        vSemaphoreDelete(sched->update_lock);
+    }
+    free(sched);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_sched_init(const hd108_sched_configuration_t *sched_configuration, void **sched_out) {
+    // check budget
+    if ((0 == sched_configuration->budget_percent) || (100 < sched_configuration->budget_percent)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for scheduler
+    hd108_sched_t *sched = (hd108_sched_t *)calloc(1, sizeof(hd108_sched_t));
+    if (!sched) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    sched->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    sched->budget = sched_configuration->budget_percent * 10000UL;
+
+    const esp_timer_create_args_t wakeup_args = {
+        .arg = sched,
+        .callback = &hd108_sched_wakeup,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = NULL,
+        .skip_unhandled_events = true
+    };
+    const esp_timer_create_args_t fence_args = {
+        .arg = sched,
+        .callback = &hd108_sched_fence,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = NULL,
+        .skip_unhandled_events = true
+    };
+    sched->wake = xSemaphoreCreateBinary();
+    sched->update_lock = xSemaphoreCreateMutex();
+    sched->done = xSemaphoreCreateBinary();
+    if (!sched->wake || !sched->update_lock || !sched->done ||
+        (ESP_OK != esp_timer_create(&wakeup_args, &sched->wakeup)) || (ESP_OK != esp_timer_create(&fence_args, &sched->fence))) {
+        hd108_sched_free(sched);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // the dedicated GPIO bundles of the contexts belong to the core of the init
+    if (pdPASS != xTaskCreatePinnedToCore(hd108_sched_task, "hd108_sched", HD108_SCHED_TASK_STACK, sched,
+                                          sched_configuration->task_priority, NULL, xPortGetCoreID())) {
+        hd108_sched_free(sched);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // set out parameter
+    *sched_out = sched;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_sched_add(void *sched_in, void *ctx_in, hd108_update_frequency_hz_t frequency_hz, uint8_t priority) {
+    // cast scheduler
+    hd108_sched_t *sched = sched_in;
+    hd108_status_t status = HD108_LLD_ERROR_INVALID;
+
+    if ((NULL == ctx_in) || (0 == frequency_hz)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&sched->lock);
+    if ((HD108_SCHED_MAX_CONTEXTS > sched->count) && (-1 == hd108_sched_find(sched, ctx_in))) {
+        hd108_sched_entry_t *entry = &sched->entries[sched->count];
+        memset(entry, 0, sizeof(*entry));
+        entry->ctx = ctx_in;
+        entry->period = 1000000UL / frequency_hz;
+        entry->priority = priority;
+        entry->divider = 1;
+        entry->release = now;
+        entry->deadline = now + entry->period;
+        entry->window_start = now;
+        sched->count++;
+        status = HD108_LLD_OK;
+    }
+    portEXIT_CRITICAL(&sched->lock);
+
+    if (HD108_LLD_OK == status) {
+        xSemaphoreGive(sched->wake);
+    }
+
+    return status;
+}
+
+hd108_status_t hd108_sched_remove(void *sched_in, void *ctx_in) {
+    // cast scheduler
+    hd108_sched_t *sched = sched_in;
+
+    // wait out the update in flight
+    (void)xSemaphoreTake(sched->update_lock, portMAX_DELAY);
+
+    portENTER_CRITICAL(&sched->lock);
+    int index = hd108_sched_find(sched, ctx_in);
+    if (-1 != index) {
+        sched->count--;
+        memmove(&sched->entries[index], &sched->entries[index + 1], (sched->count - index) * sizeof(hd108_sched_entry_t));
+    }
+    portEXIT_CRITICAL(&sched->lock);
+
+    xSemaphoreGive(sched->update_lock);
+
+    return (-1 == index) ? HD108_LLD_ERROR_INVALID : HD108_LLD_OK;
+}
+
+hd108_status_t hd108_sched_get_stats(void *sched_in, void *ctx_in, hd108_sched_stats_t *stats_out) {
+    // cast scheduler
+    hd108_sched_t *sched = sched_in;
+    hd108_status_t status = HD108_LLD_ERROR_INVALID;
+
+    portENTER_CRITICAL(&sched->lock);
+    int index = hd108_sched_find(sched, ctx_in);
+    if (-1 != index) {
+        const hd108_sched_entry_t *entry = &sched->entries[index];
+        stats_out->period_us = entry->period;
+        stats_out->priority = entry->priority;
+        stats_out->divider = entry->divider;
+        stats_out->cost_us = entry->cost;
+        stats_out->rate_mhz = entry->rate_mhz;
+        stats_out->updates = entry->updates;
+        stats_out->missed = entry->missed;
+        status = HD108_LLD_OK;
+    }
+    portEXIT_CRITICAL(&sched->lock);
+
+    return status;
+}
+
+void hd108_sched_deinit(void *sched_in) {
+    // cast scheduler
+    hd108_sched_t *sched = sched_in;
+
+    // the task stops after the update in flight
+    sched->stop = true;
+    xSemaphoreGive(sched->wake);
+    (void)xSemaphoreTake(sched->done, portMAX_DELAY);
+
+    // wait out a wake-up callback in flight before the timer is deleted
+    (void)esp_timer_stop(sched->wakeup);
+    (void)esp_timer_start_once(sched->fence, 0);
+    (void)xSemaphoreTake(sched->done, portMAX_DELAY);
+
+    hd108_sched_free(sched);
+}
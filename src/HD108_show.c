@@ -0,0 +1,486 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "HD108_show.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_SHOW_TASK_STACK       (    4096UL)    ///< stack size of the read-ahead task, file systems need plenty
+#define HD108_SHOW_BATCH            (      32UL)    ///< number of pixels converted in one bulk write
+#define HD108_SHOW_NO_BLOCK         (    0xffU)     ///< no block is being consumed
+
+/**
+ * @brief Longest valid RLE frame including its length, all literal packets.
+ */
+#define HD108_SHOW_RLE_MAX(count)   (4UL + 3UL * (count) + ((count) + 127UL) / 128UL)
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Show player variable.
+ *
+ * @note Blocks travel between the read-ahead task and the update function
+ *       through two queues: the task takes a free block, fills it and passes
+ *       it on, the update function consumes it and gives it back.
+ */
+typedef struct {
+    FILE               *file;           ///< Show file
+    void               *ctx;            ///< The address of the driver context
+    uint16_t            first;          ///< Index of the LED of the first pixel
+    uint16_t            count;          ///< Number of pixels in one frame
+    uint16_t            current;        ///< Current levels for every pixel
+    uint8_t             format;         ///< Frame format
+    bool                loop;           ///< Restart the show at the end of the file
+    uint32_t            frame_us;       ///< Frame time
+    uint32_t            block_size;     ///< Size of one block
+    uint8_t            *pool;           ///< Block pool, block_count x block_size bytes
+    uint32_t           *block_len;      ///< Number of valid bytes in each block
+    QueueHandle_t       free_blocks;    ///< Blocks to be filled by the read-ahead task
+    QueueHandle_t       full_blocks;    ///< Blocks to be consumed by the update function
+    SemaphoreHandle_t   done;           ///< Given by the read-ahead task when it stops
+    volatile bool       stop;           ///< Request to stop the read-ahead task
+    bool                eof;            ///< Every byte of the file has been passed on (atomic)
+    uint32_t            buffered;       ///< Number of bytes in the full blocks (atomic)
+    uint8_t             block;          ///< Block being consumed
+    uint32_t            pos;            ///< Next byte in the block being consumed
+    uint32_t            pending;        ///< Length of the next RLE frame, 0 if not read yet
+    bool                late;           ///< Underrun of the next frame has been counted
+    bool                ended;          ///< The show has ended
+    int64_t             due;            ///< Presentation time of the next frame
+    portMUX_TYPE        lock;           ///< Protects the statistics
+    hd108_show_stats_t  stats;          ///< Statistics
+} hd108_show_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static void             hd108_show_task         (void *show_in);
+static void             hd108_show_read         (hd108_show_t *show, uint8_t *dst, uint32_t len);
+static hd108_status_t   hd108_show_decode_raw   (hd108_show_t *show);
+static hd108_status_t   hd108_show_decode_rle   (hd108_show_t *show);
+static void             hd108_show_free         (hd108_show_t *show);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Read-ahead task.
+ *
+ * @note It fills free blocks from the file until the end of the file, then
+ *       it starts again after the header if the show loops. The time spent
+ *       in fread is accumulated to measure the throughput of the file system.
+ *
+ * @param show_in The address of the player.
+ */
+static void hd108_show_task(void *show_in) {
+    // cast player
+    hd108_show_t *show = show_in;
+    uint8_t block;
+    bool rewound = false;
+
+    while (pdTRUE == xQueueReceive(show->free_blocks, &block, portMAX_DELAY)) {
+        if (show->stop) {
+            break;
+        }
+        if (__atomic_load_n(&show->eof, __ATOMIC_ACQUIRE)) {
+            // nothing left to read, drop the block and wait for stop
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        size_t len = fread(&show->pool[(size_t)block * show->block_size], 1, show->block_size, show->file);
+        // a file without frames ends even if the show loops
+        bool end = (0 == len) && (!show->loop || rewound || ferror(show->file));
+        rewound = show->loop && (len < show->block_size) && !end;
+        if (rewound) {
+            // the next block starts with the first frame again
+            (void)fseek(show->file, sizeof(hd108_show_header_t), SEEK_SET);
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        portENTER_CRITICAL(&show->lock);
+        show->stats.bytes_read += len;
+        show->stats.read_time_us += elapsed;
+        portEXIT_CRITICAL(&show->lock);
+
+        if (0 != len) {
+            show->block_len[block] = len;
+            (void)xQueueSend(show->full_blocks, &block, portMAX_DELAY);
+            __atomic_add_fetch(&show->buffered, len, __ATOMIC_RELEASE);
+        } else {
+            (void)xQueueSend(show->free_blocks, &block, 0);
+        }
+
+        if (end) {
+            __atomic_store_n(&show->eof, true, __ATOMIC_RELEASE);
+        }
+    }
+
+    xSemaphoreGive(show->done);
+    vTaskDelete(NULL);
+}
+
+
+/**
+ * @brief Consume bytes from the full blocks.
+ *
+ * @note The caller has checked that enough bytes are buffered. Consumed
+ *       blocks are given back to the read-ahead task right away.
+ *
+ * @param show The address of the player.
+ * @param dst Destination.
+ * @param len Number of bytes.
+ */
+static void hd108_show_read(hd108_show_t *show, uint8_t *dst, uint32_t len) {
+    __atomic_sub_fetch(&show->buffered, len, __ATOMIC_RELAXED);
+
+    while (0 != len) {
+        if (HD108_SHOW_NO_BLOCK == show->block) {
+            (void)xQueueReceive(show->full_blocks, &show->block, 0);
+            show->pos = 0;
+        }
+
+        uint32_t chunk = show->block_len[show->block] - show->pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(dst, &show->pool[(size_t)show->block * show->block_size + show->pos], chunk);
+        dst += chunk;
+        len -= chunk;
+        show->pos += chunk;
+
+        if (show->pos == show->block_len[show->block]) {
+            (void)xQueueSend(show->free_blocks, &show->block, 0);
+            show->block = HD108_SHOW_NO_BLOCK;
+        }
+    }
+}
+
+
+/**
+ * @brief Decode a raw frame into the TX buffer.
+ *
+ * @param show The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INDEX       if the frame is out of the strip
+ */
+static hd108_status_t hd108_show_decode_raw(hd108_show_t *show) {
+    uint8_t rgb[3 * HD108_SHOW_BATCH];
+    hd108_status_t status = HD108_LLD_OK;
+
+    for (uint16_t i = 0; i < show->count; i += HD108_SHOW_BATCH) {
+        uint16_t n = show->count - i;
+        if (n > HD108_SHOW_BATCH) {
+            n = HD108_SHOW_BATCH;
+        }
+        hd108_show_read(show, rgb, 3 * n);
+        if (HD108_LLD_OK == status) {
+            status = hd108_lld_write_rgb888(show->ctx, show->first + i, n, rgb, show->current);
+        }
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Decode an RLE frame into the TX buffer.
+ *
+ * @note Every byte of the frame is consumed, even if it is corrupted, so the
+ *       next frame starts at the right position.
+ *
+ * @param show The address of the player.
+ *
+ * @return
+ *         - HD108_LLD_OK                on success
+ *         - HD108_LLD_ERROR_INVALID     if the frame is corrupted
+ *         - HD108_LLD_ERROR_INDEX       if the frame is out of the strip
+ */
+static hd108_status_t hd108_show_decode_rle(hd108_show_t *show) {
+    uint8_t rgb[3 * HD108_SHOW_BATCH];
+    hd108_status_t status = HD108_LLD_OK;
+    uint32_t left = show->pending;
+    uint16_t i = 0;
+
+    while ((0 != left) && (HD108_LLD_OK == status)) {
+        uint8_t control;
+        hd108_show_read(show, &control, 1);
+        left--;
+
+        bool run = (control >= 128);
+        uint16_t n = run ? control - 125 : control + 1;
+        uint32_t size = run ? 3 : 3UL * n;
+        if ((size > left) || (n > show->count - i)) {
+            status = HD108_LLD_ERROR_INVALID;
+            break;
+        }
+        left -= size;
+
+        if (run) {
+            hd108_show_read(show, rgb, 3);
+            for (uint16_t k = 1; k < HD108_SHOW_BATCH; k++) {
+                memcpy(&rgb[3 * k], rgb, 3);
+            }
+        }
+        while ((0 != n) && (HD108_LLD_OK == status)) {
+            uint16_t chunk = (n > HD108_SHOW_BATCH) ? HD108_SHOW_BATCH : n;
+            if (!run) {
+                hd108_show_read(show, rgb, 3 * chunk);
+            }
+            status = hd108_lld_write_rgb888(show->ctx, show->first + i, chunk, rgb, show->current);
+            i += chunk;
+            n -= chunk;
+        }
+    }
+
+    // skip the rest of a corrupted frame
+    while (0 != left) {
+        uint32_t chunk = (left > sizeof(rgb)) ? sizeof(rgb) : left;
+        hd108_show_read(show, rgb, chunk);
+        left -= chunk;
+    }
+
+    return status;
+}
+
+
+/**
+ * @brief Release the player and its resources.
+ *
+ * @param show The address of the player.
+ */
+static void hd108_show_free(hd108_show_t *show) {
+    if (show->done) {
+        vSemaphoreDelete(show->done);
+    }
+    if (show->full_blocks) {
+        vQueueDelete(show->full_blocks);
+    }
+    if (show->free_blocks) {
+        vQueueDelete(show->free_blocks);
+    }
+    free(show->block_len);
+    free(show->pool);
+    if (show->file) {
+        fclose(show->file);
+    }
+    free(show);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_show_open(const hd108_show_configuration_t *show_configuration, void **show_out) {
+    hd108_show_header_t header;
+
+    // check context, path and block pool
+    if ((NULL == show_configuration->ctx) || (NULL == show_configuration->path) || (0 == show_configuration->block_size)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_SHOW_MIN_BLOCKS > show_configuration->block_count) || (HD108_SHOW_MAX_BLOCKS < show_configuration->block_count)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for player
+    hd108_show_t *show = (hd108_show_t *)calloc(1, sizeof(hd108_show_t));
+    if (!show) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // check header
+    show->file = fopen(show_configuration->path, "rb");
+    if (!show->file || (1 != fread(&header, sizeof(header), 1, show->file)) ||
+        (HD108_SHOW_MAGIC != header.magic) || (HD108_SHOW_VERSION != header.version) ||
+        (HD108_SHOW_RLE < header.format) || (0 == header.frame_us)) {
+        hd108_show_free(show);
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if ((HD108_LLD_MIN_COUNT > header.count) || (HD108_LLD_MAX_COUNT < (uint32_t)show_configuration->first + header.count)) {
+        hd108_show_free(show);
+        return HD108_LLD_ERROR_LENGTH;
+    }
+
+    // the pool shall hold the longest frame besides the block being consumed
+    uint32_t frame_max = (HD108_SHOW_RAW == header.format) ? 3UL * header.count : HD108_SHOW_RLE_MAX(header.count);
+    if ((uint64_t)(show_configuration->block_count - 1) * show_configuration->block_size < frame_max) {
+        hd108_show_free(show);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    show->ctx = show_configuration->ctx;
+    show->first = show_configuration->first;
+    show->count = header.count;
+    show->current = show_configuration->current;
+    show->format = header.format;
+    show->loop = show_configuration->loop;
+    show->frame_us = header.frame_us;
+    show->block_size = show_configuration->block_size;
+    show->block = HD108_SHOW_NO_BLOCK;
+    show->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    show->stats.min_buffered = UINT32_MAX;
+
+    show->pool = (uint8_t *)malloc((size_t)show_configuration->block_count * show->block_size);
+    show->block_len = (uint32_t *)calloc(show_configuration->block_count, sizeof(uint32_t));
+    show->free_blocks = xQueueCreate(show_configuration->block_count + 1, sizeof(uint8_t));
+    show->full_blocks = xQueueCreate(show_configuration->block_count, sizeof(uint8_t));
+    show->done = xSemaphoreCreateBinary();
+    if (!show->pool || !show->block_len || !show->free_blocks || !show->full_blocks || !show->done) {
+        hd108_show_free(show);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    for (uint8_t block = 0; block < show_configuration->block_count; block++) {
+        (void)xQueueSend(show->free_blocks, &block, 0);
+    }
+
+    if (pdPASS != xTaskCreate(hd108_show_task, "hd108_show", HD108_SHOW_TASK_STACK, show, show_configuration->priority, NULL)) {
+        hd108_show_free(show);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    show->due = esp_timer_get_time();
+
+    // set out parameter
+    *show_out = show;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_show_update(void *show_in) {
+    // cast player
+    hd108_show_t *show = show_in;
+    hd108_status_t status;
+
+    int64_t now = esp_timer_get_time();
+    if (show->ended || (now < show->due)) {
+        return HD108_LLD_OK;
+    }
+
+    // eof first: if it is set, every block has been counted in buffered
+    bool eof = __atomic_load_n(&show->eof, __ATOMIC_ACQUIRE);
+    uint32_t buffered = __atomic_load_n(&show->buffered, __ATOMIC_ACQUIRE);
+
+    if ((HD108_SHOW_RLE == show->format) && (0 == show->pending) && (sizeof(uint32_t) <= buffered)) {
+        uint8_t len[4];
+        hd108_show_read(show, len, sizeof(len));
+        buffered -= sizeof(len);
+        show->pending = len[0] | (len[1] << 8) | ((uint32_t)len[2] << 16) | ((uint32_t)len[3] << 24);
+        if ((0 == show->pending) || (HD108_SHOW_RLE_MAX(show->count) - sizeof(len) < show->pending)) {
+            show->ended = true;
+            return HD108_LLD_ERROR_INVALID;
+        }
+    }
+
+    uint32_t needed = (HD108_SHOW_RAW == show->format) ? 3UL * show->count : show->pending;
+    if ((0 == needed) || (buffered < needed)) {
+        if (eof) {
+            show->ended = true;
+        } else if (!show->late && (0 != show->stats.frames)) {
+            // count each late frame once, it is shown as soon as it arrives,
+            // waiting for the first frame is not an underrun
+            show->late = true;
+            portENTER_CRITICAL(&show->lock);
+            show->stats.underruns++;
+            portEXIT_CRITICAL(&show->lock);
+        }
+        return HD108_LLD_OK;
+    }
+
+    if (HD108_SHOW_RAW == show->format) {
+        status = hd108_show_decode_raw(show);
+    } else {
+        status = hd108_show_decode_rle(show);
+        show->pending = 0;
+    }
+    show->late = false;
+
+    // keep the pace, but do not try to catch up after an underrun
+    show->due += show->frame_us;
+    if (show->due < now) {
+        show->due = now + show->frame_us;
+    }
+
+    buffered = __atomic_load_n(&show->buffered, __ATOMIC_RELAXED);
+    portENTER_CRITICAL(&show->lock);
+    show->stats.frames++;
+    if (buffered < show->stats.min_buffered) {
+        show->stats.min_buffered = buffered;
+    }
+    portEXIT_CRITICAL(&show->lock);
+
+    return status;
+}
+
+void hd108_show_get_stats(void *show_in, hd108_show_stats_t *stats_out) {
+    // cast player
+    hd108_show_t *show = show_in;
+
+    portENTER_CRITICAL(&show->lock);
+    *stats_out = show->stats;
+    portEXIT_CRITICAL(&show->lock);
+    stats_out->buffered = __atomic_load_n(&show->buffered, __ATOMIC_RELAXED);
+    if (UINT32_MAX == stats_out->min_buffered) {
+        stats_out->min_buffered = stats_out->buffered;
+    }
+}
+
+void hd108_show_close(void *show_in) {
+    // cast player
+    hd108_show_t *show = show_in;
+    uint8_t wake = HD108_SHOW_NO_BLOCK;
+
+    // the free queue has a spare slot for the wake-up
+    show->stop = true;
+    (void)xQueueSend(show->free_blocks, &wake, portMAX_DELAY);
+    (void)xSemaphoreTake(show->done, portMAX_DELAY);
+
+    hd108_show_free(show);
+}
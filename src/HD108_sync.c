@@ -0,0 +1,268 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "HD108_sync.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_SYNC_TASK_STACK       (    4096UL)    ///< stack size of the sync task, it runs the update function
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief Sync variable.
+ */
+typedef struct {
+    portMUX_TYPE        lock;           ///< Protects the statistics and the state shared with the interrupt
+    void               *ctx;            ///< The address of the context
+    uint8_t             divider;        ///< Every divider-th edge starts a frame
+    uint8_t             edges;          ///< Edges since the last frame start
+    uint32_t            delay;          ///< Delay of the frame start in microseconds
+    bool                busy;           ///< A frame has been triggered and its update is not done yet
+    int64_t             edge_time;      ///< Time of the edge that triggered the pending frame
+    int64_t             last_start;     ///< Transfer start of the previous frame, 0 before the first one
+    hd108_sync_stats_t  stats;          ///< Statistics
+    TaskHandle_t        task;           ///< Sync task
+    uint8_t             pin;            ///< Sync input PIN number
+    SemaphoreHandle_t   done;           ///< Given by the sync task when it stops
+    volatile bool       stop;           ///< Request to stop the sync task
+} hd108_sync_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static void         hd108_sync_isr          (void *arg);
+static void         hd108_sync_task         (void *arg);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Sync input interrupt.
+ *
+ * @note It takes the time stamp of the edge and wakes the task. Edges that
+ *       come while the previous update is running are counted as missed.
+ *
+ * @param arg The address of the sync.
+ */
+static void IRAM_ATTR hd108_sync_isr(void *arg) {
+    hd108_sync_t *sync = arg;
+    BaseType_t woken = pdFALSE;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&sync->lock);
+    bool trigger = (++sync->edges >= sync->divider);
+    if (trigger) {
+        sync->edges = 0;
+        if (sync->busy) {
+            sync->stats.missed++;
+            trigger = false;
+        } else {
+            sync->busy = true;
+            sync->edge_time = now;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&sync->lock);
+
+    if (trigger) {
+        vTaskNotifyGiveFromISR(sync->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+
+/**
+ * @brief Sync task.
+ *
+ * @param arg The address of the sync.
+ */
+static void hd108_sync_task(void *arg) {
+    hd108_sync_t *sync = arg;
+
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (sync->stop) {
+            break;
+        }
+
+        portENTER_CRITICAL(&sync->lock);
+        int64_t target = sync->edge_time + sync->delay;
+        portEXIT_CRITICAL(&sync->lock);
+
+        // sleep the whole ticks of the delay, spin the rest
+        int64_t remaining = target - esp_timer_get_time();
+        if (remaining > 2 * portTICK_PERIOD_MS * 1000LL) {
+            vTaskDelay((TickType_t)(remaining / (portTICK_PERIOD_MS * 1000LL)) - 1);
+        }
+        while (esp_timer_get_time() < target) {
+        }
+
+        // send the frame rendered after the previous sync, then render the next one
+        (void)hd108_lld_update(sync->ctx);
+
+        // the phase is measured at the start of the transfer on the bus,
+        // a frame without changes is not sent with dirty tracking
+        int64_t start;
+        (void)hd108_lld_get_transfer_start(sync->ctx, &start);
+
+        portENTER_CRITICAL(&sync->lock);
+        sync->stats.syncs++;
+        if (0 != start) {
+            int32_t phase = (int32_t)(start - target);
+            uint32_t phase_abs = (phase < 0) ? (uint32_t)-phase : (uint32_t)phase;
+            sync->stats.phase_error_us = phase;
+            if (phase_abs > sync->stats.phase_error_max_us) {
+                sync->stats.phase_error_max_us = phase_abs;
+            }
+            if (0 != sync->last_start) {
+                sync->stats.period_us = (uint32_t)(start - sync->last_start);
+            }
+            sync->last_start = start;
+        }
+        sync->busy = false;
+        portEXIT_CRITICAL(&sync->lock);
+    }
+
+    xSemaphoreGive(sync->done);
+    vTaskDelete(NULL);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_sync_init(const hd108_sync_configuration_t *sync_configuration, void **sync_out) {
+    static const gpio_int_type_t intr_type[] = {
+        [HD108_SYNC_EDGE_RISING] = GPIO_INTR_POSEDGE,
+        [HD108_SYNC_EDGE_FALLING] = GPIO_INTR_NEGEDGE,
+        [HD108_SYNC_EDGE_ANY] = GPIO_INTR_ANYEDGE
+    };
+
+    // check configuration
+    if ((NULL == sync_configuration->ctx) || (HD108_SYNC_EDGE_ANY < sync_configuration->edge) ||
+        !GPIO_IS_VALID_GPIO(sync_configuration->pin_sync)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for sync
+    hd108_sync_t *sync = (hd108_sync_t *)calloc(1, sizeof(hd108_sync_t));
+    if (!sync) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    sync->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    sync->ctx = sync_configuration->ctx;
+    sync->divider = (0 == sync_configuration->divider) ? 1 : sync_configuration->divider;
+    sync->delay = sync_configuration->delay_us;
+    sync->pin = sync_configuration->pin_sync;
+
+    sync->done = xSemaphoreCreateBinary();
+    if (!sync->done) {
+        free(sync);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+    // the dedicated GPIO bundle of the context belongs to the core of the init
+    if (pdPASS != xTaskCreatePinnedToCore(hd108_sync_task, "hd108_sync", HD108_SYNC_TASK_STACK, sync,
+                                          sync_configuration->task_priority, &sync->task, xPortGetCoreID())) {
+        vSemaphoreDelete(sync->done);
+        free(sync);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // sync input, the ISR service may be installed by the application already
+    gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << sync_configuration->pin_sync,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = intr_type[sync_configuration->edge]
+    };
+    esp_err_t err = gpio_install_isr_service(0);
+    if (((ESP_OK != err) && (ESP_ERR_INVALID_STATE != err)) ||
+        (ESP_OK != gpio_config(&io_config)) ||
+        (ESP_OK != gpio_isr_handler_add(sync_configuration->pin_sync, hd108_sync_isr, sync))) {
+        vTaskDelete(sync->task);
+        vSemaphoreDelete(sync->done);
+        free(sync);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // set out parameter
+    *sync_out = sync;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_sync_get_stats(void *sync_in, hd108_sync_stats_t *stats_out) {
+    // cast sync
+    hd108_sync_t *sync = sync_in;
+
+    portENTER_CRITICAL(&sync->lock);
+    *stats_out = sync->stats;
+    portEXIT_CRITICAL(&sync->lock);
+
+    return HD108_LLD_OK;
+}
+
+void hd108_sync_deinit(void *sync_in) {
+    // cast sync
+    hd108_sync_t *sync = sync_in;
+
+    // no edge wakes the task from now on
+    (void)gpio_set_intr_type(sync->pin, GPIO_INTR_DISABLE);
+    (void)gpio_isr_handler_remove(sync->pin);
+
+    // the task stops after the update in flight
+    sync->stop = true;
+    (void)xTaskNotifyGive(sync->task);
+    (void)xSemaphoreTake(sync->done, portMAX_DELAY);
+
+    vSemaphoreDelete(sync->done);
+    free(sync);
+}
@@ -0,0 +1,94 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+#include "esp_attr.h"
+#include "HD108_trace.h"
+#if CONFIG_HD108_TRACE
+#include "SEGGER_SYSVIEW.h"
+#endif
+
+
+#if CONFIG_HD108_TRACE
+/******************************************************************************
+ * Variables
+ *****************************************************************************/
+/**
+ * @brief SystemView module of the events.
+ */
+static SEGGER_SYSVIEW_MODULE hd108_trace_module = {
+    .sModule = "M=HD108, "
+               "0 Timer ctx=%x, "
+               "1 Queue ctx=%x, "
+               "2 DMA_Start ctx=%x, "
+               "3 DMA_Done ctx=%x, "
+               "4 Render_Start ctx=%x, "
+               "5 Render_End ctx=%x, "
+               "6 Encode_Start ctx=%x, "
+               "7 Encode_End ctx=%x, "
+               "8 Swap ctx=%x",
+    .NumEvents = HD108_TRACE_EVENT_COUNT,
+    .EventOffset = 0,
+    .pfSendModuleDesc = NULL,
+    .pNext = NULL
+};
+
+
+/**
+ * @brief The module has been registered.
+ */
+static bool hd108_trace_registered;
+#endif
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+void hd108_trace_init(void) {
+#if CONFIG_HD108_TRACE
+    if (!hd108_trace_registered) {
+        hd108_trace_registered = true;
+        SEGGER_SYSVIEW_RegisterModule(&hd108_trace_module);
+    }
+#endif
+}
+
+void IRAM_ATTR hd108_trace_event(hd108_trace_event_t event, const void *ctx) {
+#if CONFIG_HD108_TRACE
+    SEGGER_SYSVIEW_RecordU32(hd108_trace_module.EventOffset + event, (uint32_t)(uintptr_t)ctx);
+#else
+    (void)event;
+    (void)ctx;
+#endif
+}
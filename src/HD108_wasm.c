@@ -0,0 +1,224 @@
+/*
+ * HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2022 Zsolt Albert
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "wasm3.h"
+#include "HD108_wasm.h"
+
+
+/******************************************************************************
+ * Configuration
+ *****************************************************************************/
+#define HD108_WASM_STACK_SIZE       (CONFIG_HD108_WASM_STACK_SIZE)  ///< operand stack of the runtime in bytes
+#define HD108_WASM_PIXEL_SIZE       (       6UL)    ///< size of an RGB48 pixel in the linear memory
+
+
+/******************************************************************************
+ * Typedefs
+ *****************************************************************************/
+/**
+ * @brief WebAssembly effect variable.
+ */
+typedef struct {
+    void               *ctx;            ///< The address of the context
+    uint16_t            count;          ///< Number of pixels rendered by the module
+    uint16_t            current;        ///< Current levels of the rendered pixels
+    IM3Environment      env;            ///< wasm3 environment
+    IM3Runtime          runtime;        ///< wasm3 runtime, owns the module
+    IM3Function         render;         ///< Export hd108_render
+    uint32_t            buffer;         ///< Offset of the pixels in the linear memory
+    uint32_t            frame;          ///< Number of the next frame
+    portMUX_TYPE        lock;           ///< Protects the statistics
+    hd108_wasm_stats_t  stats;          ///< Statistics of the render calls
+} hd108_wasm_t;
+
+
+/******************************************************************************
+ * Prototypes
+ *****************************************************************************/
+static const uint16_t *hd108_wasm_pixels    (hd108_wasm_t *wasm);
+
+
+/******************************************************************************
+ * Function implementation
+ *****************************************************************************/
+
+
+/**
+ * @brief Address of the pixels.
+ *
+ * @note The module may grow the linear memory, so it is looked up after
+ *       every call and the buffer is checked against the current size.
+ *
+ * @param wasm The address of the effect.
+ *
+ * @return
+ *         - The address of the pixels, NULL if the buffer is out of the linear memory.
+ */
+static const uint16_t *hd108_wasm_pixels(hd108_wasm_t *wasm) {
+    uint32_t size = 0;
+    uint8_t *memory = m3_GetMemory(wasm->runtime, &size, 0);
+
+    if ((NULL == memory) || (wasm->buffer > size) || (HD108_WASM_PIXEL_SIZE * wasm->count > size - wasm->buffer)) {
+        return NULL;
+    }
+
+    return (const uint16_t *)(memory + wasm->buffer);
+}
+
+
+/******************************************************************************
+ * Interface functions
+ *
+ * Interface function documentation can be found in the header file!
+ *****************************************************************************/
+hd108_status_t hd108_wasm_init(const hd108_wasm_configuration_t *wasm_configuration, void **wasm_out) {
+    IM3Module module = NULL;
+    IM3Function buffer = NULL;
+    uint32_t offset = 0;
+
+    // check configuration
+    if ((NULL == wasm_configuration->ctx) || (NULL == wasm_configuration->module) || (0 == wasm_configuration->module_len) ||
+        (0 == wasm_configuration->count)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // allocate memory for effect
+    hd108_wasm_t *wasm = (hd108_wasm_t *)calloc(1, sizeof(hd108_wasm_t));
+    if (!wasm) {
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    wasm->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    wasm->ctx = wasm_configuration->ctx;
+    wasm->count = wasm_configuration->count;
+    wasm->current = wasm_configuration->current;
+
+    wasm->env = m3_NewEnvironment();
+    if (NULL != wasm->env) {
+        wasm->runtime = m3_NewRuntime(wasm->env, HD108_WASM_STACK_SIZE, NULL);
+    }
+    if (NULL == wasm->runtime) {
+        hd108_wasm_deinit(wasm);
+        return HD108_LLD_ERROR_NO_MEMORY;
+    }
+
+    // the runtime owns the module once it is loaded
+    if (NULL != m3_ParseModule(wasm->env, &module, wasm_configuration->module, wasm_configuration->module_len)) {
+        hd108_wasm_deinit(wasm);
+        return HD108_LLD_ERROR_INVALID;
+    }
+    if (NULL != m3_LoadModule(wasm->runtime, module)) {
+        m3_FreeModule(module);
+        hd108_wasm_deinit(wasm);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    if ((NULL != m3_FindFunction(&buffer, wasm->runtime, "hd108_buffer")) ||
+        (NULL != m3_FindFunction(&wasm->render, wasm->runtime, "hd108_render")) ||
+        (NULL != m3_CallV(buffer, (uint32_t)wasm->count)) ||
+        (NULL != m3_GetResultsV(buffer, &offset))) {
+        hd108_wasm_deinit(wasm);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    wasm->buffer = offset;
+    if ((0 != (offset & 1U)) || (NULL == hd108_wasm_pixels(wasm))) {
+        hd108_wasm_deinit(wasm);
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    // set out parameter
+    *wasm_out = wasm;
+
+    return HD108_LLD_OK;
+}
+
+hd108_status_t hd108_wasm_render(void *wasm_in) {
+    // cast effect
+    hd108_wasm_t *wasm = wasm_in;
+
+    int64_t start = esp_timer_get_time();
+    if (NULL != m3_CallV(wasm->render, wasm->frame, (uint32_t)(start / 1000), (uint32_t)0, (uint32_t)wasm->count)) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+    wasm->frame++;
+    int64_t rendered = esp_timer_get_time();
+
+    const uint16_t *pixels = hd108_wasm_pixels(wasm);
+    if (NULL == pixels) {
+        return HD108_LLD_ERROR_INVALID;
+    }
+
+    hd108_status_t status = hd108_lld_write_rgb48(wasm->ctx, 0, wasm->count, pixels, wasm->current);
+
+    // the interpreter and the encoding are reported separately
+    uint32_t render_us = (uint32_t)(rendered - start);
+    uint32_t write_us = (uint32_t)(esp_timer_get_time() - rendered);
+    portENTER_CRITICAL(&wasm->lock);
+    wasm->stats.frames++;
+    wasm->stats.render_us = render_us;
+    if (render_us > wasm->stats.render_max_us) {
+        wasm->stats.render_max_us = render_us;
+    }
+    wasm->stats.write_us = write_us;
+    portEXIT_CRITICAL(&wasm->lock);
+
+    return status;
+}
+
+hd108_status_t hd108_wasm_get_stats(void *wasm_in, hd108_wasm_stats_t *stats_out) {
+    // cast effect
+    hd108_wasm_t *wasm = wasm_in;
+
+    portENTER_CRITICAL(&wasm->lock);
+    *stats_out = wasm->stats;
+    portEXIT_CRITICAL(&wasm->lock);
+
+    return HD108_LLD_OK;
+}
+
+void hd108_wasm_deinit(void *wasm_in) {
+    // cast effect
+    hd108_wasm_t *wasm = wasm_in;
+
+    if (NULL != wasm->runtime) {
+        m3_FreeRuntime(wasm->runtime);
+    }
+    if (NULL != wasm->env) {
+        m3_FreeEnvironment(wasm->env);
+    }
+    free(wasm);
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+#
+# MIT License
+#
+# Copyright (c) 2022 Zsolt Albert
+#
+"""Pack LED coordinates into the blob used by HD108_map3d.
+
+The input is a CSV file with one "x,y,z" line per LED, in LED order. Empty
+lines and lines starting with '#' are skipped. The coordinates are quantized
+to int16 within their bounding box and stored as x, y and z planes after the
+header described by hd108_map3d_header_t.
+
+Flash the blob into a data partition, e.g.:
+
+    hd108_map3d_pack.py leds.csv leds.bin
+    parttool.py write_partition --partition-name=leds --input=leds.bin
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = 0x44334448          # "HD3D"
+VERSION = 1
+MAX_COUNT = 1024            # HD108_LLD_MAX_COUNT
+
+
+def read_points(path):
+    points = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or row[0].strip().startswith("#"):
+                continue
+            points.append(tuple(float(v) for v in row[:3]))
+    return points
+
+
+def pack(points):
+    origin = []
+    scale = []
+    for axis in range(3):
+        values = [p[axis] for p in points]
+        low, high = min(values), max(values)
+        origin.append((low + high) / 2.0)
+        # half extent, slightly enlarged so the maximum maps below 32768
+        scale.append(max((high - low) / 2.0, 1e-9) * 32768.0 / 32767.0)
+
+    planes = []
+    for axis in range(3):
+        plane = [int(round((p[axis] - origin[axis]) / scale[axis] * 32768.0)) for p in points]
+        planes.append([min(max(q, -32768), 32767) for q in plane])
+
+    blob = struct.pack("<IHH3f3f", MAGIC, VERSION, len(points), *origin, *scale)
+    for plane in planes:
+        blob += struct.pack("<%dh" % len(plane), *plane)
+    return blob
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="CSV file with one x,y,z line per LED")
+    parser.add_argument("output", help="coordinate blob")
+    args = parser.parse_args()
+
+    points = read_points(args.input)
+    if not 1 <= len(points) <= MAX_COUNT:
+        sys.exit("number of LEDs shall be in range [1 .. %d], got %d" % (MAX_COUNT, len(points)))
+
+    with open(args.output, "wb") as f:
+        f.write(pack(points))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# HD108 Smart LED (strip) Low Level Driver for ESP-IDF
+#
+# MIT License
+#
+# Copyright (c) 2022 Zsolt Albert
+#
+"""Pack raw RGB888 frames into the show file played by HD108_show.
+
+The input is a file of frames, each frame is count RGB888 pixels (3 bytes
+per pixel, in LED order). The output starts with the header described by
+hd108_show_header_t, followed by the frames either raw or run-length encoded.
+
+Copy the show file to the SD card or file system image, e.g.:
+
+    hd108_show_pack.py --count 300 --fps 60 --rle frames.rgb show.bin
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = 0x53314448          # "HD1S"
+VERSION = 1
+FORMAT_RAW = 0
+FORMAT_RLE = 1
+MAX_COUNT = 1024            # HD108_LLD_MAX_COUNT
+
+
+def rle(frame):
+    pixels = [frame[i:i + 3] for i in range(0, len(frame), 3)]
+    out = bytearray()
+    literal = []
+
+    def flush():
+        while literal:
+            chunk = literal[:128]
+            del literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(b"".join(chunk))
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and run < 130 and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 3:
+            flush()
+            out.append(run + 125)
+            out.extend(pixels[i])
+        else:
+            literal.extend(pixels[i:i + run])
+        i += run
+    flush()
+    return struct.pack("<I", len(out)) + out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--count", type=int, required=True, help="number of pixels in one frame")
+    parser.add_argument("--fps", type=float, required=True, help="frame rate of the show")
+    parser.add_argument("--rle", action="store_true", help="run-length encode the frames")
+    parser.add_argument("input", help="raw RGB888 frames")
+    parser.add_argument("output", help="show file")
+    args = parser.parse_args()
+
+    if not 1 <= args.count <= MAX_COUNT:
+        sys.exit("number of pixels shall be in range [1 .. %d], got %d" % (MAX_COUNT, args.count))
+
+    size = 3 * args.count
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if not data or len(data) % size:
+        sys.exit("input length shall be a non-zero multiple of %d bytes" % size)
+
+    frame_format = FORMAT_RLE if args.rle else FORMAT_RAW
+    header = struct.pack("<IHHB3xI", MAGIC, VERSION, args.count, frame_format, int(round(1e6 / args.fps)))
+    with open(args.output, "wb") as f:
+        f.write(header)
+        for i in range(0, len(data), size):
+            frame = data[i:i + size]
+            f.write(rle(frame) if args.rle else frame)
+
+
+if __name__ == "__main__":
+    main()